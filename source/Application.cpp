@@ -31,6 +31,9 @@ SOFTWARE.
 
 #include "renderer\passes\GuiPass.h"
 #include "utility\Status.h"
+#include "utility\InputRecording.h"
+#include "utility\Profiler.h"
+#include "fileIO\BinaryExport.h"
 
 class ParticleSystemManager;
 
@@ -65,6 +68,9 @@ bool Application::Init()
 void Application::Release()
 {
   sceneRenderer_.Release();
+  InputRecording::Stop();
+  //Exports are written in the background and would be truncated on exit
+  FileIO::BinaryWriter::WaitForPendingWrites();
 
   int i;
   std::cin >> i;
@@ -82,16 +88,21 @@ void Application::Run()
     }
     else
     {
+      Profiler::BeginFrame();
+      PROFILE_SCOPE("Frame");
       timer_.Tick();
       inputHandler_.ProcessInput();
       Renderer::GuiPass::HandleInput(&inputHandler_);
+      float deltaTime = timer_.GetDeltaTime();
+      InputRecording::BeginFrame(scene_.get(), deltaTime);
       if (active_)
       {
-        scene_->Update(&inputHandler_, timer_.GetDeltaTime());
+        scene_->Update(InputRecording::IsReplaying() ? nullptr : &inputHandler_, deltaTime);
       }
+      InputRecording::UpdateInputs(scene_.get());
 
-      sceneRenderer_.Update(scene_.get(), timer_.GetDeltaTime());
-      sceneRenderer_.Render(scene_.get());
+      sceneRenderer_.Update(scene_.get(), deltaTime);
+      sceneRenderer_.Render(scene_.get(), InputRecording::IsHeadlessReplay());
 
       HandleUIChanges();
 
@@ -186,6 +197,34 @@ void Application::HandleUIChanges()
   {
     Status::Save();
   }
+  if (menuState.startInputRecording)
+  {
+    const std::string path = FileIO::SaveFileDialog(L"vrec");
+    if (!path.empty())
+    {
+      InputRecording::StartRecording(path);
+    }
+  }
+  if (menuState.stopInputRecording)
+  {
+    InputRecording::Stop();
+  }
+  if (menuState.replayInputRecording || menuState.replayInputRecordingHeadless)
+  {
+    const std::string path = FileIO::OpenFileDialog(L"vrec");
+    if (!path.empty())
+    {
+      InputRecording::StartReplay(path, menuState.replayInputRecordingHeadless);
+    }
+  }
+  if (menuState.captureProfile)
+  {
+    const std::string path = FileIO::SaveFileDialog(L"json");
+    if (!path.empty())
+    {
+      Profiler::StartCapture(path, menuState.queryFrameCount);
+    }
+  }
 }
 
 void Application::OnResize()
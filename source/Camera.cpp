@@ -88,6 +88,18 @@ void Camera::UpdateView(InputHandler* input, float dt)
 	Status::UpdateCameraState(this);
 }
 
+void Camera::SetView(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& right)
+{
+  position_ = position;
+  forward_ = forward;
+  right_ = right;
+
+  view_ = lookAt(position_, position_ + forward_, up_);
+  viewProj_ = proj_ * view_;
+
+  Status::UpdateCameraState(this);
+}
+
 void Camera::UpdateProj(int width, int height)
 {
   const glm::mat4 clip(1.0f, 0.0f, 0.0f, 0.0f,
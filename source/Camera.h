@@ -34,6 +34,8 @@ public:
 
   void UpdateView(InputHandler* input, float dt);
   void UpdateProj(int width, int height);
+  //Sets the view directly, used to replay recorded camera movement
+  void SetView(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& right);
 
   const glm::mat4x4& GetView() const;
   const glm::mat4x4& GetProj() const;
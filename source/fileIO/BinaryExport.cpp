@@ -0,0 +1,302 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "BinaryExport.h"
+
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+
+#ifdef VOLUME_EXPORT_ZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t exportMagic = 0x58455056;		//VPEX
+	constexpr uint32_t exportVersion = 1;
+	constexpr size_t chunkSize = 1 << 20;
+	//Limits the memory of chunks which are not written yet, the caller waits if it is reached
+	constexpr size_t maxQueuedChunks = 8;
+	constexpr int compressionLevel = 3;
+
+	std::atomic<int> pendingWriters{ 0 };
+}
+
+namespace FileIO
+{
+	struct BinaryWriter::State
+	{
+		std::ofstream file;
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<std::vector<char>> chunks;
+		bool closed = false;
+		bool compressed = false;
+		//Set if a chunk could not be compressed, the remaining chunks are still taken but discarded
+		bool failed = false;
+		std::string path;
+
+		void WriteChunks();
+	};
+
+	void BinaryWriter::State::WriteChunks()
+	{
+		std::vector<char> compressedChunk;
+		while (true)
+		{
+			std::vector<char> chunk;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this]() { return closed || !chunks.empty(); });
+				if (chunks.empty())
+				{
+					break;
+				}
+				chunk = std::move(chunks.front());
+				chunks.pop_front();
+			}
+			condition.notify_all();
+			if (failed)
+			{
+				continue;
+			}
+
+			ChunkHeader header = { static_cast<uint32_t>(chunk.size()), static_cast<uint32_t>(chunk.size()) };
+			const char* storedData = chunk.data();
+#ifdef VOLUME_EXPORT_ZSTD
+			if (compressed)
+			{
+				compressedChunk.resize(ZSTD_compressBound(chunk.size()));
+				const size_t result = ZSTD_compress(compressedChunk.data(), compressedChunk.size(),
+					chunk.data(), chunk.size(), compressionLevel);
+				if (ZSTD_isError(result))
+				{
+					printf("Compressing export chunk failed, %s\n", ZSTD_getErrorName(result));
+					failed = true;
+					continue;
+				}
+				header.storedSize = static_cast<uint32_t>(result);
+				storedData = compressedChunk.data();
+			}
+#endif
+			file.write(reinterpret_cast<const char*>(&header), sizeof(ChunkHeader));
+			file.write(storedData, header.storedSize);
+		}
+		file.close();
+		if (failed)
+		{
+			printf("Export file %s is incomplete\n", path.c_str());
+		}
+		--pendingWriters;
+	}
+
+	BinaryWriter::BinaryWriter()
+	{}
+
+	BinaryWriter::~BinaryWriter()
+	{
+		Close();
+	}
+
+	bool BinaryWriter::Open(const std::string& path, ExportType type)
+	{
+		Close();
+
+		state_ = std::make_shared<State>();
+		state_->path = path;
+		state_->file.open(path.c_str(), std::ios::out | std::ios::binary);
+		if (!state_->file)
+		{
+			printf("Unable to open export file %s\n", path.c_str());
+			state_.reset();
+			return false;
+		}
+#ifdef VOLUME_EXPORT_ZSTD
+		state_->compressed = true;
+#endif
+		const ExportHeader header = { exportMagic, exportVersion, type, state_->compressed ? 1u : 0u };
+		state_->file.write(reinterpret_cast<const char*>(&header), sizeof(ExportHeader));
+
+		++pendingWriters;
+		std::thread(&State::WriteChunks, state_).detach();
+		chunk_.reserve(chunkSize);
+		return true;
+	}
+
+	void BinaryWriter::Write(const void* data, size_t size)
+	{
+		if (state_ == nullptr)
+		{
+			return;
+		}
+
+		const char* bytes = static_cast<const char*>(data);
+		while (size > 0)
+		{
+			const size_t copySize = std::min(size, chunkSize - chunk_.size());
+			chunk_.insert(chunk_.end(), bytes, bytes + copySize);
+			bytes += copySize;
+			size -= copySize;
+			if (chunk_.size() == chunkSize)
+			{
+				PushChunk();
+			}
+		}
+	}
+
+	void BinaryWriter::PushChunk()
+	{
+		{
+			std::unique_lock<std::mutex> lock(state_->mutex);
+			state_->condition.wait(lock, [this]() { return state_->chunks.size() < maxQueuedChunks; });
+			state_->chunks.push_back(std::move(chunk_));
+		}
+		state_->condition.notify_all();
+		chunk_ = std::vector<char>();
+		chunk_.reserve(chunkSize);
+	}
+
+	void BinaryWriter::Close()
+	{
+		if (state_ == nullptr)
+		{
+			return;
+		}
+
+		if (!chunk_.empty())
+		{
+			PushChunk();
+		}
+		{
+			std::lock_guard<std::mutex> lock(state_->mutex);
+			state_->closed = true;
+		}
+		state_->condition.notify_all();
+		//The background thread keeps the state alive until the file is written
+		state_.reset();
+		chunk_.clear();
+	}
+
+	void BinaryWriter::WaitForPendingWrites()
+	{
+		while (pendingWriters > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	void BinaryWriter::PrintConverterCommand(const std::string& exportPath, const std::string& pbrtPath)
+	{
+		printf("Run Export-Converter \"%s\" \"%s\" to create the included pbrt file\n", 
+			exportPath.c_str(), pbrtPath.c_str());
+	}
+
+	bool BinaryReader::Open(const std::string& path)
+	{
+		file_ = std::make_unique<std::ifstream>(path.c_str(), std::ios::in | std::ios::binary);
+		if (!*file_)
+		{
+			printf("Unable to open export file %s\n", path.c_str());
+			return false;
+		}
+
+		file_->read(reinterpret_cast<char*>(&header_), sizeof(ExportHeader));
+		if (!*file_ || header_.magic != exportMagic || header_.version != exportVersion || header_.type >= EXPORT_MAX)
+		{
+			printf("Invalid export file %s\n", path.c_str());
+			return false;
+		}
+#ifndef VOLUME_EXPORT_ZSTD
+		if (header_.compressed != 0)
+		{
+			printf("Export file %s is compressed, build with VOLUME_EXPORT_ZSTD to read it\n", path.c_str());
+			return false;
+		}
+#endif
+		chunk_.clear();
+		chunkOffset_ = 0;
+		return true;
+	}
+
+	bool BinaryReader::ReadChunk()
+	{
+		ChunkHeader header;
+		file_->read(reinterpret_cast<char*>(&header), sizeof(ChunkHeader));
+		if (!*file_)
+		{
+			return false;
+		}
+
+		std::vector<char> storedData(header.storedSize);
+		file_->read(storedData.data(), header.storedSize);
+		if (!*file_)
+		{
+			return false;
+		}
+
+		chunkOffset_ = 0;
+		if (header_.compressed == 0)
+		{
+			chunk_ = std::move(storedData);
+			return true;
+		}
+#ifdef VOLUME_EXPORT_ZSTD
+		chunk_.resize(header.rawSize);
+		const size_t result = ZSTD_decompress(chunk_.data(), chunk_.size(), storedData.data(), storedData.size());
+		if (ZSTD_isError(result) || result != header.rawSize)
+		{
+			printf("Decompressing export chunk failed\n");
+			return false;
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool BinaryReader::Read(void* data, size_t size)
+	{
+		char* bytes = static_cast<char*>(data);
+		while (size > 0)
+		{
+			if (chunkOffset_ == chunk_.size() && !ReadChunk())
+			{
+				return false;
+			}
+			const size_t copySize = std::min(size, chunk_.size() - chunkOffset_);
+			memcpy(bytes, chunk_.data() + chunkOffset_, copySize);
+			chunkOffset_ += copySize;
+			bytes += copySize;
+			size -= copySize;
+		}
+		return true;
+	}
+}
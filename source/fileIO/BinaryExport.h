@@ -0,0 +1,131 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <cstdint>
+
+namespace FileIO
+{
+	enum ExportType : uint32_t
+	{
+		EXPORT_FOG_VOLUME,
+		EXPORT_PARTICLES,
+		EXPORT_INPUT_RECORDING,		//per frame inputs written by the InputRecording
+		EXPORT_MAX
+	};
+
+	//Start of each export file, followed by chunks with a ChunkHeader
+	struct ExportHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		ExportType type;
+		uint32_t compressed;		//1 if the chunks are compressed with zstd
+	};
+
+	struct ChunkHeader
+	{
+		uint32_t rawSize;
+		uint32_t storedSize;
+	};
+
+	//Positions are already transformed into pbrt space with y pos up
+	//Followed by nx * ny * nz density values
+	struct FogVolumeInfo
+	{
+		char mediumName[64];
+		float absorption;
+		float scattering;
+		float phaseG;
+		float p0[3];
+		float p1[3];
+		uint32_t nx;
+		uint32_t ny;
+		uint32_t nz;
+	};
+
+	//Followed by count * ParticleSphere
+	struct ParticlesInfo
+	{
+		char mediumName[64];
+		uint32_t count;
+	};
+
+	struct ParticleSphere
+	{
+		float position[3];
+		float radius;
+	};
+
+	//Streams data into chunks which are compressed and written to disk on a background thread
+	//The caller only copies the data into the chunks, closing does not wait for the file
+	class BinaryWriter
+	{
+	public:
+		BinaryWriter();
+		~BinaryWriter();
+		bool Open(const std::string& path, ExportType type);
+		//Copies the data, the size is not limited by the chunk size
+		void Write(const void* data, size_t size);
+		template<typename T>
+		void Write(const T& value) { Write(&value, sizeof(T)); }
+		//Hands the remaining data to the background thread which closes the file when it is done
+		void Close();
+
+		//Blocks until all closed writers finished, called before the application exits
+		static void WaitForPendingWrites();
+		//The pbrt file included by the saved scene only exists after the export converter was run
+		static void PrintConverterCommand(const std::string& exportPath, const std::string& pbrtPath);
+	private:
+		struct State;
+		void PushChunk();
+
+		std::shared_ptr<State> state_;
+		std::vector<char> chunk_;
+	};
+
+	//Reads the chunks of an export file sequentially
+	class BinaryReader
+	{
+	public:
+		bool Open(const std::string& path);
+		ExportType GetType() const { return header_.type; }
+		//False if the file ended before size bytes were read
+		bool Read(void* data, size_t size);
+		template<typename T>
+		bool Read(T& value) { return Read(&value, sizeof(T)); }
+	private:
+		bool ReadChunk();
+
+		std::unique_ptr<std::ifstream> file_;
+		ExportHeader header_ = {};
+		std::vector<char> chunk_;
+		size_t chunkOffset_ = 0;
+	};
+}
@@ -0,0 +1,191 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "GridSnapshot.h"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t snapshotMagic = 0x4E534756;		//VGSN
+	constexpr uint32_t snapshotVersion = 1;
+
+	uint64_t AlignOffset(uint64_t offset)
+	{
+		return (offset + FileIO::snapshotAlignment - 1) / FileIO::snapshotAlignment * FileIO::snapshotAlignment;
+	}
+}
+
+namespace FileIO
+{
+	bool SaveGridSnapshot(const std::string& path, const std::array<SnapshotData, SNAPSHOT_MAX>& sections,
+		uint32_t levelCount, uint32_t atlasSideLength, uint32_t atlasResolution)
+	{
+		std::ofstream file(path, std::ios::out | std::ios::binary);
+		if (!file)
+		{
+			printf("Unable to create grid snapshot %s\n", path.c_str());
+			return false;
+		}
+
+		SnapshotHeader header = {};
+		header.magic = snapshotMagic;
+		header.version = snapshotVersion;
+		header.levelCount = levelCount;
+		header.atlasSideLength = atlasSideLength;
+		header.atlasResolution = atlasResolution;
+		uint64_t offset = AlignOffset(sizeof(SnapshotHeader));
+		for (int i = 0; i < SNAPSHOT_MAX; ++i)
+		{
+			header.sections[i] = { offset, sections[i].size };
+			offset = AlignOffset(offset + sections[i].size);
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(SnapshotHeader));
+
+		const std::vector<char> padding(snapshotAlignment, 0);
+		uint64_t written = sizeof(SnapshotHeader);
+		for (int i = 0; i < SNAPSHOT_MAX; ++i)
+		{
+			file.write(padding.data(), header.sections[i].offset - written);
+			file.write(reinterpret_cast<const char*>(sections[i].data), sections[i].size);
+			written = header.sections[i].offset + sections[i].size;
+		}
+		file.write(padding.data(), offset - written);
+
+		if (!file)
+		{
+			printf("Failed writing grid snapshot %s\n", path.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	MappedGridSnapshot::~MappedGridSnapshot()
+	{
+		Close();
+	}
+
+	bool MappedGridSnapshot::Open(const std::string& path)
+	{
+		Close();
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			printf("Unable to open grid snapshot %s\n", path.c_str());
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(file, &fileSize);
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		const void* view = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		fileHandle_ = file;
+		mappingHandle_ = mapping;
+		fileSize_ = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+		const int file = open(path.c_str(), O_RDONLY);
+		if (file == -1)
+		{
+			printf("Unable to open grid snapshot %s\n", path.c_str());
+			return false;
+		}
+		struct stat fileStatus;
+		fstat(file, &fileStatus);
+		fileSize_ = static_cast<uint64_t>(fileStatus.st_size);
+		void* view = mmap(nullptr, fileSize_, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (view == MAP_FAILED)
+		{
+			view = nullptr;
+		}
+#endif
+		mapping_ = reinterpret_cast<const uint8_t*>(view);
+		if (mapping_ == nullptr)
+		{
+			printf("Unable to map grid snapshot %s\n", path.c_str());
+			Close();
+			return false;
+		}
+
+		//Validate the header and the section bounds, the content is used as is
+		bool valid = fileSize_ >= sizeof(SnapshotHeader) && 
+			GetHeader().magic == snapshotMagic && GetHeader().version == snapshotVersion;
+		for (int i = 0; valid && i < SNAPSHOT_MAX; ++i)
+		{
+			const auto& section = GetHeader().sections[i];
+			valid = section.offset % snapshotAlignment == 0 && section.offset + section.size <= fileSize_;
+		}
+		if (!valid)
+		{
+			printf("Invalid grid snapshot %s\n", path.c_str());
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void MappedGridSnapshot::Close()
+	{
+#ifdef _WIN32
+		if (mapping_ != nullptr)
+		{
+			UnmapViewOfFile(mapping_);
+		}
+		if (mappingHandle_ != nullptr)
+		{
+			CloseHandle(mappingHandle_);
+		}
+		if (fileHandle_ != nullptr)
+		{
+			CloseHandle(fileHandle_);
+		}
+#else
+		if (mapping_ != nullptr)
+		{
+			munmap(const_cast<uint8_t*>(mapping_), fileSize_);
+		}
+#endif
+		mapping_ = nullptr;
+		mappingHandle_ = nullptr;
+		fileHandle_ = nullptr;
+		fileSize_ = 0;
+	}
+
+	const void* MappedGridSnapshot::GetSection(SnapshotSection section) const
+	{
+		return mapping_ + GetHeader().sections[section].offset;
+	}
+}
@@ -0,0 +1,106 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <array>
+#include <cstdint>
+
+namespace FileIO
+{
+	enum SnapshotSection : uint32_t
+	{
+		SNAPSHOT_RAYMARCHING,		//RaymarchingData
+		SNAPSHOT_LEVELS,				//LevelData per level
+		SNAPSHOT_NODE_INFOS,
+		SNAPSHOT_ACTIVE_BITS,
+		SNAPSHOT_BIT_COUNTS,
+		SNAPSHOT_CHILDS,
+		SNAPSHOT_ATLAS,					//Image atlas as R16G16B16A16_SFLOAT texels, x fastest
+		SNAPSHOT_MAX
+	};
+
+	struct SnapshotSectionInfo
+	{
+		uint64_t offset;		//from the start of the file, aligned to snapshotAlignment
+		uint64_t size;
+	};
+
+	//Start of the file, the sections follow in the order of the enum
+	//The buffer sections contain the same bytes as the gpu buffers of the adaptive grid
+	struct SnapshotHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t levelCount;
+		uint32_t atlasSideLength;			//images per side
+		uint32_t atlasResolution;			//texels per side
+		uint32_t padding[3];
+		std::array<SnapshotSectionInfo, SNAPSHOT_MAX> sections;
+	};
+
+	//Sections start at page boundaries so they can be used in place after mapping the file
+	constexpr uint64_t snapshotAlignment = 4096;
+
+	struct SnapshotData
+	{
+		const void* data;
+		uint64_t size;
+	};
+
+	//Writes all sections with the header, levelCount and the atlas sizes are only stored for validation
+	bool SaveGridSnapshot(const std::string& path, const std::array<SnapshotData, SNAPSHOT_MAX>& sections,
+		uint32_t levelCount, uint32_t atlasSideLength, uint32_t atlasResolution);
+
+	//Maps a snapshot file read only, the sections point directly into the mapping
+	class MappedGridSnapshot
+	{
+	public:
+		MappedGridSnapshot() = default;
+		MappedGridSnapshot(const MappedGridSnapshot&) = delete;
+		MappedGridSnapshot& operator=(const MappedGridSnapshot&) = delete;
+		~MappedGridSnapshot();
+
+		bool Open(const std::string& path);
+		void Close();
+		bool IsOpen() const { return mapping_ != nullptr; }
+
+		const SnapshotHeader& GetHeader() const { return *reinterpret_cast<const SnapshotHeader*>(mapping_); }
+		const void* GetSection(SnapshotSection section) const;
+		uint64_t GetSectionSize(SnapshotSection section) const { return GetHeader().sections[section].size; }
+		//Number of elements of type T inside the section
+		template<typename T>
+		const T* GetElements(SnapshotSection section, size_t& count) const
+		{
+			count = static_cast<size_t>(GetSectionSize(section) / sizeof(T));
+			return reinterpret_cast<const T*>(GetSection(section));
+		}
+	private:
+		const uint8_t* mapping_ = nullptr;
+		uint64_t fileSize_ = 0;
+		void* fileHandle_ = nullptr;
+		void* mappingHandle_ = nullptr;
+	};
+}
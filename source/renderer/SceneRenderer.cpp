@@ -129,19 +129,26 @@ namespace Renderer
     bufferManager_->PerformCopies(&queueManager_);
   }
 
-  void SceneRenderer::Render(Scene* scene)
+  void SceneRenderer::Render(Scene* scene, bool headless)
   {
     const auto& device = instance_.GetDevice();
     const auto& physicalDevice = instance_.GetPhysicalDevice();
-    surface_.GetNextImage(device);
+    if (headless)
+    {
+      passManager_->RenderHeadless(device, &queueManager_, bufferManager_.get(), imageManager_.get(), &surface_, frameIndex_);
+    }
+    else
+    {
+      surface_.GetNextImage(device);
 
-    passManager_->Render(device, &queueManager_, bufferManager_.get(), imageManager_.get(), &surface_, frameIndex_);
+      passManager_->Render(device, &queueManager_, bufferManager_.get(), imageManager_.get(), &surface_, frameIndex_);
 
-    std::vector<VkSemaphore> signalSemaphores =
-    {
-      passManager_->GetPassFrameFinished()
-    };
-    surface_.Present(&queueManager_, signalSemaphores);
+      std::vector<VkSemaphore> signalSemaphores =
+      {
+        passManager_->GetPassFrameFinished()
+      };
+      surface_.Present(&queueManager_, signalSemaphores);
+    }
 
     vkQueueSubmit(queueManager_.GetQueue(QueueManager::QUEUE_GRAPHICS), 0, nullptr, frameFences_[frameIndex_]);
     frameIndex_ = (frameIndex_ + 1) % surface_.GetImageCount();
@@ -51,7 +51,8 @@ namespace Renderer
     void Release();
 
     void Update(Scene* scene, float deltaTime);
-    void Render(Scene* scene);
+    //Headless rendering skips the presentation, used to replay inputs without vsync
+    void Render(Scene* scene, bool headless);
 
     void OnReloadShaders();
     bool OnLoadScene(Scene* scene);
@@ -25,6 +25,8 @@ SOFTWARE.
 #include "ShadowMap.h"
 
 #include <glm\gtc\matrix_transform.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm\gtx\component_wise.hpp>
 
 #include "resources\ImageManager.h"
 #include "..\Camera.h"
@@ -77,6 +79,7 @@ namespace Renderer
   {
     if (GuiPass::GetMenuState().fixCameraFrustum)
     {
+      cascadeUpdated_.fill(false);
       return;
     }
 
@@ -93,6 +96,7 @@ namespace Renderer
     CalcViewProjections(camera, lightVector);
 
     CalcWorldFrustums(camera);
+    ++updateCount_;
   }
 
   void ShadowMap::BindViewportScissor(VkCommandBuffer commandBuffer)
@@ -186,56 +190,73 @@ namespace Renderer
   void ShadowMap::CalcViewProjections(const Camera* camera, const glm::vec3& lightVector)
   {
     debugBoundingBoxes_.clear();
-		for (int i = 0; i < cascadeCount_; ++i)
-		{
-			const glm::mat4x4 clip(1.0f, 0.0f, 0.0f, 0.0f,
-				+0.0f, -1.0f, 0.0f, 0.0f,
-				+0.0f, 0.0f, 0.5f, 0.0f,
-				+0.0f, 0.0f, 0.5f, 1.0f);
 
-			const float min = -testRadius[i];
-			const float max = testRadius[i];
+		const glm::mat4x4 clip(1.0f, 0.0f, 0.0f, 0.0f,
+			+0.0f, -1.0f, 0.0f, 0.0f,
+			+0.0f, 0.0f, 0.5f, 0.0f,
+			+0.0f, 0.0f, 0.5f, 1.0f);
+		const glm::mat4x4 toTexture(
+			0.5f, 0.0f, 0.0f, 0.0f,
+			0.0f, 0.5f, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			0.5f, 0.5f, 0.0f, 1.0f);
+
+		const bool cachingEnabled = GuiPass::GetLightingState().cacheShadowCascades;
+		const bool lightChanged = !cascadesValid_ || lightVector != cachedLightVector_;
+		//Only the rotation of the light, the translation is applied after snapping in light space
+		lightView_ = glm::lookAt(glm::vec3(0.0f), -lightVector, glm::vec3(0, -1, 0));
+		const auto& lightView = lightView_;
+		const float width = static_cast<float>(size_.width);
+		//Shadow casters between the light and the cascade are included up to the far plane
+		const float casterDistance = splitDistances_[cascadeCount_];
 
+		for (int i = 0; i < cascadeCount_; ++i)
+		{
 			cascadeCenterRadius_[i] = glm::vec4(testCenter[i], testRadius[i]);
 
-			glm::vec3 up = glm::normalize(glm::cross(-lightVector, glm::vec3(1.0f, 0.0f, 0.0f)));
-			glm::mat4 view = glm::translate(glm::mat4(1.0f), -testCenter[i]) * glm::lookAt(glm::vec3(0.0f), -lightVector, up);
+			//The radius is enlarged so the cascade still covers the split after moving by the threshold
+			const float radius = testRadius[i] * width / (width - 2.0f * cacheTexelThreshold);
+			const float texelSize = 2.0f * radius / width;
+			//Snapping to whole texels keeps the rasterization of static geometry stable
+			glm::vec3 center = glm::vec3(lightView * glm::vec4(testCenter[i], 1.0f));
+			center = glm::floor(center / texelSize) * texelSize;
 
-			if (i == 0)
+			const auto& cached = cachedCenterRadius_[i];
+			const bool moved = radius != cached.w ||
+				glm::compMax(glm::abs(center - glm::vec3(cached))) > cacheTexelThreshold * texelSize;
+			const bool roundRobin = i < cachedCascadeStart && updateCount_ % (i + 1) == 0;
+
+			cascadeUpdated_[i] = !cachingEnabled || lightChanged || moved || roundRobin;
+			if (cascadeUpdated_[i])
 			{
-				//printf("%f %f %f\n", testCenter[i].x, testCenter[i].y, testCenter[i].z);
+				cachedCenterRadius_[i] = glm::vec4(center, radius);
+				//The view space looks along the negative z axis
+				const glm::mat4 proj = clip * glm::ortho(center.x - radius, center.x + radius,
+					center.y - radius, center.y + radius, 
+					-center.z - radius - casterDistance, -center.z + radius);
+				viewProjs_[i] = proj * lightView;
+				worldToLightSpace_[i] = toTexture * viewProjs_[i];
+
+				//Casters outside of the split frustum can still throw shadows into it, the view space
+				//z axis points towards the light
+				auto& bounds = casterBounds_[i];
+				bounds = CalcBoundingBox(worldFrustumCorners_[i], lightView);
+				bounds.min = glm::max(bounds.min, center - radius);
+				bounds.max = glm::min(bounds.max, center + radius);
+				bounds.max.z = center.z + radius + casterDistance;
 			}
 
-			//std::array<glm::vec3, 4> directions;
-			//for (size_t i = 0; i < 4; ++i)
-			//{
-			//	const auto temp = glm::normalize(viewFrustumCorners_.corners[i + 4] - viewFrustumCorners_.corners[i]);
-			//	directions[i] = glm::vec3(temp.x, temp.y, temp.z);
-			//}
-			//const auto offset = ((splitDistances_[i] + splitDistances_[i + 1]) * 0.5f + splitDistances_[i]) * directions[i] / 5.0f;
-
-			glm::mat4 proj = clip * glm::ortho(min, max, min, max, min, max);
-			view = glm::lookAt(lightVector, glm::vec3(0, 0, 0), glm::vec3(0, -1, 0));
-      viewProjs_[i] = proj * view;
-
-			worldToLightSpace_[i] = glm::mat4x4(
-				0.5f, 0.0f, 0.0f, 0.0f,
-				0.0f, 0.5f, 0.0f, 0.0f,
-				0.0f, 0.0f, 1.0f, 0.0f,
-				0.5f, 0.5f, 0.0f, 1.0f
-			) * viewProjs_[i];
-
 			if (!GuiPass::GetMenuState().fixCameraFrustum)
 			{
+				glm::vec3 up = glm::normalize(glm::cross(-lightVector, glm::vec3(1.0f, 0.0f, 0.0f)));
 				auto rotation = glm::lookAt(glm::vec3(0.0f), lightVector, up);
-				//rotation = glm::rotate(glm::mat4(1.0f), 1.0f, glm::vec3(0.0f, -1.0f, 0.0f));
 				glm::mat4 testWorld = glm::scale(glm::translate(glm::mat4(1.0f), testCenter[i]), glm::vec3(testRadius[i])) * rotation;
 				debugBoundingBoxes_.push_back(testWorld);
-
-				
 			}
     }
 
+		cachedLightVector_ = lightVector;
+		cascadesValid_ = true;
   }
 
   AxisAlignedBoundingBox ShadowMap::CalcBoundingBox(const FrustumCorners& frustum, const glm::mat4x4& toLight)
@@ -38,15 +38,28 @@ namespace Renderer
   class ImageManager;
 	constexpr int g_cascadeCount = 4;
 
+  //Cascades are fitted to the bounding sphere of the frustum split and snapped to shadow map texels
+  //Cascades starting at cachedCascadeStart are only rendered again if the light changed or the camera
+  //moved past the threshold, the closer cascades are updated in round robin
   class ShadowMap
   {
   public:
+    static constexpr int cachedCascadeStart = 2;
+    //Distance in texels the snapped cascade center can move before a cached cascade is rendered
+    static constexpr float cacheTexelThreshold = 16.0f;
+
     void Resize(ImageManager* imageManager, uint32_t width, uint32_t height, int cascadeCount);
     void Update(const glm::vec3& lightVector, const Camera* camera);
+    //Forces all cascades to be rendered in the next update
+    void InvalidateCascades() { cascadesValid_ = false; }
+    bool CascadeUpdated(int cascade) const { return cascadeUpdated_[cascade]; }
 
     void BindViewportScissor(VkCommandBuffer commandBuffer);
 
     const auto& GetViewProjs() const { return viewProjs_; }
+    //Rotation into light space and per cascade bounds in light space including casters towards the light
+    const glm::mat4& GetLightView() const { return lightView_; }
+    const auto& GetCasterBounds() const { return casterBounds_; }
 		const auto& GetShadowMatrices() const { return worldToLightSpace_; }
     const glm::mat4& GetToTextureSpace() const { return textureMatrix_; }
     const VkExtent2D& GetSize()const { return size_; }
@@ -92,5 +105,14 @@ namespace Renderer
 		std::vector<float> testRadius;
 
 		std::array<glm::vec4, g_cascadeCount> cascadeCenterRadius_;
+
+		//Light space center and radius of the last rendered projection of each cascade
+		std::array<glm::vec4, g_cascadeCount> cachedCenterRadius_;
+		std::array<bool, g_cascadeCount> cascadeUpdated_ = {};
+		glm::mat4 lightView_;
+		std::array<AxisAlignedBoundingBox, g_cascadeCount> casterBounds_;
+		glm::vec3 cachedLightVector_;
+		bool cascadesValid_ = false;
+		uint32_t updateCount_ = 0;
   };
 }
\ No newline at end of file
@@ -48,12 +48,15 @@ namespace Renderer
 			{ "ShadowMap.frag", "main", TYPE_FRAG, SUBPASS_SHADOW_MAP},
 			{ "GridGlobal.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_GLOBAL},
 			{ "GridGroundFog.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_GROUND_FOG},
+			{ "GridMediaVolume.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_SMOKE},
 			{ "GridParticles.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_PARTICLES},
 			{ "GridDebugFilling.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_DEBUG_FILLING},
 			{ "GridNeighborUpdate.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_NEIGHBOR_UPDATE},
 			{ "GridMipMapping.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING},
-			{ "GridMipMappingMerging.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING_MERGING},
-			{ "GridRaymarching.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_RAYMARCHING}
+			{ "GridLightTransmittance.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_LIGHT_TRANSMITTANCE},
+			{ "GridFroxels.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_FROXEL},
+			{ "GridRaymarching.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_RAYMARCHING},
+			{ "GridTemporal.comp", "main", TYPE_COMP, SUBPASS_VOLUME_ADAPTIVE_TEMPORAL}
 		};
 
 		defineInfos_[DEFINE_TEST] = "DEFINE_TEST";
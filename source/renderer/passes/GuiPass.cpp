@@ -47,6 +47,8 @@ SOFTWARE.
 #include "..\wrapper\Synchronization.h"
 #include "..\wrapper\QueryPool.h"
 
+#include "..\scene\adaptiveGrid\GridStatistics.h"
+
 #include "..\..\input\InputHandler.h"
 #include "..\..\utility\Status.h"
 
@@ -58,6 +60,8 @@ namespace Renderer
 	GuiPass::ParticleState GuiPass::particleState_ = {};
 	GuiPass::DebugVisState GuiPass::debugVisState_ = {};
 	GuiPass::ConfigState GuiPass::configState_ = {};
+	GuiPass::PerformanceState GuiPass::performanceState_ = {};
+	const GridStatistics* GuiPass::gridStatistics_ = nullptr;
 
   GuiPass::MenuState::MenuState() :
     saveConfiguration{ false },
@@ -66,16 +70,25 @@ namespace Renderer
     reloadShaders{ false },
     fixCameraFrustum{ false },
 		exportFogTexture{ false },
+		saveGridSnapshot{ false },
+		loadGridSnapshot{ false },
+		loadFrozenGrid{ false },
+		startInputRecording{ false },
+		stopInputRecording{ false },
+		replayInputRecording{ false },
+		replayInputRecordingHeadless{ false },
 		performTimeQueries{false},
 		saveTimeQueries{false},
-		queryFrameCount{100}
+		queryFrameCount{100},
+		captureProfile{false}
   {}
 
   GuiPass::LightingState::LightingState() :
     irradiance{4.0f, 4.0f, 4.0f},
     lightYRotation{ 0.87f },
     lightZRotation{ 0.67f },
-    shadowLogWeight{0.5f}
+    shadowLogWeight{0.5f},
+    cacheShadowCascades{true}
   {
 		glm::mat4 lightRotation = glm::eulerAngleYZ(
 			lightingState_.lightYRotation,
@@ -93,18 +106,44 @@ namespace Renderer
 		globalValue{},
 
 		groundFogHeight{0.0f},
+		groundFogBand{0.02f},
+		groundFogHeightfieldAmplitude{0.0f},
+		groundFogHeightfieldScale{4.0f},
 		groundFogValue{},
 		groundFogNoiseScale{0.1f},
+		groundFogNoiseVolume{true},
+
+		smokeValue{},
 
 		stepCount { 200 },
 		lightStepDepth{50.0f},
-		jitteringScale { 0.2f },
+		jitteringScale { 1.0f },
 		lodScale { 1.0f },
-		minTransmittance{0.0f},
+		minTransmittance{0.01f},
+		adaptiveStepping{false},
+		adaptiveStepScale{4.0f},
+		skipExtinction{0.0f},
+		rangeStepping{false},
+		temporalFiltering{true},
+		temporalBlendWeight{0.1f},
+		tileClassification{true},
+		froxelIntegration{false},
+		lightTransmittance{true},
 		maxDepth{ 500.0f},
-		shadowRayPerLevel{16}
+		shadowRayPerLevel{16},
+		raymarchingResolution{GuiPass::VolumeState::RESOLUTION_FULL}
   {}
 
+	GuiPass::PerformanceState::PerformanceState() :
+		averageRaySteps{0.0f},
+		tileCounts{0},
+		hierarchicalCulling{true},
+		hierarchyBuildTime{0.0f},
+		cullingTime{0.0f},
+		gridStatistics{false},
+		saveGridStatistics{false}
+	{}
+
 	GuiPass::ParticleState::ParticleState() :
 		particleCount{40},
 		spawnRadius{2.0f},
@@ -131,6 +170,13 @@ namespace Renderer
 		"Fill With Level Indices"
 	};
 
+	const char * menuNames_raymarchingResolution[] =
+	{
+		"Full Resolution",
+		"Half Resolution",
+		"Quarter Resolution"
+	};
+
 	GuiPass::ConfigState::ConfigState() :
 		showDebugVis{ true }
 	{}
@@ -289,6 +335,14 @@ namespace Renderer
     return vertex_info;
   }
 
+  void GuiPass::SetReplayedStates(const VolumeState& volumeState, const LightingState& lightingState,
+		const ParticleState& particleState)
+	{
+		volumeState_ = volumeState;
+		lightingState_ = lightingState;
+		particleState_ = particleState;
+	}
+
   void GuiPass::HandleInput(InputHandler* inputHandler)
   {
     auto& io = ImGui::GetIO();
@@ -331,6 +385,15 @@ namespace Renderer
 
 		menuState_.loadScene = false;
 		menuState_.reloadShaders = false;
+		menuState_.saveGridSnapshot = false;
+		menuState_.loadGridSnapshot = false;
+		menuState_.loadFrozenGrid = false;
+		menuState_.startInputRecording = false;
+		menuState_.stopInputRecording = false;
+		menuState_.replayInputRecording = false;
+		menuState_.replayInputRecordingHeadless = false;
+		menuState_.captureProfile = false;
+		performanceState_.saveGridStatistics = false;
 
 		ImGuiWindowFlags window_flags = {};
 		window_flags |= ImGuiWindowFlags_MenuBar;
@@ -348,6 +411,38 @@ namespace Renderer
 					{
 						menuState_.reloadShaders = true;
 					}
+					if (ImGui::MenuItem("Save Grid Snapshot"))
+					{
+						menuState_.saveGridSnapshot = true;
+					}
+					if (ImGui::MenuItem("Load Grid Snapshot"))
+					{
+						menuState_.loadGridSnapshot = true;
+					}
+					if (ImGui::MenuItem("Load Frozen Grid"))
+					{
+						menuState_.loadFrozenGrid = true;
+					}
+					if (ImGui::MenuItem("Start Input Recording"))
+					{
+						menuState_.startInputRecording = true;
+					}
+					if (ImGui::MenuItem("Stop Input Recording"))
+					{
+						menuState_.stopInputRecording = true;
+					}
+					if (ImGui::MenuItem("Replay Input Recording"))
+					{
+						menuState_.replayInputRecording = true;
+					}
+					if (ImGui::MenuItem("Replay Input Recording Headless"))
+					{
+						menuState_.replayInputRecordingHeadless = true;
+					}
+					if (ImGui::MenuItem("Capture Profile"))
+					{
+						menuState_.captureProfile = true;
+					}
 					ImGui::EndMenu();
 				}
 				ImGui::EndMenuBar();
@@ -375,6 +470,7 @@ namespace Renderer
 					const auto& ir = lightingState_.irradiance;
 					Status::UpdateDirectionalLight(lightingState_.lightVector, glm::vec3(ir[0], ir[1], ir[2]));
 				}
+				ImGui::Checkbox("Cache shadow cascades", &lightingState_.cacheShadowCascades);
 			}
 
 			if (ImGui::CollapsingHeader("Grid Data"))
@@ -399,7 +495,21 @@ namespace Renderer
 						-1.0f, 1.0f);
 
 					ImGui::DragFloat("Height Percentage", &volumeState_.groundFogHeight, 0.001f, 0.0f, 1.0f);
+					ImGui::DragFloat("Band Percentage", &volumeState_.groundFogBand, 0.001f, 0.0f, 1.0f);
+					ImGui::DragFloat("Heightfield amplitude", &volumeState_.groundFogHeightfieldAmplitude, 0.001f, 0.0f, 0.5f);
+					ImGui::DragFloat("Heightfield scale", &volumeState_.groundFogHeightfieldScale, 0.01f, 0.0f, 64.0f);
 					ImGui::DragFloat("Noise scale", &volumeState_.groundFogNoiseScale, 0.001f, 0.0001f, 1.0f);
+					ImGui::Checkbox("Noise volume", &volumeState_.groundFogNoiseVolume);
+					ImGui::TreePop();
+				}
+				if (ImGui::TreeNode("Smoke Data"))
+				{
+					ImGui::DragFloat("Absorption", &volumeState_.smokeValue.absorption, 0.001f,
+						0.0f, 1.0f, "%.06f");
+					ImGui::DragFloat("Scattering", &volumeState_.smokeValue.scattering, 0.001f,
+						0.0f, 1.0f, "%.06f");
+					ImGui::DragFloat("PhaseG", &volumeState_.smokeValue.phaseG, 0.01f,
+						-1.0f, 1.0f);
 					ImGui::TreePop();
 				}
 				if (ImGui::TreeNode("Particle Data"))
@@ -414,6 +524,32 @@ namespace Renderer
 				}
 			}
 
+			if (ImGui::CollapsingHeader("Raymarching"))
+			{
+				int resolution = volumeState_.raymarchingResolution;
+				if (ImGui::Combo("Resolution", &resolution, menuNames_raymarchingResolution,
+					VolumeState::RESOLUTION_MAX))
+				{
+					volumeState_.raymarchingResolution = static_cast<VolumeState::RaymarchingResolution>(resolution);
+				}
+				ImGui::DragInt("Max steps", &volumeState_.stepCount, 1.0f, 1, 1000);
+				ImGui::DragFloat("Min transmittance", &volumeState_.minTransmittance, 0.001f,
+					0.0f, 1.0f, "%.04f");
+				ImGui::Checkbox("Adaptive stepping", &volumeState_.adaptiveStepping);
+				ImGui::DragFloat("Adaptive step scale", &volumeState_.adaptiveStepScale, 0.1f,
+					1.0f, 16.0f);
+				ImGui::Checkbox("Node range stepping", &volumeState_.rangeStepping);
+				ImGui::DragFloat("Skip extinction", &volumeState_.skipExtinction, 0.0001f,
+					0.0f, 1.0f, "%.04f");
+				ImGui::Checkbox("Temporal filtering", &volumeState_.temporalFiltering);
+				ImGui::SliderFloat("Temporal blend weight", &volumeState_.temporalBlendWeight, 0.01f, 1.0f);
+				ImGui::SliderFloat("Jittering scale", &volumeState_.jitteringScale, 0.0f, 1.0f);
+				ImGui::Checkbox("Tile classification", &volumeState_.tileClassification);
+				ImGui::Checkbox("Froxel integration", &volumeState_.froxelIntegration);
+				ImGui::Checkbox("Light transmittance", &volumeState_.lightTransmittance);
+				ImGui::DragInt("Shadow steps per level", &volumeState_.shadowRayPerLevel, 1.0f, 1, 64);
+			}
+
 			if (ImGui::CollapsingHeader("Debug Visualization"))
 			{
 				ImGui::Checkbox("Render Object Bounding Boxes", &debugVisState_.bbRendering);
@@ -430,6 +566,42 @@ namespace Renderer
 			if (ImGui::CollapsingHeader("Performance"))
 			{
 				ImGui::Text("Application\t%.4f ms/frame ", deltaTime_ * 1000.0f);
+				ImGui::Text("Raymarching\t%.2f steps/ray ", performanceState_.averageRaySteps);
+				const auto& tileCounts = performanceState_.tileCounts;
+				ImGui::Text("Tiles\t%d full, %d global, %d empty", tileCounts.x, tileCounts.y, tileCounts.z);
+				ImGui::Checkbox("Hierarchical culling", &performanceState_.hierarchicalCulling);
+				ImGui::Text("Culling\t%.4f ms, hierarchy build %.4f ms", performanceState_.cullingTime,
+					performanceState_.hierarchyBuildTime);
+				ImGui::Checkbox("Grid statistics", &performanceState_.gridStatistics);
+				if (performanceState_.gridStatistics && gridStatistics_ != nullptr && gridStatistics_->enabled)
+				{
+					const auto& stats = *gridStatistics_;
+					for (size_t i = 0; i < stats.nodesPerLevel.size(); ++i)
+					{
+						ImGui::Text("Level %d\t%d nodes, %d with geometry", static_cast<int>(i), stats.nodesPerLevel[i],
+							i < stats.geometryNodesPerLevel.size() ? stats.geometryNodesPerLevel[i] : 0);
+					}
+					ImGui::Text("Atlas\t%d^3, %d images, %.1f%% occupied, %d mip maps", stats.atlasSideLength,
+						stats.atlasImageCount, stats.atlasOccupancy * 100.0f, stats.mipMapCount);
+					ImGui::Text("Particles/node");
+					for (int i = 0; i < GridStatistics::particleBinCount; ++i)
+					{
+						ImGui::SameLine();
+						ImGui::Text("%d", stats.particlesPerNode[i]);
+					}
+					ImGui::Text("Buffers\t%.1f KB nodes, %.1f KB bits, %.1f KB counts, %.1f KB childs",
+						stats.nodeInfoBytes / 1024.0f, stats.activeBitBytes / 1024.0f, stats.bitCountBytes / 1024.0f,
+						stats.childIndexBytes / 1024.0f);
+					ImGui::Text("Upload\t%.1f KB of %.1f KB mapped", stats.uploadedBytes / 1024.0f, stats.mappedBytes / 1024.0f);
+					for (int i = 0; i < GridStatistics::STAGE_MAX; ++i)
+					{
+						ImGui::Text("%s\t%.4f ms", GridStatistics::stageNames[i], stats.stageTimes[i]);
+					}
+					if (ImGui::Button("Save grid statistics"))
+					{
+						performanceState_.saveGridStatistics = true;
+					}
+				}
 			}
 		}
 		ImGui::End();
@@ -35,6 +35,7 @@ class InputHandler;
 namespace Renderer
 {
   class Instance;
+	struct GridStatistics;
 
   class GuiPass : public Pass
   {
@@ -47,9 +48,17 @@ namespace Renderer
       bool reloadShaders;
       bool fixCameraFrustum;
 			bool exportFogTexture;
+			bool saveGridSnapshot;
+			bool loadGridSnapshot;
+			bool loadFrozenGrid;				//replaces the grid with a snapshot which is not updated anymore
+			bool startInputRecording;
+			bool stopInputRecording;
+			bool replayInputRecording;
+			bool replayInputRecordingHeadless;
 			bool performTimeQueries;
 			bool saveTimeQueries;
 			int queryFrameCount;
+			bool captureProfile;				//captures queryFrameCount frames as chrome trace
 
       MenuState();
     };
@@ -61,6 +70,7 @@ namespace Renderer
       float lightYRotation;
       float lightZRotation;
       float shadowLogWeight;
+      bool cacheShadowCascades;
       LightingState();
     };
 
@@ -74,12 +84,25 @@ namespace Renderer
 
     struct VolumeState
     {
+			enum RaymarchingResolution
+			{
+				RESOLUTION_FULL,
+				RESOLUTION_HALF,
+				RESOLUTION_QUARTER,
+				RESOLUTION_MAX
+			};
+
 			TextureValue globalValue;
 
 			float groundFogHeight;
+			float groundFogBand;
+			float groundFogHeightfieldAmplitude;
+			float groundFogHeightfieldScale;
 			TextureValue groundFogValue;
 			float groundFogNoiseScale;
+			bool groundFogNoiseVolume;
 
+			TextureValue smokeValue;			//scaled by the density of each smoke volume
 			TextureValue particleValue;
 
 			float jitteringScale;
@@ -89,11 +112,35 @@ namespace Renderer
 			glm::vec2 cursorPosition;
 			float lodScale;
 			float minTransmittance;
+			bool adaptiveStepping;
+			float adaptiveStepScale;
+			float skipExtinction;			//regions with a lower maximum extinction are skipped, 0 disables skipping
+			bool rangeStepping;				//adaptive steps use the maximum extinction of the nodes
+			bool temporalFiltering;
+			float temporalBlendWeight;
+			bool tileClassification;
+			bool froxelIntegration;
+			bool lightTransmittance;
 			float maxDepth;
 			int shadowRayPerLevel;
+			RaymarchingResolution raymarchingResolution;
       VolumeState();
+			//Number of screen pixels per raymarching texel in each dimension
+			int ResolutionDivision() const { return 1 << raymarchingResolution; }
     };
 
+		struct PerformanceState
+		{
+			float averageRaySteps;
+			glm::ivec3 tileCounts;			//full, global medium only, empty
+			bool hierarchicalCulling;		//compare against brute force culling of all mesh bounds
+			float hierarchyBuildTime;		//ms
+			float cullingTime;					//ms, camera and shadow cascades
+			bool gridStatistics;				//collect the grid build statistics each frame
+			bool saveGridStatistics;
+			PerformanceState();
+		};
+
 		struct ParticleState
 		{
 			int particleCount;
@@ -152,6 +199,17 @@ namespace Renderer
     static const VolumeState& GetVolumeState() { return volumeState_; }
 		static const ParticleState& GetParticleState() { return particleState_; }
 		static const DebugVisState& GetDebugVisState() { return debugVisState_; }
+		//Overwrites the states changed by the user with the recorded ones
+		static void SetReplayedStates(const VolumeState& volumeState, const LightingState& lightingState, 
+			const ParticleState& particleState);
+		//Average number of raymarching steps per ray of the last finished frame
+		static void SetAverageRaySteps(float steps) { performanceState_.averageRaySteps = steps; }
+		static void SetTileCounts(int full, int global, int empty) { performanceState_.tileCounts = { full, global, empty }; }
+		static void SetHierarchyBuildTime(float ms) { performanceState_.hierarchyBuildTime = ms; }
+		static void SetCullingTime(float ms) { performanceState_.cullingTime = ms; }
+		//Statistics of the last grid build, only displayed while they are collected
+		static void SetGridStatistics(const GridStatistics* statistics) { gridStatistics_ = statistics; }
+		static const PerformanceState& GetPerformanceState() { return performanceState_; }
   private:
     enum GraphicSubpasses
     {
@@ -177,5 +235,7 @@ namespace Renderer
 
 		static ConfigState configState_;
 		static DebugVisState debugVisState_;
+		static PerformanceState performanceState_;
+		static const GridStatistics* gridStatistics_;
   };
 }
\ No newline at end of file
@@ -38,6 +38,9 @@ SOFTWARE.
 #include "..\wrapper\Instance.h"
 #include "..\wrapper\Surface.h"
 #include "..\wrapper\Barrier.h"
+#include "..\wrapper\CommandBuffer.h"
+
+#include "..\..\utility\Profiler.h"
 
 #include "PostProcessPass.h"
 #include "GuiPass.h"
@@ -89,16 +92,24 @@ namespace Renderer
 			depthImageIndex_ = imageManager->RequestImage(imageInfo);
 		}
 		{
+			//Reduced resolution raymarching only uses the upper left part of the image,
+			//keeping the full size allows switching the resolution without recreating it
 			ImageManager::ImageInfo imageInfo = {};
-			const int resolutionScale = 1;
-			imageInfo.extent = { surfaceSize.width / resolutionScale, surfaceSize.height / resolutionScale, 1 };
+			imageInfo.extent = { surfaceSize.width, surfaceSize.height, 1 };
 			imageInfo.format = imageManager->GetOffscreenImageFormat();
 			imageInfo.type = ImageManager::IMAGE_RESIZE;
 			imageInfo.sampler = ImageManager::SAMPLER_LINEAR;
-			imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT;
+			//Transfer destination for clearing tiles without raymarching
+			imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 			imageInfo.layout = VK_IMAGE_LAYOUT_GENERAL;
 			imageInfo.viewLayout = VK_IMAGE_LAYOUT_GENERAL;
 			raymarchingImage_ = imageManager->RequestImage(imageInfo);
+
+			//Temporal filtering writes into the resolved image which is copied into the history
+			imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			raymarchingResolvedImage_ = imageManager->RequestImage(imageInfo);
+			imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			raymarchingHistoryImage_ = imageManager->RequestImage(imageInfo);
 		}
     ImageManager::Ref_ImageInfo noiseImageInfo = {};
     noiseImageInfo.arrayCount = 64;
@@ -111,8 +122,8 @@ namespace Renderer
 		noiseImageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
     noiseMultipleChannels_ = imageManager->Ref_RequestImage(noiseImageInfo, "..\\data\\noise\\HDR_RGBA__X_.png");
 
-    renderScene->GetAdaptiveGrid()->SetImageIndices(raymarchingImage_, depthImageIndex_, 
-			renderScene->GetShadowMap()->GetImageIndex(), noiseImageIndex_);
+    renderScene->GetAdaptiveGrid()->SetImageIndices(raymarchingImage_, raymarchingHistoryImage_,
+			raymarchingResolvedImage_, depthImageIndex_, renderScene->GetShadowMap()->GetImageIndex(), noiseImageIndex_);
     
 		shadowMapImageIndex_ = renderScene->GetShadowMap()->GetImageIndex();
 
@@ -127,7 +138,8 @@ namespace Renderer
     static_cast<VolumePass*>(passes_[PASS_VOLUME].get())->SetImageIndices(
       raymarchingImage_, depthImageIndex_, noiseImageIndex_);
     static_cast<PostProcessPass*>(passes_[PASS_POSTPROCESS].get())->SetImageIndices(
-      offscreenRenderTarget_, raymarchingImage_, depthImageIndex_, noiseMultipleChannels_);
+      offscreenRenderTarget_, raymarchingResolvedImage_, depthImageIndex_, noiseMultipleChannels_,
+      renderScene->GetAdaptiveGrid()->GetFroxelImageIndex());
 
     for (auto& pass : passes_)
     {
@@ -142,6 +154,7 @@ namespace Renderer
     if (!CreateManagers(instance, surface, imageManager)) { return false; }
     if (!CreateShaderBindings(instance)) { return false; }
     if (!CreatePasses(hwnd, device, imageManager, surface)) { return false; }
+    if (!CreateHeadlessCommandBuffers(device, surface->GetImageCount())) { return false; }
 
     printf("Pass Manager created\n");
     return true;
@@ -214,6 +227,7 @@ namespace Renderer
   void PassManager::Render(VkDevice device, QueueManager* queueManager, BufferManager* bufferManager,
     ImageManager* imageManager, Surface* surface, int currFameIndex)
   {
+    PROFILE_SCOPE("PassManager::Render");
     {
       std::vector<VkImageMemoryBarrier> barrier;
       passes_[PASS_SHADOW_MAP]->Render(surface, frameBufferManager_.get(), queueManager, bufferManager,
@@ -237,8 +251,74 @@ namespace Renderer
     }
   }
 
+  void PassManager::RenderHeadless(VkDevice device, QueueManager* queueManager, BufferManager* bufferManager,
+    ImageManager* imageManager, Surface* surface, int currFrameIndex)
+  {
+    PROFILE_SCOPE("PassManager::RenderHeadless");
+    const auto& graphicsQueue = queueManager->GetQueue(QueueManager::QUEUE_GRAPHICS);
+
+    //Without acquiring a swapchain image the start semaphore is signaled directly
+    VkSubmitInfo startInfo = {};
+    startInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    startInfo.signalSemaphoreCount = 1;
+    startInfo.pSignalSemaphores = surface->GetImageAvailableSemaphore();
+    vkQueueSubmit(graphicsQueue, 1, &startInfo, VK_NULL_HANDLE);
+
+    std::vector<VkImageMemoryBarrier> barrier;
+    passes_[PASS_SHADOW_MAP]->Render(surface, frameBufferManager_.get(), queueManager, bufferManager,
+      barrier, surface->GetImageAvailableSemaphore(), currFrameIndex);
+
+    passes_[PASS_MESH]->Render(surface, frameBufferManager_.get(), queueManager, bufferManager,
+      barrier, passes_[PASS_SHADOW_MAP]->GetFinishedSemaphore(), currFrameIndex);
+
+    passes_[PASS_VOLUME]->Render(surface, frameBufferManager_.get(), queueManager, bufferManager,
+      barrier, passes_[PASS_MESH]->GetFinishedSemaphore(), currFrameIndex);
+
+    //Postprocess and gui normally return the depth image and the render target to their initial layouts
+    auto layoutBarriers = imageManager->ReadToWriteBarrier({ offscreenRenderTarget_ });
+    VkImageMemoryBarrier depthBarrier = {};
+    depthBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    depthBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    depthBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    depthBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    depthBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depthBarrier.image = imageManager->GetImage(depthImageIndex_);
+    depthBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    depthBarrier.subresourceRange.baseArrayLayer = 0;
+    depthBarrier.subresourceRange.layerCount = 1;
+    depthBarrier.subresourceRange.baseMipLevel = 0;
+    depthBarrier.subresourceRange.levelCount = 1;
+    layoutBarriers.push_back(depthBarrier);
+
+    const auto& commandBuffer = headlessCommandBuffers_[currFrameIndex];
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+      0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(layoutBarriers.size()), layoutBarriers.data());
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = passes_[PASS_VOLUME]->GetFinishedSemaphore();
+    const VkPipelineStageFlags waitDstStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    submitInfo.pWaitDstStageMask = &waitDstStageMask;
+    vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+  }
+
   void PassManager::Release(VkDevice device)
   {
+    if (headlessCommandPool_ != VK_NULL_HANDLE)
+    {
+      vkDestroyCommandPool(device, headlessCommandPool_, nullptr);
+      headlessCommandPool_ = VK_NULL_HANDLE;
+    }
+
     shaderBindingManager_->Release(device);
     shaderManager_->Release(device);
     renderPassManager_->Release(device);
@@ -267,6 +347,18 @@ namespace Renderer
     return true;
   }
 
+  bool PassManager::CreateHeadlessCommandBuffers(VkDevice device, uint32_t count)
+  {
+    if (!Wrapper::CreateCommandPool(device, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+      QueueManager::GetQueueFamilyIndex(QueueManager::QUEUE_GRAPHICS), &headlessCommandPool_))
+    {
+      return false;
+    }
+
+    headlessCommandBuffers_.resize(count, VK_NULL_HANDLE);
+    return Wrapper::AllocateCommandBuffers(device, headlessCommandPool_, count, headlessCommandBuffers_.data());
+  }
+
   void PassManager::SetResources(RenderScene* renderScene)
   {
     static_cast<ShadowMapPass*>(passes_[PASS_SHADOW_MAP].get())->SetRenderScene(renderScene);
@@ -64,6 +64,9 @@ namespace Renderer
     void Update(Instance* instance, BufferManager* bufferManager, float deltaTime);
     void Render(VkDevice device, QueueManager* queueManager, BufferManager* bufferManager,
       ImageManager* imageManager, Surface* surface, int currFrameIndex);
+    //Renders without postprocess and gui, the swapchain image is neither acquired nor presented
+    void RenderHeadless(VkDevice device, QueueManager* queueManager, BufferManager* bufferManager,
+      ImageManager* imageManager, Surface* surface, int currFrameIndex);
 
     void Release(VkDevice device);
 
@@ -77,6 +80,7 @@ namespace Renderer
   private:
     bool CreateManagers(Instance* instance, Surface* surface, ImageManager* imageManager);
     bool CreateShaderBindings(Instance* instance);
+    bool CreateHeadlessCommandBuffers(VkDevice device, uint32_t count);
 
     std::shared_ptr<FrameBufferManager> frameBufferManager_;
     std::shared_ptr<RenderPassManager> renderPassManager_;
@@ -87,10 +91,16 @@ namespace Renderer
 
     int offscreenRenderTarget_;
     int raymarchingImage_;
+    int raymarchingResolvedImage_ = -1;
+    int raymarchingHistoryImage_ = -1;
     int depthImageIndex_ = -1;
     int noiseImageIndex_ = -1;
     int noiseMultipleChannels_ = -1;
 		int shadowMapImageIndex_ = -1;
     VkSemaphore* frameFinished_ = nullptr;
+
+    //Restore the image layouts at the end of a headless frame
+    VkCommandPool headlessCommandPool_ = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> headlessCommandBuffers_;
   };
 }
\ No newline at end of file
@@ -42,12 +42,15 @@ namespace Renderer
 		SUBPASS_SHADOW_MAP,
 		SUBPASS_VOLUME_ADAPTIVE_GLOBAL,
 		SUBPASS_VOLUME_ADAPTIVE_GROUND_FOG,
+		SUBPASS_VOLUME_ADAPTIVE_SMOKE,
 		SUBPASS_VOLUME_ADAPTIVE_PARTICLES,
 		SUBPASS_VOLUME_ADAPTIVE_DEBUG_FILLING,
 		SUBPASS_VOLUME_ADAPTIVE_NEIGHBOR_UPDATE,
 		SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING,
-		SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING_MERGING,
+		SUBPASS_VOLUME_ADAPTIVE_LIGHT_TRANSMITTANCE,
+		SUBPASS_VOLUME_ADAPTIVE_FROXEL,
     SUBPASS_VOLUME_ADAPTIVE_RAYMARCHING,
+		SUBPASS_VOLUME_ADAPTIVE_TEMPORAL,
     SUBPASS_MESH,
     SUBPASS_MESH_DEPTH_ONLY,
     SUBPASS_GUI,
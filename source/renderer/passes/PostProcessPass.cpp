@@ -56,12 +56,14 @@ namespace Renderer
     Pass::Pass(bindingManager, renderPassManager)
   {}
 
-  void PostProcessPass::SetImageIndices(int meshRenderingIndex, int raymarchingIndex, int depthImageIndex, int noiseImage)
+  void PostProcessPass::SetImageIndices(int meshRenderingIndex, int raymarchingIndex, int depthImageIndex, int noiseImage,
+    int froxelImage)
   {
     meshRenderingImageIndex_ = meshRenderingIndex;
     raymarchingImageIndex_ = raymarchingIndex;
     depthImageIndex_ = depthImageIndex;
     noiseImageIndex_ = noiseImage;
+    froxelImageIndex_ = froxelImage;
   }
 
   void PostProcessPass::RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount)
@@ -82,9 +84,13 @@ namespace Renderer
         VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
         VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
       };
       bindingInfo.stages = {
+        VK_SHADER_STAGE_FRAGMENT_BIT,
+        VK_SHADER_STAGE_FRAGMENT_BIT,
         VK_SHADER_STAGE_FRAGMENT_BIT,
         VK_SHADER_STAGE_FRAGMENT_BIT,
         VK_SHADER_STAGE_FRAGMENT_BIT,
@@ -94,12 +100,16 @@ namespace Renderer
         meshRenderingImageIndex_,
         raymarchingImageIndex_,
         noiseImageIndex_,
-        frameBuffer_
+        frameBuffer_,
+        depthImageIndex_,
+        froxelImageIndex_
       };
       bindingInfo.refactoring_ = {
         false,
         false,
         true,
+        true,
+        false,
         true
       };
       bindingInfo.pass = pass;
@@ -315,6 +325,13 @@ namespace Renderer
 
     const auto& surfaceSize = surface->GetSurfaceSize();
     frameData_.screenSize = { surfaceSize.width, surfaceSize.height };
+    frameData_.nearPlane = scene->GetCamera().nearZ_;
+    frameData_.farPlane = scene->GetCamera().farZ_;
+    const auto& volumeState = GuiPass::GetVolumeState();
+    frameData_.resolutionDivision = volumeState.ResolutionDivision();
+    //Same depth distribution as the froxel slices
+    frameData_.exponentialScale = log(volumeState.maxDepth);
+    frameData_.froxelIntegration = volumeState.froxelIntegration ? 1 : 0;
   }
 
   void PostProcessPass::Render(Surface* surface, FrameBufferManager* frameBufferManager,
@@ -40,7 +40,8 @@ namespace Renderer
     PostProcessPass(ShaderBindingManager* bindingManager, RenderPassManager* renderPassManager);
 
     void RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount) override;
-    void SetImageIndices(int meshRenderingIndex, int raymarchingIndex, int depthImageIndex, int noiseImage);
+    void SetImageIndices(int meshRenderingIndex, int raymarchingIndex, int depthImageIndex, int noiseImage,
+      int froxelImage);
     bool Create(VkDevice device, ShaderManager* shaderManager, FrameBufferManager* frameBufferManager,
       Surface* surface, ImageManager* imageManager) override;
 
@@ -70,6 +71,11 @@ namespace Renderer
     {
       glm::vec4 randomness;
       glm::vec2 screenSize;
+      float nearPlane;
+      float farPlane;
+      int resolutionDivision;
+      float exponentialScale;
+      int froxelIntegration;
     };
     
     bool CreateFrameBuffers(VkDevice device, FrameBufferManager* frameBufferManager, Surface* surface) override;
@@ -80,6 +86,7 @@ namespace Renderer
     int debugPushConstantIndex_ = -1;
     int noiseImageIndex_ = -1;
     int depthImageIndex_ = -1;
+    int froxelImageIndex_ = -1;
 
     int frameBuffer_;
     std::vector<DebugData> debugBoundingBoxes_;
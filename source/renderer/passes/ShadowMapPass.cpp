@@ -123,13 +123,19 @@ namespace Renderer
       shadowMap_->BindViewportScissor(commandBuffers_[frameIndex]);
 
       const auto& meshData = renderScene_->GetMeshData();
-      const auto& currMeshIndices = renderScene_->GetMeshIndices(SUBPASS_SHADOW_MAP);
 
       renderScene_->BindMeshData(bufferManager, commandBuffers_[frameIndex]);
 
-      int offset = 0;
       for (size_t i = 0; i < shadowMap_->GetCascadeCount(); ++i)
       {
+        //Cached cascades keep the content of the last time they were rendered
+        if (!shadowMap_->CascadeUpdated(static_cast<int>(i)))
+        {
+          continue;
+        }
+        //Light matrices of all meshes are stored per cascade
+        const int offset = static_cast<int>(i * meshData.indexCounts_.size());
+        const auto& currMeshIndices = renderScene_->GetShadowCasters(static_cast<int>(i));
         {
           //Begin rendering by clearing depth
           VkRenderPassBeginInfo renderPassInfo = {};
@@ -163,7 +169,6 @@ namespace Renderer
               meshData.indexCounts_[i], 1, meshData.indexOffsets_[i],
               meshData.vertexOffsets_[i], 0);
           }
-          offset += static_cast<int>(currMeshIndices.size());
         }
 
         vkCmdEndRenderPass(commandBuffers_[frameIndex]);
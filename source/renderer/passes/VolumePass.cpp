@@ -85,6 +85,10 @@ namespace Renderer
 		{
 			computePipelines_[subpass].shaderBinding = adaptiveGrid_->GetShaderBinding(bindingManager_, AdaptiveGrid::GRID_PASS_GROUND_FOG);
 		}
+		subpass = COMPUTE_SMOKE;
+		{
+			computePipelines_[subpass].shaderBinding = adaptiveGrid_->GetShaderBinding(bindingManager_, AdaptiveGrid::GRID_PASS_SMOKE);
+		}
 		subpass = COMPUTE_PARTICLES;
 		{
 			computePipelines_[subpass].shaderBinding = adaptiveGrid_->GetShaderBinding(bindingManager_, AdaptiveGrid::GRID_PASS_PARTICLES);
@@ -101,14 +105,22 @@ namespace Renderer
 		{
 			computePipelines_[subpass].shaderBinding = adaptiveGrid_->GetShaderBinding(bindingManager_, AdaptiveGrid::GRID_PASS_MIPMAPPING);
 		}
-		subpass = COMPUTE_MIPMAPPING_MERGING;
+		subpass = COMPUTE_LIGHT_TRANSMITTANCE;
+		{
+			computePipelines_[subpass].shaderBinding = adaptiveGrid_->GetShaderBinding(bindingManager_, AdaptiveGrid::GRID_PASS_LIGHT_TRANSMITTANCE);
+		}
+		subpass = COMPUTE_FROXEL;
 		{
-			computePipelines_[subpass].shaderBinding = adaptiveGrid_->GetShaderBinding(bindingManager_, AdaptiveGrid::GRID_PASS_MIPMAPPING_MERGING);
+			computePipelines_[subpass].shaderBinding = adaptiveGrid_->GetShaderBinding(bindingManager_, AdaptiveGrid::GRID_PASS_FROXEL);
 		}
     subpass = COMPUTE_RAYMARCHING;
     {
       computePipelines_[subpass].shaderBinding = adaptiveGrid_->GetShaderBinding(bindingManager_, AdaptiveGrid::GRID_PASS_RAYMARCHING);
     }
+		subpass = COMPUTE_TEMPORAL;
+		{
+			computePipelines_[subpass].shaderBinding = adaptiveGrid_->GetShaderBinding(bindingManager_, AdaptiveGrid::GRID_PASS_TEMPORAL);
+		}
   }
 
   bool VolumePass::Create(VkDevice device, ShaderManager* shaderManager, FrameBufferManager* frameBufferManager,
@@ -174,14 +186,15 @@ namespace Renderer
 			RecordCommands(queueManager, bufferManager, imageManager_, surface, commandBuffer, 
 				static_cast<ComputeSubpasses>(pass), frameIndex, parentGridLevel);
 
-			//Mip mapping has to be performed for each level seperately starting with the most detailed level
-			if (pass == COMPUTE_MIPMAPPING_MERGING && parentGridLevel > 0)
+			if (pass == COMPUTE_NEIGHBOR_UPDATE)
 			{
-				pass = COMPUTE_NEIGHBOR_UPDATE - 1;
+				parentGridLevel--;
 			}
-			if (pass == COMPUTE_NEIGHBOR_UPDATE)
+			//Mip mapping has to be performed for each level seperately starting with the most detailed level
+			else if (pass == COMPUTE_MIPMAPPING && parentGridLevel > 0)
 			{
 				parentGridLevel--;
+				pass = COMPUTE_MIPMAPPING - 1;
 			}
 		}
 
@@ -206,6 +219,7 @@ namespace Renderer
 		vkQueueSubmit(computeQueue, 1, &submitInfo, VK_NULL_HANDLE);
 
 		adaptiveGrid_->UpdateDebugTraversal(queueManager, bufferManager, imageManager_);
+		adaptiveGrid_->UpdateSnapshots(queueManager, bufferManager, imageManager_, frameIndex);
   }
 
 	void VolumePass::OnLoadScene(Scene* scene)
@@ -234,7 +248,7 @@ namespace Renderer
   bool VolumePass::CreateComputePipelines(VkDevice device, ShaderManager* shaderManager)
   {
     std::vector<VkComputePipelineCreateInfo> createInfos;
-    for(int subpass = SUBPASS_VOLUME_ADAPTIVE_GLOBAL; subpass <= SUBPASS_VOLUME_ADAPTIVE_RAYMARCHING; ++subpass)
+    for(int subpass = SUBPASS_VOLUME_ADAPTIVE_GLOBAL; subpass <= SUBPASS_VOLUME_ADAPTIVE_TEMPORAL; ++subpass)
     {
       VkComputePipelineCreateInfo createInfo = {};
       createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -277,6 +291,10 @@ namespace Renderer
 			passType = SUBPASS_VOLUME_ADAPTIVE_GROUND_FOG;
 			gridPass = AdaptiveGrid::GRID_PASS_GROUND_FOG;
 			break;
+		case COMPUTE_SMOKE:
+			passType = SUBPASS_VOLUME_ADAPTIVE_SMOKE;
+			gridPass = AdaptiveGrid::GRID_PASS_SMOKE;
+			break;
     case COMPUTE_PARTICLES:
 			passType = SUBPASS_VOLUME_ADAPTIVE_PARTICLES;
 			gridPass = AdaptiveGrid::GRID_PASS_PARTICLES;
@@ -289,18 +307,26 @@ namespace Renderer
 			passType = SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING;
 			gridPass = AdaptiveGrid::GRID_PASS_MIPMAPPING;
 			break;
-		case COMPUTE_MIPMAPPING_MERGING:
-			passType = SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING_MERGING;
-			gridPass = AdaptiveGrid::GRID_PASS_MIPMAPPING_MERGING;
-			break;
 		case COMPUTE_NEIGHBOR_UPDATE:
 			passType = SUBPASS_VOLUME_ADAPTIVE_NEIGHBOR_UPDATE;
 			gridPass = AdaptiveGrid::GRID_PASS_NEIGHBOR_UPDATE;
 			break;
+		case COMPUTE_LIGHT_TRANSMITTANCE:
+			passType = SUBPASS_VOLUME_ADAPTIVE_LIGHT_TRANSMITTANCE;
+			gridPass = AdaptiveGrid::GRID_PASS_LIGHT_TRANSMITTANCE;
+			break;
+		case COMPUTE_FROXEL:
+			passType = SUBPASS_VOLUME_ADAPTIVE_FROXEL;
+			gridPass = AdaptiveGrid::GRID_PASS_FROXEL;
+			break;
     case COMPUTE_RAYMARCHING:
       passType = SUBPASS_VOLUME_ADAPTIVE_RAYMARCHING;
 			gridPass = AdaptiveGrid::GRID_PASS_RAYMARCHING;
       break;
+		case COMPUTE_TEMPORAL:
+			passType = SUBPASS_VOLUME_ADAPTIVE_TEMPORAL;
+			gridPass = AdaptiveGrid::GRID_PASS_TEMPORAL;
+			break;
 		default:
 			return true;
     }
@@ -332,18 +358,20 @@ namespace Renderer
 		switch (subpass)
     {
 		case COMPUTE_PARTICLES:
+		case COMPUTE_SMOKE:
 		case COMPUTE_GLOBAL:
 		case COMPUTE_DEBUG_FILLING:
     case COMPUTE_GROUND_FOG:
 		case COMPUTE_MIPMAPPING:
-		case COMPUTE_MIPMAPPING_MERGING:
 		case COMPUTE_NEIGHBOR_UPDATE:
+		case COMPUTE_LIGHT_TRANSMITTANCE:
+		case COMPUTE_FROXEL:
+		case COMPUTE_TEMPORAL:
 			adaptiveGrid_->Dispatch(queueManager, imageManager, bufferManager, commandBuffer, gridPass, currFrameIndex, gridLevel); 
 			break;
 		case COMPUTE_RAYMARCHING:
     {
-      const auto& surfaceSize = surface->GetSurfaceSize();
-      adaptiveGrid_->Raymarch(imageManager, commandBuffer, surfaceSize.width, surfaceSize.height, currFrameIndex);
+      adaptiveGrid_->Raymarch(imageManager, bufferManager, commandBuffer, currFrameIndex);
 			adaptiveGrid_->Dispatch(queueManager, imageManager, bufferManager, commandBuffer, gridPass, currFrameIndex, gridLevel);
     } break;
     }
@@ -63,12 +63,15 @@ namespace Renderer
     {
 			COMPUTE_GLOBAL,
       COMPUTE_GROUND_FOG,
+			COMPUTE_SMOKE,
       COMPUTE_PARTICLES,
 			COMPUTE_DEBUG_FILLING,
 			COMPUTE_NEIGHBOR_UPDATE,
 			COMPUTE_MIPMAPPING,
-			COMPUTE_MIPMAPPING_MERGING,
+			COMPUTE_LIGHT_TRANSMITTANCE,
+			COMPUTE_FROXEL,
       COMPUTE_RAYMARCHING,
+			COMPUTE_TEMPORAL,
       COMPUTE_MAX
     };
 
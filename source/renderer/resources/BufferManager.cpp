@@ -24,6 +24,8 @@ SOFTWARE.
 
 #include "BufferManager.h"
 
+#include <algorithm>
+
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm\gtx\euler_angles.hpp>
 
@@ -39,6 +41,8 @@ SOFTWARE.
 
 #include "..\passResources\ShaderBindingManager.h"
 
+#include "..\..\utility\Profiler.h"
+
 namespace Renderer
 {
 	BufferManager::BarrierInfo::BarrierInfo() :
@@ -419,6 +423,7 @@ namespace Renderer
 
   void BufferManager::PerformCopies(QueueManager* queueManager)
   {
+    PROFILE_SCOPE("BufferManager::PerformCopies");
     if (commandRecording_[activeBuffer_])
     {
       vkEndCommandBuffer(transferBuffers_[activeBuffer_]);
@@ -574,7 +579,9 @@ namespace Renderer
 
   VkDescriptorBufferInfo* BufferManager::Ref_GetDescriptorInfo(int index, int offset)
   {
-    const int bufferIndex = ref_BufferInfos_[index].bufferIndices_[offset];
+    //Buffers without per frame copies are shared by the descriptor sets of all frames
+    const auto& bufferIndices = ref_BufferInfos_[index].bufferIndices_;
+    const int bufferIndex = bufferIndices[std::min(offset, static_cast<int>(bufferIndices.size()) - 1)];
     return &ref_descriptorInfos_[bufferIndex];
   }
 
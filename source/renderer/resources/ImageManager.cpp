@@ -93,6 +93,7 @@ namespace Renderer
     Ref_memoryPools_[MEMORY_POOL_CONSTANT] = std::make_unique<Wrapper::MemoryAllocator>(64);
 		Ref_memoryPools_[MEMORY_POOL_INDIVIDUAL] = std::make_unique<Wrapper::MemoryAllocator>();
 		Ref_memoryPools_[MEMORY_POOL_GRID_MIPMAP] = std::make_unique<Wrapper::MemoryAllocator>();
+		Ref_memoryPools_[MEMORY_POOL_GRID_LIGHT] = std::make_unique<Wrapper::MemoryAllocator>();
   }
 
   int ImageManager::RequestImage(const ImageInfo& imageInfo)
@@ -433,6 +434,57 @@ namespace Renderer
 		vkDeviceWaitIdle(instance_->GetDevice());
 	}
 
+	void ImageManager::CopyBufferToImage(QueueManager* queueManager, VkBuffer buffer,
+		const std::vector<VkBufferImageCopy>& copyRegions, VkImageLayout layout, int imageIndex, bool refactoring)
+	{
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(transitionCommandBuffer_, &beginInfo);
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = layout;
+		barrier.srcQueueFamilyIndex = queueManager->GetQueueFamilyIndex(QueueManager::QUEUE_GRAPHICS);
+		barrier.dstQueueFamilyIndex = queueManager->GetQueueFamilyIndex(QueueManager::QUEUE_GRAPHICS);
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.image = refactoring ? Ref_images_[imageIndex] : images_[imageIndex];
+		barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(transitionCommandBuffer_, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		vkCmdCopyBufferToImage(transitionCommandBuffer_, buffer, barrier.image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+
+		VkImageMemoryBarrier copyToShaderBarrier = barrier;
+		copyToShaderBarrier.oldLayout = barrier.newLayout;
+		copyToShaderBarrier.newLayout = barrier.oldLayout;
+		copyToShaderBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		copyToShaderBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(transitionCommandBuffer_, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &copyToShaderBarrier);
+		vkEndCommandBuffer(transitionCommandBuffer_);
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &transitionCommandBuffer_;
+
+		const auto& graphicsQueue = queueManager->GetQueue(QueueManager::QUEUE_GRAPHICS);
+		const auto result = vkQueueSubmit(graphicsQueue, 1, &submitInfo, nullptr);
+		assert(result == VK_SUCCESS);
+
+		vkDeviceWaitIdle(instance_->GetDevice());
+	}
+
 	void ImageManager::CopyImage(VkCommandBuffer cmdBuffer, const ImageCopyInfo& info)
 	{
 		assert(info.regionCount > 0);
@@ -506,6 +558,27 @@ namespace Renderer
 				return false;
 			}
 		}
+		//Used for tileable volumes
+		sampler = SAMPLER_REPEAT;
+		{
+			VkSamplerCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+			info.magFilter = VK_FILTER_LINEAR;
+			info.minFilter = VK_FILTER_LINEAR;
+			info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+			info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			info.minLod = -1000;
+			info.maxLod = 1000;
+			info.maxAnisotropy = 1.0f;
+			const auto result = vkCreateSampler(device, &info, nullptr, &samplers_[sampler]);
+			if (result != VK_SUCCESS)
+			{
+				printf("Failed creating image sampler, %d\n", result);
+				return false;
+			}
+		}
     return true;
   }
 
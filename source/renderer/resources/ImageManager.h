@@ -47,6 +47,7 @@ namespace Renderer
       SAMPLER_LINEAR,
       SAMPLER_GRID,
 			SAMPLER_SHADOW,
+			SAMPLER_REPEAT,
       SAMPLER_MAX,
       SAMPLER_NONE
     };
@@ -125,6 +126,9 @@ namespace Renderer
 
 		void CopyImageToBuffer(QueueManager* queueManager, VkBuffer buffer, const std::vector<VkBufferImageCopy>& copyRegions, 
 			VkImageLayout layout, int imageIndex, bool refactoring);
+		//Waits until the copy finished, the image keeps its layout
+		void CopyBufferToImage(QueueManager* queueManager, VkBuffer buffer, const std::vector<VkBufferImageCopy>& copyRegions,
+			VkImageLayout layout, int imageIndex, bool refactoring);
 		
 		struct ImageCopyInfo
 		{
@@ -152,6 +156,7 @@ namespace Renderer
       MEMORY_POOL_SCENE,
       MEMORY_POOL_GRID,
 			MEMORY_POOL_GRID_MIPMAP,
+			MEMORY_POOL_GRID_LIGHT,
       MEMORY_POOL_CONSTANT,
 			MEMORY_POOL_INDIVIDUAL,
       MEMORY_POOL_MAX
@@ -183,6 +188,7 @@ namespace Renderer
 
     const VkDescriptorImageInfo& Ref_GetDescriptorInfo(int index) const;
     const VkImageView& Ref_GetImageView(int index) const { return Ref_imageViews_[index]; }
+    const VkImage& Ref_GetImage(int index) const { return Ref_images_[index]; }
     const VkImageView& Ref_GetArrayImageView(int imageIndex, int arrayOffset) const
       { return Ref_arrayImageViews_.at(imageIndex)[arrayOffset]; }
   private:
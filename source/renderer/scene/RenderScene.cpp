@@ -24,6 +24,7 @@ SOFTWARE.
 
 #include "RenderScene.h"
 
+#include <chrono>
 #include <glm\gtc\matrix_transform.hpp>
 
 #include "..\..\scene\Scene.h"
@@ -37,6 +38,8 @@ SOFTWARE.
 #include "..\passes\GuiPass.h"
 #include "..\passResources\ShaderBindingManager.h"
 
+#include "..\..\utility\Profiler.h"
+
 
 namespace Renderer
 {
@@ -149,6 +152,7 @@ namespace Renderer
     bufferData_[MeshData::BUFFER_WORLD_INV_TRANSPOSE].clear();
     int offset = static_cast<int>(meshes.data().size());
     int index = 0;
+    std::vector<AxisAlignedBoundingBox> meshBoundingBoxes;
     bufferData_[MeshData::BUFFER_WORLD_INV_TRANSPOSE].resize(offset * 2);
     for (auto it = meshes.begin(); it != meshes.end(); ++it)
     {
@@ -159,14 +163,25 @@ namespace Renderer
       meshData_.materialIndices_.push_back(matMappings.at(meshInfo.materialName));
 
       world_.push_back(transforms[it->first].CalcTransform());
+      meshBoundingBoxes.push_back(scene->GetBoundingBoxes()[it->first]);
       bufferData_[MeshData::BUFFER_WORLD_INV_TRANSPOSE][index] = world_.back();
       bufferData_[MeshData::BUFFER_WORLD_INV_TRANSPOSE][index + offset]
         = glm::transpose(glm::inverse(world_.back()));
       ++index;
     }
 
+    meshBoxes_.SetBoxes(meshBoundingBoxes);
+    {
+      const auto buildStart = std::chrono::high_resolution_clock::now();
+      meshHierarchy_.Build(meshBoundingBoxes);
+      const std::chrono::duration<float, std::milli> buildTime = std::chrono::high_resolution_clock::now() - buildStart;
+      GuiPass::SetHierarchyBuildTime(buildTime.count());
+    }
+    adaptiveGrid_->SetSceneHierarchy(&meshHierarchy_);
+
     transformsChanged_ = true;
     sceneLoaded_ = true;
+    shadowMap_->InvalidateCascades();
 
     return true;
   }
@@ -193,6 +208,7 @@ namespace Renderer
 
   void RenderScene::Update(Scene* scene, BufferManager* bufferManager, ImageManager* imageManager, Surface* surface, int frameIndex)
   {
+    PROFILE_SCOPE("RenderScene::Update");
     if (sceneLoaded_)
     {
       const auto& lightingState = GuiPass::GetLightingState();
@@ -200,33 +216,35 @@ namespace Renderer
 
       if (!GuiPass::GetMenuState().fixCameraFrustum)
       {
-        cameraFrustum_.ExtractPlanes(scene->GetCamera().GetProj());
+        cameraFrustum_.ExtractPlanes(scene->GetCamera().GetViewProj());
       }
 
-      //only copy all mesh indices at the moment
-      activeMeshes_[SUBPASS_MESH].clear();
-      activeMeshes_[SUBPASS_SHADOW_MAP].clear();
-      bufferData_[MeshData::BUFFER_WORLD_VIEW_PROJ].clear();
-      bufferData_[MeshData::BUFFER_WORLD_VIEW_PROJ_LIGHT].clear();
-
-      const auto& viewProj = scene->GetCamera().GetViewProj();
-      const auto& lightViewProjs = shadowMap_->GetViewProjs();
+      const bool hierarchicalCulling = GuiPass::GetPerformanceState().hierarchicalCulling;
+      const auto cullingStart = std::chrono::high_resolution_clock::now();
 
-      bufferData_[MeshData::BUFFER_WORLD_VIEW_PROJ_LIGHT].resize(meshData_.indexCounts_.size() * shadowMap_->GetCascadeCount());
-      for (int i = 0; i < static_cast<int>(meshData_.indexCounts_.size()); ++i)
+      //Planes are in world space, a fixed frustum keeps culling with the old planes
+      auto& visibleMeshes = activeMeshes_[SUBPASS_MESH];
+      if (hierarchicalCulling)
       {
-        const auto& world = world_[i];
-
-        activeMeshes_[SUBPASS_MESH].push_back(i);
-        bufferData_[MeshData::BUFFER_WORLD_VIEW_PROJ].push_back(viewProj * world);
+        cameraFrustum_.Cull(meshHierarchy_, visibleMeshes);
+      }
+      else
+      {
+        cameraFrustum_.Cull(meshBoxes_, visibleMeshes);
+      }
 
-        activeMeshes_[SUBPASS_SHADOW_MAP].push_back(i);
-        for (size_t cascade = 0; cascade < shadowMap_->GetCascadeCount(); ++cascade)
-        {
-          bufferData_[MeshData::BUFFER_WORLD_VIEW_PROJ_LIGHT][i + cascade * meshData_.indexCounts_.size()]
-            = (lightViewProjs[cascade] * world);
-        }
+      //Matrices stay indexed by mesh, only the visible ones are updated
+      auto& worldViewProj = bufferData_[MeshData::BUFFER_WORLD_VIEW_PROJ];
+      worldViewProj.resize(meshData_.indexCounts_.size());
+      const auto& viewProj = scene->GetCamera().GetViewProj();
+      for (const auto index : visibleMeshes)
+      {
+        worldViewProj[index] = viewProj * world_[index];
       }
+      CullShadowCasters(hierarchicalCulling);
+
+      const std::chrono::duration<float, std::milli> cullingTime = std::chrono::high_resolution_clock::now() - cullingStart;
+      GuiPass::SetCullingTime(cullingTime.count());
 
       UpdatePerFrameBuffers(bufferManager, frameIndex);
 
@@ -234,6 +252,67 @@ namespace Renderer
     }
   }
 
+  void RenderScene::CullShadowCasters(bool hierarchicalCulling)
+  {
+    const int cascadeCount = shadowMap_->GetCascadeCount();
+    bool cascadeUpdated = false;
+    for (int cascade = 0; cascade < cascadeCount; ++cascade)
+    {
+      cascadeUpdated = cascadeUpdated || shadowMap_->CascadeUpdated(cascade);
+    }
+    if (!cascadeUpdated)
+    {
+      return;
+    }
+
+    //The light view only rotates, the mesh bounds are transformed once for all cascades
+    const auto& lightView = shadowMap_->GetLightView();
+    if (!hierarchicalCulling)
+    {
+      meshBoxes_.Transform(lightView, lightSpaceMeshBoxes_);
+    }
+
+    const auto& lightViewProjs = shadowMap_->GetViewProjs();
+    const auto& casterBounds = shadowMap_->GetCasterBounds();
+    const size_t meshCount = meshData_.indexCounts_.size();
+    auto& lightMatrices = bufferData_[MeshData::BUFFER_WORLD_VIEW_PROJ_LIGHT];
+    lightMatrices.resize(meshCount * cascadeCount);
+    for (int cascade = 0; cascade < cascadeCount; ++cascade)
+    {
+      //Cached cascades are not rendered this frame
+      if (!shadowMap_->CascadeUpdated(cascade))
+      {
+        continue;
+      }
+
+      auto& casters = shadowCasters_[cascade];
+      casters.clear();
+      if (hierarchicalCulling)
+      {
+        //The faces of the light space bounds are world space planes for the hierarchy
+        const auto& bounds = casterBounds[cascade];
+        const glm::mat4 planeTransform = glm::transpose(lightView);
+        const std::array<glm::vec4, 6> planes = {
+          planeTransform * glm::vec4(1, 0, 0, -bounds.min.x),
+          planeTransform * glm::vec4(-1, 0, 0, bounds.max.x),
+          planeTransform * glm::vec4(0, 1, 0, -bounds.min.y),
+          planeTransform * glm::vec4(0, -1, 0, bounds.max.y),
+          planeTransform * glm::vec4(0, 0, 1, -bounds.min.z),
+          planeTransform * glm::vec4(0, 0, -1, bounds.max.z)
+        };
+        meshHierarchy_.InsidePlanes(planes.data(), static_cast<int>(planes.size()), casters);
+      }
+      else
+      {
+        lightSpaceMeshBoxes_.Overlap(casterBounds[cascade], casters);
+      }
+      for (const auto i : casters)
+      {
+        lightMatrices[i + cascade * meshCount] = lightViewProjs[cascade] * world_[i];
+      }
+    }
+  }
+
   void RenderScene::BindMeshData(BufferManager* bufferManager, VkCommandBuffer commandBuffer)
   {
     if (sceneLoaded_)
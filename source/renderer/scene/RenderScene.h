@@ -32,6 +32,8 @@ SOFTWARE.
 
 #include "renderables\MeshData.h"
 #include "renderables\Frustum.h"
+#include "renderables\CullingBoxes.h"
+#include "renderables\BoundingVolumeHierarchy.h"
 #include "renderables\Material.h"
 
 #include "adaptiveGrid\AdaptiveGrid.h"
@@ -65,6 +67,8 @@ namespace Renderer
     void BindMeshMaterial(VkCommandBuffer commandBuffer, ShaderBindingManager* bindingManager, int index);
 
     const std::vector<int>& GetMeshIndices(SubPassType subpass) const;
+    //Meshes overlapping the light space bounds of the cascade, only valid for updated cascades
+    const std::vector<int>& GetShadowCasters(int cascade) const { return shadowCasters_[cascade]; }
     const MeshData& GetMeshData() const;
 
     ShadowMap* GetShadowMap() { return shadowMap_.get(); }
@@ -74,11 +78,18 @@ namespace Renderer
     void UpdatePerFrameBuffers(BufferManager* bufferManager, int frameIndex);
     std::vector<VkDeviceSize> ResizeMeshBuffers(BufferManager* bufferManager);
     void ResizeTransformBuffers(BufferManager* bufferManager);
+    //Builds the caster lists and light matrices of all cascades rendered this frame
+    void CullShadowCasters(bool hierarchicalCulling);
 
     MeshData meshData_;
     Frustum cameraFrustum_;
 
     std::map<SubPassType, std::vector<int>> activeMeshes_;
+    std::array<std::vector<int>, g_cascadeCount> shadowCasters_;
+    //World space bounding boxes of the meshes and their bounds in light space
+    CullingBoxes meshBoxes_;
+    CullingBoxes lightSpaceMeshBoxes_;
+    BoundingVolumeHierarchy meshHierarchy_;
     std::vector<Material> materials_;
 
     std::vector<glm::mat4> world_;
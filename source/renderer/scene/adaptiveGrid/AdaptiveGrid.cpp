@@ -37,8 +37,14 @@ SOFTWARE.
 #include "..\..\wrapper\QueryPool.h"
 
 #include "..\..\..\scene\Scene.h"
+#include "..\renderables\BoundingVolumeHierarchy.h"
 
 #include "..\..\..\utility\Status.h"
+#include "..\..\..\utility\Math.h"
+#include "..\..\..\utility\InputRecording.h"
+#include "..\..\..\utility\Profiler.h"
+#include "..\..\..\fileIO\FileDialog.h"
+#include "..\..\..\fileIO\GridSnapshot.h"
 
 #include "AdaptiveGridConstants.h"
 #include "debug\DebugData.h"
@@ -48,11 +54,12 @@ SOFTWARE.
 #include <glm\gtx\component_wise.hpp>
 #include <random>
 #include <functional>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
 
 namespace Renderer
 {
-	constexpr int debugScreenDivision_ = 1;
-
 	AdaptiveGrid::AdaptiveGrid(float worldCellSize) :
 		worldCellSize_{ worldCellSize },
 		imageAtlas_{GridConstants::imageResolution}
@@ -149,6 +156,13 @@ namespace Renderer
 			bufferInfo.data = gridLevelData_.data();
 			cbIndices_[cbIndex] = bufferManager->Ref_RequestBuffer(bufferInfo);
 		}
+		cbIndex = CB_RAYMARCHING_STATISTICS;
+		{
+			//Written on the gpu, no automatic update of the buffer content
+			bufferInfo.data = nullptr;
+			bufferInfo.size = sizeof(RaymarchingStatistics);
+			cbIndices_[cbIndex] = bufferManager->Ref_RequestBuffer(bufferInfo);
+		}
 
 		{
 			BufferManager::BufferInfo gridBufferInfo;
@@ -170,10 +184,18 @@ namespace Renderer
 		debugFilling_.SetGpuResources(atlasImageIndex, atlasBufferIndex);
 
 		globalVolume_.RequestResources(bufferManager, frameCount, atlasImageIndex);
-		groundFog_.RequestResources(imageManager, bufferManager, frameCount, atlasImageIndex);
+		noiseVolume_.RequestResources(imageManager, bufferManager);
+		groundFog_.RequestResources(imageManager, bufferManager, frameCount, atlasImageIndex,
+			noiseVolume_.GetImageIndex(), noiseVolume_.GetTextureScale());
+		smokeVolumes_.RequestResources(bufferManager, frameCount, atlasImageIndex);
+		densityGrids_.RequestResources(bufferManager);
 		particleSystems_.RequestResources(bufferManager, frameCount, atlasImageIndex);
-		mipMapping_.RequestResources(imageManager, bufferManager, frameCount, atlasImageIndex);
+		mipMapping_.RequestResources(bufferManager, frameCount, atlasImageIndex, gpuResources_[GPU_BUFFER_NODE_INFOS].index);
 		neighborCells_.RequestResources(bufferManager, frameCount, atlasImageIndex);
+		temporalFilter_.RequestResources(bufferManager, frameCount);
+		tileClassification_.RequestResources(bufferManager, frameCount);
+		froxelVolume_.RequestResources(imageManager);
+		lightTransmittance_.RequestResources(imageManager, bufferManager, frameCount);
 
 		for (size_t i = 0; i < gpuResources_.size(); ++i)
 		{
@@ -181,9 +203,11 @@ namespace Renderer
 		}
 	}
 
-	void AdaptiveGrid::SetImageIndices(int raymarching, int depth, int shadowMap, int noise)
+	void AdaptiveGrid::SetImageIndices(int raymarching, int raymarchingHistory, int raymarchingResolved,
+		int depth, int shadowMap, int noise)
 	{
 		raymarchingImageIndex_ = raymarching;
+		temporalFilter_.SetImageIndices(raymarching, raymarchingHistory, raymarchingResolved, depth);
 
 		//TODO to test the image atlas 
 		//raymarchingImageIndex_ = mipMapping_.GetImageAtlasIndex();
@@ -202,7 +226,34 @@ namespace Renderer
 
 	void AdaptiveGrid::OnLoadScene(const Scene* scene)
 	{
+		smokeVolumes_.OnLoadScene(scene, worldBoundingBox_, gridLevels_.back().GetGridCellSize());
+		densityGrids_.OnLoadScene(scene, worldBoundingBox_, gridLevels_.back().GetGridCellSize());
 		particleSystems_.OnLoadScene(scene);
+		ReleaseFrozenGrid();
+		//Nothing was dispatched before a scene was loaded
+		groundFog_.InvalidateCache();
+		mipMapping_.InvalidateContent();
+	}
+
+	AxisAlignedBoundingBox AdaptiveGrid::CalcNodeBounds(int level, int nodeIndex) const
+	{
+		//Node positions are relative to the parent node in cells of their own level
+		glm::vec3 nodeMin = worldBoundingBox_.min;
+		for (int currLevel = level, currNode = nodeIndex; currLevel >= 0; --currLevel)
+		{
+			const auto& nodeData = gridLevels_[currLevel].GetNodeData();
+			nodeMin += nodeData.gridPos_[currNode] * gridLevels_[currLevel].GetGridCellSize();
+			currNode = nodeData.parentIndices_[currNode];
+		}
+		return { nodeMin, nodeMin + glm::vec3(gridLevels_[level].GetGridCellSize()) };
+	}
+
+	void AdaptiveGrid::QueryNodeGeometry(int level, int nodeIndex, std::vector<int>& meshIndices) const
+	{
+		if (sceneHierarchy_ != nullptr && nodeIndex < gridLevels_[level].GetNodeCount())
+		{
+			sceneHierarchy_->Overlap(CalcNodeBounds(level, nodeIndex), meshIndices);
+		}
 	}
 
 	void AdaptiveGrid::UpdateParticles(float dt)
@@ -219,19 +270,34 @@ namespace Renderer
 			return globalVolume_.GetShaderBinding(bindingManager, frameCount_);
 		case GRID_PASS_GROUND_FOG:
 			return groundFog_.GetShaderBinding(bindingManager, frameCount_);
+		case GRID_PASS_SMOKE:
+			return smokeVolumes_.GetShaderBinding(bindingManager, frameCount_);
 		case GRID_PASS_PARTICLES:
 			return particleSystems_.GetShaderBinding(bindingManager, frameCount_);
 		case GRID_PASS_DEBUG_FILLING:
 			return debugFilling_.GetShaderBinding(bindingManager, frameCount_);
 		case GRID_PASS_MIPMAPPING:
-			return mipMapping_.GetShaderBinding(bindingManager, frameCount_, pass - GRID_PASS_MIPMAPPING);
-		case GRID_PASS_MIPMAPPING_MERGING:
-			return mipMapping_.GetShaderBinding(bindingManager, frameCount_, pass - GRID_PASS_MIPMAPPING);
+			return mipMapping_.GetShaderBinding(bindingManager, frameCount_);
 		case GRID_PASS_NEIGHBOR_UPDATE:
 			return neighborCells_.GetShaderBinding(bindingManager, frameCount_);
+		case GRID_PASS_TEMPORAL:
+			return temporalFilter_.GetShaderBinding(bindingManager, frameCount_);
+		case GRID_PASS_LIGHT_TRANSMITTANCE:
+		case GRID_PASS_FROXEL:
 		case GRID_PASS_RAYMARCHING:
 		{
-			bindingInfo.pass = SUBPASS_VOLUME_ADAPTIVE_RAYMARCHING;
+			switch (pass)
+			{
+			case GRID_PASS_LIGHT_TRANSMITTANCE:
+				bindingInfo.pass = SUBPASS_VOLUME_ADAPTIVE_LIGHT_TRANSMITTANCE;
+				break;
+			case GRID_PASS_FROXEL:
+				bindingInfo.pass = SUBPASS_VOLUME_ADAPTIVE_FROXEL;
+				break;
+			default:
+				bindingInfo.pass = SUBPASS_VOLUME_ADAPTIVE_RAYMARCHING;
+				break;
+			}
 			bindingInfo.resourceIndex = {
 				raymarchingImageIndex_,
 				depthImageIndex_,
@@ -244,7 +310,10 @@ namespace Renderer
 				gpuResources_[GPU_BUFFER_BIT_COUNTS].index,
 				gpuResources_[GPU_BUFFER_CHILDS].index,
 				cbIndices_[CB_RAYMARCHING],
-				cbIndices_[CB_RAYMARCHING_LEVELS]
+				cbIndices_[CB_RAYMARCHING_LEVELS],
+				cbIndices_[CB_RAYMARCHING_STATISTICS],
+				tileClassification_.GetBufferIndex(),
+				lightTransmittance_.GetImageIndex()
 			};
 			bindingInfo.stages = {
 				VK_SHADER_STAGE_COMPUTE_BIT,
@@ -257,6 +326,9 @@ namespace Renderer
 				VK_SHADER_STAGE_COMPUTE_BIT,
 				VK_SHADER_STAGE_COMPUTE_BIT,
 				VK_SHADER_STAGE_COMPUTE_BIT,
+				VK_SHADER_STAGE_COMPUTE_BIT,
+				VK_SHADER_STAGE_COMPUTE_BIT,
+				VK_SHADER_STAGE_COMPUTE_BIT,
 				VK_SHADER_STAGE_COMPUTE_BIT };
 			bindingInfo.types = {
 				VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
@@ -269,9 +341,30 @@ namespace Renderer
 				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
 				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
 				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
-			bindingInfo.refactoring_ = { false, false, true, true, true, true, true, true, true, true, true };
+				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER };
+			bindingInfo.refactoring_ = { false, false, true, true, true, true, true, true, true, true, true, true, true, true };
 			bindingInfo.setCount = frameCount_;
+			//The froxel integration uses the same resources and writes into the froxel volume
+			if (pass == GRID_PASS_FROXEL)
+			{
+				bindingInfo.resourceIndex.push_back(froxelVolume_.GetImageIndex());
+				bindingInfo.stages.push_back(VK_SHADER_STAGE_COMPUTE_BIT);
+				bindingInfo.types.push_back(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+				bindingInfo.refactoring_.push_back(true);
+			}
+			//The light transmittance pass writes into the light atlas
+			else if (pass == GRID_PASS_LIGHT_TRANSMITTANCE)
+			{
+				bindingInfo.resourceIndex.insert(bindingInfo.resourceIndex.end(), {
+					lightTransmittance_.GetImageIndex(), lightTransmittance_.GetBufferIndex() });
+				bindingInfo.stages.insert(bindingInfo.stages.end(), 2, VK_SHADER_STAGE_COMPUTE_BIT);
+				bindingInfo.types.insert(bindingInfo.types.end(), {
+					VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER });
+				bindingInfo.refactoring_.insert(bindingInfo.refactoring_.end(), 2, true);
+			}
 		}break;
 		default:
 			printf("Get shader bindings from adaptive grid for invalid type\n");
@@ -282,13 +375,65 @@ namespace Renderer
 
 	void AdaptiveGrid::Update(BufferManager* bufferManager, ImageManager* imageManager, Scene* scene, Surface* surface, ShadowMap* shadowMap, int frameIndex)
 	{
+		PROFILE_SCOPE("AdaptiveGrid::Update");
+		UpdateRaymarchingStatistics(bufferManager, frameIndex);
+
+		const auto& performanceState = GuiPass::GetPerformanceState();
+		//Values collected before the statistics were disabled are outdated
+		if (performanceState.gridStatistics && !statistics_.enabled)
+		{
+			statistics_.Reset();
+		}
+		statistics_.enabled = performanceState.gridStatistics;
+		auto stageStart = std::chrono::high_resolution_clock::now();
+		const auto EndStage = [&](GridStatistics::Stage stage)
+		{
+			if (statistics_.enabled)
+			{
+				const auto stageEnd = std::chrono::high_resolution_clock::now();
+				statistics_.stageTimes[stage] = std::chrono::duration<float, std::milli>(stageEnd - stageStart).count();
+				stageStart = stageEnd;
+			}
+		};
+
 		UpdateCBData(scene, surface, shadowMap);
+		EndStage(GridStatistics::STAGE_UPDATE_CB_DATA);
 
-		UpdateGrid(scene);
+		//A frozen grid keeps the nodes and the atlas of its snapshot
+		if (!frozenGrid_.IsOpen())
+		{
+			UpdateGrid(scene);
+		}
+		EndStage(GridStatistics::STAGE_UPDATE_GRID);
+		{
+			PROFILE_SCOPE("TileClassification::Update");
+			const auto& volumeState = GuiPass::GetVolumeState();
+			//The nodes of a frozen grid are not known on the cpu, all tiles are traversed
+			tileClassification_.Update(scene->GetCamera().GetViewProj(), raymarchingData_.screenSize, &gridLevels_[1],
+				groundFog_.GetCoveredBounds(), raymarchingData_.gridMinPosition, globalMediumData_.extinction > 0.0f, 
+				volumeState.tileClassification && !frozenGrid_.IsOpen());
+			GuiPass::SetTileCounts(tileClassification_.GetTileCount(TileClassification::TILE_FULL),
+				tileClassification_.GetTileCount(TileClassification::TILE_GLOBAL),
+				tileClassification_.GetTileCount(TileClassification::TILE_EMPTY));
+		}
+		//Tile classification is not part of the timed stages
+		stageStart = std::chrono::high_resolution_clock::now();
 		ResizeGpuResources(bufferManager, imageManager);
+		EndStage(GridStatistics::STAGE_RESIZE_GPU_RESOURCES);
 		UpdateGpuResources(bufferManager, frameIndex);
+		EndStage(GridStatistics::STAGE_UPDATE_GPU_RESOURCES);
+
+		GuiPass::SetGridStatistics(statistics_.enabled ? &statistics_ : nullptr);
+		if (performanceState.saveGridStatistics)
+		{
+			const auto filePath = FileIO::SaveFileDialog(L"json");
+			if (!filePath.empty())
+			{
+				statistics_.SaveJson(filePath);
+			}
+		}
 
-		if (GuiPass::GetDebugVisState().nodeRendering)
+		if (GuiPass::GetDebugVisState().nodeRendering && !frozenGrid_.IsOpen())
 		{
 			UpdateBoundingBoxes();
 		}
@@ -297,17 +442,28 @@ namespace Renderer
 	void AdaptiveGrid::Dispatch(QueueManager* queueManager, ImageManager* imageManager, BufferManager* bufferManager,
 		VkCommandBuffer commandBuffer, Pass pass, int frameIndex, int level)
 	{
+		//The atlas of a frozen grid already contains the filled and mip mapped images
+		if (frozenGrid_.IsOpen() && pass < GRID_PASS_LIGHT_TRANSMITTANCE)
+		{
+			return;
+		}
 		switch (pass)
 		{
 		case GRID_PASS_GLOBAL:
 		{
-			globalVolume_.Dispatch(imageManager, commandBuffer, frameIndex);
+			globalVolume_.Dispatch(imageManager, bufferManager, commandBuffer, frameIndex);
+			//The brick regions are not cleared so both copies can run without synchronization
+			densityGrids_.Dispatch(imageManager, bufferManager, commandBuffer, imageAtlas_.GetImageIndex());
 		}
 		break;
 		case GRID_PASS_GROUND_FOG:
-		{			
+		{
+			noiseVolume_.Upload(imageManager, bufferManager, commandBuffer);
 			groundFog_.Dispatch(queueManager, imageManager, bufferManager, commandBuffer, frameIndex);
 		}	break;
+		case GRID_PASS_SMOKE:
+			smokeVolumes_.Dispatch(imageManager, commandBuffer, frameIndex);
+			break;
 		case GRID_PASS_PARTICLES:
 			particleSystems_.Dispatch(imageManager, commandBuffer, frameIndex);
 			break;
@@ -316,50 +472,56 @@ namespace Renderer
 			break;
 		case GRID_PASS_MIPMAPPING:
 			mipMappingStarted_ = true;
-		case GRID_PASS_MIPMAPPING_MERGING:
-			mipMapping_.Dispatch(imageManager, bufferManager, commandBuffer, frameIndex, level, pass - GRID_PASS_MIPMAPPING);
+			mipMapping_.Dispatch(imageManager, commandBuffer, frameIndex, level);
 			break;
 		case GRID_PASS_NEIGHBOR_UPDATE:
 		{
 			neighborCells_.Dispatch(commandBuffer, imageManager, level, mipMappingStarted_, frameIndex);
 		}
 		break;
+		case GRID_PASS_LIGHT_TRANSMITTANCE:
+			if (initialized_)
+			{
+				lightTransmittance_.Dispatch(imageManager, commandBuffer, frameIndex);
+			}
+			break;
+		case GRID_PASS_FROXEL:
+			if (initialized_ && GuiPass::GetVolumeState().froxelIntegration)
+			{
+				froxelVolume_.Dispatch(commandBuffer, frameIndex);
+			}
+			break;
 		case GRID_PASS_RAYMARCHING:
 			mipMappingStarted_ = false;
 			break;
+		case GRID_PASS_TEMPORAL:
+			if (initialized_ && !GuiPass::GetVolumeState().froxelIntegration)
+			{
+				temporalFilter_.Dispatch(imageManager, commandBuffer, frameIndex);
+			}
+			break;
 		default:
 			break;
 		}
 	}
 	
-	namespace
-  {
-    uint32_t CalcDispatchSize(uint32_t number, uint32_t multiple)
-    {
-      if (number % multiple == 0)
-      {
-        return number / multiple;
-      }
-      else
-      {
-        return number / multiple + 1;
-      }
-    }
-  }
-
-  void AdaptiveGrid::Raymarch(ImageManager* imageManager, VkCommandBuffer commandBuffer, uint32_t width, uint32_t height, int frameIndex)
+  void AdaptiveGrid::Raymarch(ImageManager* imageManager, BufferManager* bufferManager, VkCommandBuffer commandBuffer, int frameIndex)
   {
     if (initialized_)
     {
-			const uint32_t dispatchX = CalcDispatchSize(width / debugScreenDivision_, 16);
-      const uint32_t dispatchY = CalcDispatchSize(height / debugScreenDivision_, 16);
+			//The froxel volume replaces the per pixel raymarching
+			if (!GuiPass::GetVolumeState().froxelIntegration)
+			{
+				//Tiles cover only the upper left part of the image for reduced resolutions
+				tileClassification_.ClearEmptyTiles(imageManager, commandBuffer, raymarchingImageIndex_);
 
-			auto& queryPool = Wrapper::QueryPool::GetInstance();
-			queryPool.TimestampStart(commandBuffer, Wrapper::TIMESTAMP_GRID_RAYMARCHING, frameIndex);
+				auto& queryPool = Wrapper::QueryPool::GetInstance();
+				queryPool.TimestampStart(commandBuffer, Wrapper::TIMESTAMP_GRID_RAYMARCHING, frameIndex);
 
-			vkCmdDispatch(commandBuffer, dispatchX, dispatchY, 1);
+				tileClassification_.Dispatch(bufferManager, commandBuffer, frameIndex);
 
-			queryPool.TimestampEnd(commandBuffer, Wrapper::TIMESTAMP_GRID_RAYMARCHING, frameIndex);
+				queryPool.TimestampEnd(commandBuffer, Wrapper::TIMESTAMP_GRID_RAYMARCHING, frameIndex);
+			}
 
 			ImageManager::BarrierInfo imageAtlasBarrier{};
 			imageAtlasBarrier.imageIndex = imageAtlas_.GetImageIndex();
@@ -383,7 +545,7 @@ namespace Renderer
 		if (volumeState.debugTraversal && !previousFrameTraversal_)
 		{
 			previousFrameTraversal_ = true;
-			const glm::ivec2 position = static_cast<glm::ivec2>(volumeState.cursorPosition);
+			const glm::ivec2 position = static_cast<glm::ivec2>(volumeState.cursorPosition) / resolutionDivision_;
 			debugTraversal_.Traversal(queueManager, bufferManager, imageManager, position.x, position.y);
 		}
 		else
@@ -392,8 +554,190 @@ namespace Renderer
 		}
 	}
 
+	void AdaptiveGrid::UpdateSnapshots(QueueManager* queueManager, BufferManager* bufferManager, ImageManager* imageManager,
+		int frameIndex)
+	{
+		const auto& menuState = GuiPass::GetMenuState();
+		if (menuState.saveGridSnapshot)
+		{
+			if (frozenGrid_.IsOpen())
+			{
+				printf("The frozen grid is already stored in a snapshot\n");
+			}
+			else
+			{
+				const auto filePath = FileIO::SaveFileDialog(L"vgrid");
+				if (!filePath.empty())
+				{
+					SaveSnapshot(queueManager, bufferManager, imageManager, filePath, frameIndex);
+				}
+			}
+		}
+		if (menuState.loadGridSnapshot)
+		{
+			//Cancelling the dialog switches the debug traversal back to the current grid
+			DebugData::LoadSnapshot(FileIO::OpenFileDialog(L"vgrid"), static_cast<uint32_t>(gridLevels_.size()));
+		}
+		if (menuState.loadFrozenGrid)
+		{
+			//Cancelling the dialog updates the grid again
+			LoadFrozenGrid(queueManager, bufferManager, imageManager, FileIO::OpenFileDialog(L"vgrid"));
+		}
+	}
+
+	void AdaptiveGrid::SaveSnapshot(QueueManager* queueManager, BufferManager* bufferManager, ImageManager* imageManager,
+		const std::string& path, int frameIndex)
+	{
+		//The atlas is filled by the submitted frame which used the current node data
+		vkQueueWaitIdle(queueManager->GetQueue(QueueManager::QUEUE_COMPUTE));
+
+		const auto totalSizes = GetGpuResourceSize();
+		std::array<std::vector<char>, GPU_MAX> bufferData;
+		for (int i = 0; i < GPU_MAX; ++i)
+		{
+			bufferData[i].resize(totalSizes[i]);
+			//The mip mapping writes the extinction and scattering ranges of the node infos on the gpu
+			if (i == GPU_BUFFER_NODE_INFOS)
+			{
+				const auto dataPtr = bufferManager->Ref_Map(gpuResources_[i].index, frameIndex, BufferManager::BUFFER_GRID_BIT);
+				memcpy(bufferData[i].data(), dataPtr, totalSizes[i]);
+				bufferManager->Ref_Unmap(gpuResources_[i].index, frameIndex, BufferManager::BUFFER_GRID_BIT);
+				continue;
+			}
+			int offset = 0;
+			for (auto& level : gridLevels_)
+			{
+				offset = level.CopyBufferData(bufferData[i].data(), static_cast<GridLevel::BufferType>(i), offset);
+			}
+		}
+
+		const int atlasImageIndex = imageAtlas_.GetImageIndex();
+		const auto atlasExtent = imageManager->Ref_GetImageInfo(atlasImageIndex).extent;
+		BufferManager::BufferInfo bufferInfo;
+		bufferInfo.bufferingCount = 1;
+		bufferInfo.pool = BufferManager::MEMORY_TEMP;
+		bufferInfo.size = imageManager->Ref_GetImageSize(atlasImageIndex);
+		bufferInfo.typeBits = BufferManager::BUFFER_TEMP_BIT;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		const int tempBufferIndex = bufferManager->RequestBuffer(bufferInfo);
+
+		VkBufferImageCopy copyRegion = {};
+		copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copyRegion.imageSubresource.layerCount = 1;
+		copyRegion.imageExtent = atlasExtent;
+		imageManager->CopyImageToBuffer(queueManager,
+			bufferManager->GetBuffer(tempBufferIndex, BufferManager::BUFFER_TEMP_BIT),
+			{ copyRegion }, VK_IMAGE_LAYOUT_GENERAL, atlasImageIndex, true);
+
+		const auto bufferBits = BufferManager::BUFFER_TEMP_BIT;
+		//R16G16B16A16_SFLOAT texels
+		const VkDeviceSize atlasSize = static_cast<VkDeviceSize>(atlasExtent.width) * atlasExtent.height * 
+			atlasExtent.depth * 4 * sizeof(uint16_t);
+
+		std::array<FileIO::SnapshotData, FileIO::SNAPSHOT_MAX> sections;
+		sections[FileIO::SNAPSHOT_RAYMARCHING] = { &raymarchingData_, sizeof(RaymarchingData) };
+		sections[FileIO::SNAPSHOT_LEVELS] = { gridLevelData_.data(), gridLevelData_.size() * sizeof(LevelData) };
+		sections[FileIO::SNAPSHOT_NODE_INFOS] = { bufferData[GPU_BUFFER_NODE_INFOS].data(), totalSizes[GPU_BUFFER_NODE_INFOS] };
+		sections[FileIO::SNAPSHOT_ACTIVE_BITS] = { bufferData[GPU_BUFFER_ACTIVE_BITS].data(), totalSizes[GPU_BUFFER_ACTIVE_BITS] };
+		sections[FileIO::SNAPSHOT_BIT_COUNTS] = { bufferData[GPU_BUFFER_BIT_COUNTS].data(), totalSizes[GPU_BUFFER_BIT_COUNTS] };
+		sections[FileIO::SNAPSHOT_CHILDS] = { bufferData[GPU_BUFFER_CHILDS].data(), totalSizes[GPU_BUFFER_CHILDS] };
+		sections[FileIO::SNAPSHOT_ATLAS] = { bufferManager->Map(tempBufferIndex, bufferBits), std::min(atlasSize, bufferInfo.size) };
+		if (FileIO::SaveGridSnapshot(path, sections, static_cast<uint32_t>(gridLevels_.size()),
+			static_cast<uint32_t>(imageAtlas_.GetSideLength()), atlasExtent.width))
+		{
+			printf("Saved grid snapshot %s\n", path.c_str());
+		}
+
+		bufferManager->Unmap(tempBufferIndex, bufferBits);
+		bufferManager->ReleaseTempBuffer(tempBufferIndex);
+	}
+
+	void AdaptiveGrid::LoadFrozenGrid(QueueManager* queueManager, BufferManager* bufferManager, ImageManager* imageManager,
+		const std::string& path)
+	{
+		//The atlas is overwritten and possibly recreated, no submitted frame may use it anymore
+		vkQueueWaitIdle(queueManager->GetQueue(QueueManager::QUEUE_COMPUTE));
+		vkQueueWaitIdle(queueManager->GetQueue(QueueManager::QUEUE_GRAPHICS));
+		ReleaseFrozenGrid();
+		if (path.empty() || !frozenGrid_.Open(path))
+		{
+			return;
+		}
+		if (!DebugData::MatchesGridLayout(frozenGrid_, static_cast<uint32_t>(gridLevels_.size()), path))
+		{
+			frozenGrid_.Close();
+			return;
+		}
+
+		//Only the nodes and images are taken from the snapshot, the world extent of the grid has to be the same
+		const auto& snapshotData = *reinterpret_cast<const RaymarchingData*>(frozenGrid_.GetSection(FileIO::SNAPSHOT_RAYMARCHING));
+		size_t levelCount = 0;
+		const auto levels = frozenGrid_.GetElements<LevelData>(FileIO::SNAPSHOT_LEVELS, levelCount);
+		bool sameExtent = snapshotData.gridMinPosition == raymarchingData_.gridMinPosition;
+		for (size_t i = 0; sameExtent && i < levelCount; ++i)
+		{
+			sameExtent = levels[i].gridCellSize == gridLevelData_[i].gridCellSize;
+		}
+		if (!sameExtent)
+		{
+			printf("Grid snapshot %s was saved with a different grid extent\n", path.c_str());
+			frozenGrid_.Close();
+			return;
+		}
+
+		const auto& header = frozenGrid_.GetHeader();
+		const int atlasSideLength = static_cast<int>(header.atlasSideLength);
+		imageAtlas_.SetSideLength(atlasSideLength);
+		bindingsOutdated_ = imageAtlas_.ResizeImage(imageManager) || bindingsOutdated_;
+		lightTransmittance_.Freeze(atlasSideLength);
+		volumeMediaData_.atlasSideLength = atlasSideLength;
+		raymarchingData_.atlasSideLength = atlasSideLength;
+		raymarchingData_.rootImageFilled = snapshotData.rootImageFilled;
+
+		BufferManager::BufferInfo bufferInfo;
+		bufferInfo.bufferingCount = 1;
+		bufferInfo.pool = BufferManager::MEMORY_TEMP;
+		bufferInfo.size = frozenGrid_.GetSectionSize(FileIO::SNAPSHOT_ATLAS);
+		bufferInfo.typeBits = BufferManager::BUFFER_TEMP_BIT;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		const int tempBufferIndex = bufferManager->RequestBuffer(bufferInfo);
+
+		const auto bufferBits = BufferManager::BUFFER_TEMP_BIT;
+		memcpy(bufferManager->Map(tempBufferIndex, bufferBits), frozenGrid_.GetSection(FileIO::SNAPSHOT_ATLAS), bufferInfo.size);
+		bufferManager->Unmap(tempBufferIndex, bufferBits);
+
+		//The saved atlas image can be larger than the images it contains
+		const uint32_t usedResolution = header.atlasSideLength * GridConstants::imageResolution;
+		VkBufferImageCopy copyRegion = {};
+		copyRegion.bufferRowLength = header.atlasResolution;
+		copyRegion.bufferImageHeight = header.atlasResolution;
+		copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copyRegion.imageSubresource.layerCount = 1;
+		copyRegion.imageExtent = { usedResolution, usedResolution, usedResolution };
+		imageManager->CopyBufferToImage(queueManager, bufferManager->GetBuffer(tempBufferIndex, bufferBits),
+			{ copyRegion }, VK_IMAGE_LAYOUT_GENERAL, imageAtlas_.GetImageIndex(), true);
+		bufferManager->ReleaseTempBuffer(tempBufferIndex);
+
+		printf("Froze the grid to snapshot %s with %d nodes\n", path.c_str(), 
+			static_cast<int>(frozenGrid_.GetSectionSize(FileIO::SNAPSHOT_NODE_INFOS) / sizeof(NodeInfo)));
+	}
+
+	void AdaptiveGrid::ReleaseFrozenGrid()
+	{
+		if (!frozenGrid_.IsOpen())
+		{
+			return;
+		}
+		frozenGrid_.Close();
+		//The snapshot images replaced the content of all producers
+		groundFog_.InvalidateCache();
+		mipMapping_.InvalidateContent();
+		densityGrids_.InvalidateGpuResources();
+	}
+
 	void AdaptiveGrid::UpdateCBData(Scene* scene, Surface* surface, ShadowMap* shadowMap)
   {
+		PROFILE_SCOPE("AdaptiveGrid::UpdateCBData");
 		{
 			const auto& camera = scene->GetCamera();
 			raymarchingData_.viewPortToWorld = glm::inverse(camera.GetViewProj());
@@ -402,7 +746,11 @@ namespace Renderer
 			raymarchingData_.shadowCascades = shadowMap->GetShadowMatrices();
 
 			const auto& screenSize = surface->GetSurfaceSize();
-			raymarchingData_.screenSize = { screenSize.width, screenSize.height};
+			resolutionDivision_ = GuiPass::GetVolumeState().ResolutionDivision();
+			raymarchingData_.screenSize = { screenSize.width / resolutionDivision_, screenSize.height / resolutionDivision_ };
+			raymarchingData_.resolutionDivision = resolutionDivision_;
+			temporalFilter_.UpdateCB(camera.GetViewProj(), raymarchingData_.screenSize,
+				glm::vec2(screenSize.width, screenSize.height), resolutionDivision_);
 			static bool printedScreenSize = false;
 			if (!printedScreenSize)
 			{
@@ -434,27 +782,39 @@ namespace Renderer
 			raymarchingData_.lodScale_Reciprocal = 1.0f / volumeState.lodScale;
 			raymarchingData_.globalScattering = { globalMediumData_.scattering, globalMediumData_.extinction, globalMediumData_.phaseG, 0.0f };
 			raymarchingData_.maxDepth = volumeState.maxDepth;
-			raymarchingData_.jitteringScale = volumeState.jitteringScale;
+			//Jittering is only used if the noise is removed by the temporal filter
+			raymarchingData_.jitteringScale = volumeState.temporalFiltering ? volumeState.jitteringScale : 0.0f;
 			raymarchingData_.maxSteps = volumeState.stepCount;
 			raymarchingData_.exponentialScale = log(volumeState.maxDepth);
+			raymarchingData_.minTransmittance = volumeState.minTransmittance;
+			raymarchingData_.adaptiveStepping = volumeState.adaptiveStepping ? 1 : 0;
+			raymarchingData_.adaptiveStepScale = std::max(1.0f, volumeState.adaptiveStepScale);
+			raymarchingData_.skipExtinction = volumeState.skipExtinction;
+			raymarchingData_.rangeStepping = volumeState.rangeStepping ? 1 : 0;
 
 			//TODO check why these values are double
 			volumeMediaData_.scattering = volumeState.groundFogValue.scattering;
 			volumeMediaData_.extinction = volumeState.groundFogValue.absorption + volumeState.groundFogValue.scattering;
 			volumeMediaData_.phaseG = volumeState.groundFogValue.phaseG;
 			
-			if (volumeState.debugTraversal)
+			if (volumeState.debugTraversal && !DebugData::HasSnapshot())
 			{
 				DebugData::raymarchData_ = raymarchingData_;
 				DebugData::levelData_.data = gridLevelData_;
 			}
 
 			groundFog_.UpdateCBData(volumeState.groundFogHeight,
+				volumeState.groundFogBand,
+				volumeState.groundFogHeightfieldAmplitude,
+				volumeState.groundFogHeightfieldScale,
 				volumeState.groundFogValue.scattering,
 				volumeState.groundFogValue.absorption,
 				volumeState.groundFogValue.phaseG,
-				volumeState.groundFogNoiseScale);
+				volumeState.groundFogNoiseScale,
+				volumeState.groundFogNoiseVolume);
 			globalVolume_.UpdateCB(&groundFog_);
+			smokeVolumes_.UpdateCBData(volumeState.smokeValue.scattering, volumeState.smokeValue.absorption,
+				volumeState.smokeValue.phaseG);
 
 			for (auto& levelData : gridLevelData_)
 			{
@@ -472,6 +832,7 @@ namespace Renderer
 			static std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
 			static auto RandPos = std::bind(distribution, generator);
 			raymarchingData_.randomness = { RandPos(), RandPos(), RandPos() };
+			InputRecording::UpdateRandomness(raymarchingData_.randomness);
 		}
 
 		{
@@ -491,6 +852,7 @@ namespace Renderer
 
   void AdaptiveGrid::UpdateGrid(Scene* scene)
   {
+		PROFILE_SCOPE("AdaptiveGrid::UpdateGrid");
 		for (auto& gridLevel : gridLevels_)
 		{
 			gridLevel.Reset();
@@ -505,6 +867,8 @@ namespace Renderer
 		//gridLevels_[2].AddNode({ 254, 256,256 });
 
 		groundFog_.UpdateGridCells(&gridLevels_[1]);
+		smokeVolumes_.GridInsertNodes(&gridLevels_[gridLevels_.size() - 2], &gridLevels_.back());
+		densityGrids_.GridInsertNodes(&gridLevels_.back());
 		particleSystems_.GridInsertParticleNodes(raymarchingData_.gridMinPosition, &gridLevels_[2]);
 
 		int parentChildOffset = 0;
@@ -512,14 +876,31 @@ namespace Renderer
 		{
 			parentChildOffset = level.Update(parentChildOffset);
 		}
+		//Value ranges of the images filled with static values, all other nodes are summarized during mip mapping
+		//The coarsest image also contains the cells fully covered by the ground fog
+		const glm::vec4 coveredFog = groundFog_.GetCoveredValue();
+		const bool fogCovered = !groundFog_.GetCoveredBounds().empty();
+		gridLevels_[0].SetNodeValueRange(globalMediumData_.extinction, 
+			globalMediumData_.extinction + (fogCovered ? coveredFog.y : 0.0f),
+			globalMediumData_.scattering + (fogCovered ? coveredFog.x : 0.0f));
+		groundFog_.UpdateValueRange(&gridLevels_[1]);
+		raymarchingData_.rootImageFilled = globalVolume_.IsRootFilled() ? 1 : 0;
 		imageAtlas_.UpdateSize(gridLevels_.back().GetImageOffset());
 		const int atlasSideLength = imageAtlas_.GetSideLength();
-		mipMapping_.UpdateAtlasProperties(atlasSideLength, imageAtlas_.GetResolution());
 		for (auto& level : gridLevels_)
 		{
 			level.UpdateImageIndices(atlasSideLength);
 		}
+		smokeVolumes_.UpdateGpuData(&gridLevels_[gridLevels_.size() - 2], &gridLevels_.back());
+		densityGrids_.UpdateCopyRegions(&gridLevels_.back());
 		particleSystems_.UpdateGpuData(&gridLevels_[1], &gridLevels_[2], atlasSideLength);
+		//Content written by the producers, their media values are part of the transmittance signature
+		uint64_t contentSignature = Math::hashSeed;
+		Math::HashCombine(contentSignature, particleSystems_.GetContentSignature());
+		Math::HashCombine(contentSignature, smokeVolumes_.GetContentVersion());
+		Math::HashCombine(contentSignature, densityGrids_.GetContentVersion());
+		Math::HashCombine(contentSignature, groundFog_.GetHeightfieldSignature());
+		lightTransmittance_.Update(gridLevels_, raymarchingData_.lightDirection, contentSignature);
 
 		
 		const int maxParentLevel = static_cast<int>(gridLevels_.size() - 1);
@@ -527,6 +908,22 @@ namespace Renderer
 		{
 			mipMapping_.UpdateMipMapNodes(&gridLevels_[i], &gridLevels_[i + 1]);
 		}
+		{
+			std::vector<std::vector<uint64_t>> contentStamps(gridLevels_.size());
+			for (size_t i = 0; i < gridLevels_.size(); ++i)
+			{
+				contentStamps[i].resize(gridLevels_[i].GetNodeCount(), Math::hashSeed);
+			}
+			Math::HashCombine(contentStamps[0][0], globalVolume_.GetContentSignature());
+			Math::HashCombine(contentStamps[0][0], raymarchingData_.gridMinPosition);
+			groundFog_.AddContentStamps(contentStamps[1]);
+			smokeVolumes_.AddContentStamps(contentStamps[gridLevels_.size() - 2], contentStamps.back());
+			densityGrids_.AddContentStamps(contentStamps.back());
+			particleSystems_.AddContentStamps(contentStamps[2]);
+			//Debug filling overwrites the images independent of their content
+			const bool debugFilling = GuiPass::GetDebugVisState().debugFillingType != GuiPass::DebugVisState::DEBUG_FILL_NONE;
+			mipMapping_.UpdateDirtyNodes(gridLevels_, contentStamps, debugFilling, atlasSideLength);
+		}
 		//neighborCells_.CalculateNeighbors(gridLevels_);
 
 		debugFilling_.SetImageCount(&gridLevels_[2]);
@@ -537,13 +934,62 @@ namespace Renderer
 		raymarchingData_.atlasSideLength = atlasSideLength;
 		//neighborCells_.UpdateAtlasProperties(atlasSideLength);
 
+		if (statistics_.enabled)
+		{
+			UpdateGridStatistics();
+		}
+
   }
 
 	
 
+	void AdaptiveGrid::UpdateGridStatistics()
+	{
+		statistics_.nodesPerLevel.resize(gridLevels_.size());
+		statistics_.geometryNodesPerLevel.assign(gridLevels_.size(), 0);
+		statistics_.mipMapCount = 0;
+		std::vector<int> meshIndices;
+		for (size_t i = 0; i < gridLevels_.size(); ++i)
+		{
+			statistics_.nodesPerLevel[i] = gridLevels_[i].GetNodeCount();
+			for (int indexNode = 0; indexNode < gridLevels_[i].GetNodeCount(); ++indexNode)
+			{
+				meshIndices.clear();
+				QueryNodeGeometry(static_cast<int>(i), indexNode, meshIndices);
+				statistics_.geometryNodesPerLevel[i] += meshIndices.empty() ? 0 : 1;
+			}
+			for (const auto& imageInfo : gridLevels_[i].GetNodeData().imageInfos_)
+			{
+				statistics_.mipMapCount += imageInfo.mipMapImageIndex != -1 ? 1 : 0;
+			}
+		}
+
+		const int atlasSideLength = imageAtlas_.GetSideLength();
+		const int atlasCapacity = atlasSideLength * atlasSideLength * atlasSideLength;
+		statistics_.atlasSideLength = atlasSideLength;
+		statistics_.atlasImageCount = gridLevels_.back().GetImageOffset();
+		statistics_.atlasOccupancy = atlasCapacity > 0 ?
+			statistics_.atlasImageCount / static_cast<float>(atlasCapacity) : 0.0f;
+		statistics_.UpdateParticleHistogram(particleSystems_.GetNodeParticleMapping());
+
+		const auto bufferSizes = GetGpuResourceSize();
+		statistics_.nodeInfoBytes = bufferSizes[GPU_BUFFER_NODE_INFOS];
+		statistics_.activeBitBytes = bufferSizes[GPU_BUFFER_ACTIVE_BITS];
+		statistics_.bitCountBytes = bufferSizes[GPU_BUFFER_BIT_COUNTS];
+		statistics_.childIndexBytes = bufferSizes[GPU_BUFFER_CHILDS];
+	}
+
 	std::array<VkDeviceSize, AdaptiveGrid::GPU_MAX> AdaptiveGrid::GetGpuResourceSize()
 	{
 		std::array<VkDeviceSize, GPU_MAX> totalSizes{};
+		if (frozenGrid_.IsOpen())
+		{
+			totalSizes[GPU_BUFFER_NODE_INFOS] = frozenGrid_.GetSectionSize(FileIO::SNAPSHOT_NODE_INFOS);
+			totalSizes[GPU_BUFFER_ACTIVE_BITS] = frozenGrid_.GetSectionSize(FileIO::SNAPSHOT_ACTIVE_BITS);
+			totalSizes[GPU_BUFFER_BIT_COUNTS] = frozenGrid_.GetSectionSize(FileIO::SNAPSHOT_BIT_COUNTS);
+			totalSizes[GPU_BUFFER_CHILDS] = frozenGrid_.GetSectionSize(FileIO::SNAPSHOT_CHILDS);
+			return totalSizes;
+		}
 		for (const auto& level : gridLevels_)
 		{
 			totalSizes[GPU_BUFFER_NODE_INFOS] += level.GetNodeInfoSize();
@@ -557,10 +1003,16 @@ namespace Renderer
 
 	void AdaptiveGrid::ResizeGpuResources(BufferManager* bufferManager, ImageManager* imageManager)
   {
+    PROFILE_SCOPE("AdaptiveGrid::ResizeGpuResources");
     bool resize = false;
 		std::vector<ResourceResize>resourceResizes;
 		const auto totalSizes =	GetGpuResourceSize();
-		imageAtlas_.ResizeImage(imageManager);
+		//Descriptors of recreated images have to be updated
+		resize = imageAtlas_.ResizeImage(imageManager);
+		if (resize)
+		{
+			groundFog_.InvalidateCache();
+		}
 
 		for (int i = 0; i < GPU_MAX; ++i)
 		{
@@ -574,20 +1026,31 @@ namespace Renderer
 			resourceResizes.push_back({ maxSize, gpuResources_[i].index });
 		}
 
+		globalVolume_.ResizeGpuResources(resourceResizes);
+		noiseVolume_.ResizeGpuResources(resourceResizes);
 		resize = groundFog_.ResizeGPUResources(resourceResizes) ? true : resize;
+		resize = smokeVolumes_.ResizeGpuResources(resourceResizes) ? true : resize;
+		resize = densityGrids_.ResizeGpuResources(resourceResizes) ? true : resize;
 		resize = particleSystems_.ResizeGpuResources(resourceResizes) ? true : resize;
-		resize = mipMapping_.ResizeGpuResources(imageManager, resourceResizes) ? true : resize;
+		resize = mipMapping_.ResizeGpuResources(resourceResizes) ? true : resize;
 		resize = neighborCells_.ResizeGpuResources(resourceResizes) ? true : resize;
+		resize = tileClassification_.ResizeGpuResources(resourceResizes) ? true : resize;
+		resize = lightTransmittance_.ResizeGpuResources(imageManager, resourceResizes) ? true : resize;
 
-		if (!initialized_)
+		if (!initialized_ || bindingsOutdated_)
 		{
 			resize = true;
 			initialized_ = true;
+			bindingsOutdated_ = false;
 		}
 
     if (resize)
     {
       bufferManager->Ref_ResizeBuffers(resourceResizes, BufferManager::MEMORY_GRID);
+      mipMapping_.InvalidateGpuResources();
+      globalVolume_.InvalidateGpuResources();
+      noiseVolume_.InvalidateGpuResources();
+      densityGrids_.InvalidateGpuResources();
     }
     resizing_ = resize;
   }
@@ -626,6 +1089,12 @@ namespace Renderer
 
   void AdaptiveGrid::UpdateGpuResources(BufferManager* bufferManager, int frameIndex)
   {
+		PROFILE_SCOPE("AdaptiveGrid::UpdateGpuResources");
+		if (frozenGrid_.IsOpen())
+		{
+			UpdateFrozenGpuResources(bufferManager, frameIndex);
+			return;
+		}
 		const auto& volumeState = GuiPass::GetVolumeState();
 
 		std::array<ResourceInfo, GPU_MAX> offsets{};
@@ -651,7 +1120,7 @@ namespace Renderer
 				offsets[resourceIndex].offset = gridLevels_[i].CopyBufferData(offsets[resourceIndex].dataPtr,
 					static_cast<GridLevel::BufferType>(resourceIndex), offsets[resourceIndex].offset);
 				
-				if (volumeState.debugTraversal)
+				if (volumeState.debugTraversal && !DebugData::HasSnapshot())
 				{
 					gridLevels_[i].CopyBufferData(GetDebugBufferCopyDst(bufferType, offsets[resourceIndex].offset),
 						bufferType, offset);
@@ -663,11 +1132,99 @@ namespace Renderer
 		{
 			bufferManager->Ref_Unmap(gpuResources_[i].index, frameIndex, BufferManager::BUFFER_GRID_BIT);
 		}
+		if (statistics_.enabled)
+		{
+			statistics_.mappedBytes = 0;
+			statistics_.uploadedBytes = 0;
+			for (int i = GPU_BUFFER_NODE_INFOS; i < GPU_MAX; ++i)
+			{
+				statistics_.mappedBytes += gpuResources_[i].maxSize;
+				statistics_.uploadedBytes += offsets[i].offset;
+			}
+		}
 
+		//Coarse smoke is added onto the fog images, fog and smoke are only stored again if either of them changes
+		uint64_t fogOverlaySignature = 0;
+		if (gridLevels_.size() - 2 == 1)
+		{
+			const auto& fogNodes = groundFog_.GetNodeIndices();
+			const auto& smokeNodes = smokeVolumes_.GetCoarseNodeIndices();
+			if (std::find_first_of(fogNodes.begin(), fogNodes.end(), smokeNodes.begin(), smokeNodes.end()) != fogNodes.end())
+			{
+				fogOverlaySignature = smokeVolumes_.GetContentSignature();
+			}
+		}
+		groundFog_.SetOverlaySignature(fogOverlaySignature);
 		groundFog_.UpdatePerNodeBuffer(bufferManager, &gridLevels_[1], frameIndex, imageAtlas_.GetSideLength());
+		if (!groundFog_.IsFilledThisFrame())
+		{
+			smokeVolumes_.SkipCoarseImages(groundFog_.GetKeptImages());
+		}
+		//Debug filling overwrites the fog images so they have to be filled again afterwards
+		if (GuiPass::GetDebugVisState().debugFillingType != GuiPass::DebugVisState::DEBUG_FILL_NONE)
+		{
+			groundFog_.InvalidateCache();
+		}
+		//Images which are filled completely by copies are not cleared
+		const auto& keptFogImages = groundFog_.GetKeptImages();
+		const auto& densityGridImages = densityGrids_.GetImageIndices();
+		std::vector<int> keptImages;
+		std::merge(keptFogImages.begin(), keptFogImages.end(), densityGridImages.begin(), densityGridImages.end(),
+			std::back_inserter(keptImages));
+		globalVolume_.UpdateClearRegions(gridLevels_, keptImages);
+		globalVolume_.UpdateGpuResources(bufferManager);
+		noiseVolume_.UpdateGpuResources(bufferManager);
+		smokeVolumes_.UpdateGpuResources(bufferManager, frameIndex);
+		densityGrids_.UpdateGpuResources(bufferManager);
 		particleSystems_.UpdateGpuResources(bufferManager, frameIndex);
 		mipMapping_.UpdateGpuResources(bufferManager, frameIndex);
 		neighborCells_.UpdateGpuResources(bufferManager, frameIndex);
+		tileClassification_.UpdateGpuResources(bufferManager, frameIndex);
+		lightTransmittance_.UpdateGpuResources(bufferManager, frameIndex);
+	}
+
+	void AdaptiveGrid::UpdateFrozenGpuResources(BufferManager* bufferManager, int frameIndex)
+	{
+		const std::array<FileIO::SnapshotSection, GPU_MAX> sections = { FileIO::SNAPSHOT_NODE_INFOS, 
+			FileIO::SNAPSHOT_ACTIVE_BITS, FileIO::SNAPSHOT_BIT_COUNTS, FileIO::SNAPSHOT_CHILDS };
+		for (int i = 0; i < GPU_MAX; ++i)
+		{
+			auto dataPtr = bufferManager->Ref_Map(gpuResources_[i].index, frameIndex, BufferManager::BUFFER_GRID_BIT);
+			memcpy(dataPtr, frozenGrid_.GetSection(sections[i]), frozenGrid_.GetSectionSize(sections[i]));
+			bufferManager->Ref_Unmap(gpuResources_[i].index, frameIndex, BufferManager::BUFFER_GRID_BIT);
+		}
+
+		//The cell sizes are equal to the snapshot, only the buffer offsets of the levels differ
+		size_t levelCount = 0;
+		const auto levels = frozenGrid_.GetElements<LevelData>(FileIO::SNAPSHOT_LEVELS, levelCount);
+		for (size_t i = 0; i < levelCount; ++i)
+		{
+			gridLevelData_[i].nodeArrayOffset = levels[i].nodeArrayOffset;
+			gridLevelData_[i].childArrayOffset = levels[i].childArrayOffset;
+			gridLevelData_[i].nodeOffset = levels[i].nodeOffset;
+			gridLevelData_[i].childOffset = levels[i].childOffset;
+		}
+
+		tileClassification_.UpdateGpuResources(bufferManager, frameIndex);
+		lightTransmittance_.UpdateGpuResources(bufferManager, frameIndex);
+	}
+
+	void AdaptiveGrid::UpdateRaymarchingStatistics(BufferManager* bufferManager, int frameIndex)
+	{
+		auto statistics = reinterpret_cast<RaymarchingStatistics*>(bufferManager->Ref_Map(
+			cbIndices_[CB_RAYMARCHING_STATISTICS], frameIndex, BufferManager::BUFFER_CONSTANT_BIT));
+		//The buffer of this frame index was used by the last finished frame
+		if (statisticsResetCount_ >= frameCount_ && statistics->rayCount > 0)
+		{
+			GuiPass::SetAverageRaySteps(static_cast<float>(statistics->stepCount) /
+				static_cast<float>(statistics->rayCount));
+		}
+		else
+		{
+			++statisticsResetCount_;
+		}
+		*statistics = {};
+		bufferManager->Ref_Unmap(cbIndices_[CB_RAYMARCHING_STATISTICS], frameIndex, BufferManager::BUFFER_CONSTANT_BIT);
 	}
 
   void AdaptiveGrid::UpdateBoundingBoxes()
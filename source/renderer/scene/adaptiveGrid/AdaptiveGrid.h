@@ -26,19 +26,29 @@ SOFTWARE.
 
 #include <array>
 #include <memory>
+#include <string>
 #include "..\..\..\scene\components\AABoundingBox.h"
+#include "..\..\..\fileIO\GridSnapshot.h"
 #include "GridLevel.h"
 #include "..\..\ShadowMap.h"
 #include "debug\DebugTraversal.h"
 #include "GroundFog.h"
+#include "NoiseVolume.h"
 #include "MipMapping.h"
 #include "NeighborCells.h"
 #include "ImageAtlas.h"
+#include "DensityGrids.h"
+#include "TileClassification.h"
+#include "GridStatistics.h"
 
 
 #include "subpasses\ParticleSystems.h"
+#include "subpasses\SmokeVolumes.h"
 #include "subpasses\DebugFilling.h"
 #include "subpasses\GlobalVolume.h"
+#include "subpasses\TemporalFilter.h"
+#include "subpasses\FroxelVolume.h"
+#include "subpasses\LightTransmittance.h"
 
 #include <vulkan\vulkan.h>
 
@@ -52,6 +62,7 @@ namespace Renderer
   class ShaderBindingManager;
   class Surface;
   class ShadowMap;
+  class BoundingVolumeHierarchy;
 
   class AdaptiveGrid
   {
@@ -66,12 +77,15 @@ namespace Renderer
     {
 			GRID_PASS_GLOBAL,
       GRID_PASS_GROUND_FOG,
+			GRID_PASS_SMOKE,
       GRID_PASS_PARTICLES,
 			GRID_PASS_DEBUG_FILLING,
 			GRID_PASS_MIPMAPPING,
-			GRID_PASS_MIPMAPPING_MERGING,
 			GRID_PASS_NEIGHBOR_UPDATE,
-      GRID_PASS_RAYMARCHING
+			GRID_PASS_LIGHT_TRANSMITTANCE,
+			GRID_PASS_FROXEL,
+      GRID_PASS_RAYMARCHING,
+			GRID_PASS_TEMPORAL
     };
 
 		AdaptiveGrid(float worldCellSize);
@@ -81,9 +95,16 @@ namespace Renderer
     void ResizeConstantBuffers(BufferManager* bufferManager);
     //Create constant buffers, empty texture atlas and buffers for nodes and childs(resized later)
     void RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount);
-    void SetImageIndices(int raymarching, int depth, int shadowMap, int noise);
+    void SetImageIndices(int raymarching, int raymarchingHistory, int raymarchingResolved, 
+			int depth, int shadowMap, int noise);
 		 
 		void OnLoadScene(const Scene* scene);
+		//Hierarchy over the world space mesh bounds, indices returned by queries are mesh indices
+		void SetSceneHierarchy(const BoundingVolumeHierarchy* hierarchy) { sceneHierarchy_ = hierarchy; }
+		//Appends the meshes overlapping the world space bounds of an active node of the current frame
+		void QueryNodeGeometry(int level, int nodeIndex, std::vector<int>& meshIndices) const;
+		//World space bounds of a node calculated from its position and the positions of its parents
+		AxisAlignedBoundingBox CalcNodeBounds(int level, int nodeIndex) const;
 		void UpdateParticles(float dt);
 
     //Insert smoke volumes and particle systems into grid levels
@@ -96,9 +117,13 @@ namespace Renderer
 		void Dispatch(QueueManager* queueManager, ImageManager* imageManager, BufferManager* bufferManager, 
 			VkCommandBuffer commandBuffer, Pass pass, int frameIndex, int level);
 
-		void Raymarch(ImageManager* imageManager, VkCommandBuffer commandBuffer, uint32_t width, 
-			uint32_t height, int frameIndex);
+		void Raymarch(ImageManager* imageManager, BufferManager* bufferManager, VkCommandBuffer commandBuffer, 
+			int frameIndex);
 		void UpdateDebugTraversal(QueueManager* queueManager, BufferManager* bufferManager, ImageManager* imageManager);
+		//Saves the submitted grid state, loads a snapshot for the debug traversal or freezes the grid to a snapshot,
+		//triggered from the menu
+		void UpdateSnapshots(QueueManager* queueManager, BufferManager* bufferManager, ImageManager* imageManager,
+			int frameIndex);
 
     const auto& GetDebugBoundingBoxes() const { return debugBoundingBoxes_; }
     bool Resized() const { return resizing_; }
@@ -108,11 +133,15 @@ namespace Renderer
 		const auto& GetLevelData() const { return gridLevelData_; }
 
 		int GetMaxParentLevel() const { return mostDetailedParentLevel_; }
+		int GetFroxelImageIndex() const { return froxelVolume_.GetImageIndex(); }
+		//Only filled while the grid statistics are enabled in the gui
+		const auto& GetStatistics() const { return statistics_; }
   private:
     enum ConstantBuffer
     {
       CB_RAYMARCHING,
       CB_RAYMARCHING_LEVELS,
+      CB_RAYMARCHING_STATISTICS,
       CB_MAX
     };
 
@@ -134,15 +163,6 @@ namespace Renderer
 			int imageResolutionOffset;
     };
 
-    
-
-    struct VolumeData
-    {
-      glm::vec3 min;
-      float padding1;
-      glm::vec3 max;
-      float padding2;
-    };
 
     //Constant buffers are filled with global scene data, camera values, screen size
     void UpdateCBData(Scene* scene, Surface* surface, ShadowMap* shadowMap);
@@ -150,9 +170,23 @@ namespace Renderer
     void UpdateGrid(Scene* scene);
     //If more space needed resize
 		std::array<VkDeviceSize, GPU_MAX> AdaptiveGrid::GetGpuResourceSize();
+		void UpdateGridStatistics();
 		void ResizeGpuResources(BufferManager* bufferManager, ImageManager* imageManager);
 		void* GetDebugBufferCopyDst(GridLevel::BufferType type, int size);
 		void UpdateGpuResources(BufferManager* bufferManager, int frameIndex);
+		//Writes the gpu buffers and the image atlas of the last submitted frame into a snapshot file
+		void SaveSnapshot(QueueManager* queueManager, BufferManager* bufferManager, ImageManager* imageManager, 
+			const std::string& path, int frameIndex);
+		//Uploads the atlas of a snapshot and keeps it mapped for the grid buffers, the grid is not updated anymore
+		//and only the passes from the light transmittance on are dispatched, an empty path releases it
+		void LoadFrozenGrid(QueueManager* queueManager, BufferManager* bufferManager, ImageManager* imageManager,
+			const std::string& path);
+		//The producers fill the atlas again in the next frame
+		void ReleaseFrozenGrid();
+		//Copies the buffer sections of the frozen grid into the grid buffers
+		void UpdateFrozenGpuResources(BufferManager* bufferManager, int frameIndex);
+		//Reads the step count of the finished frame and resets the counters
+		void UpdateRaymarchingStatistics(BufferManager* bufferManager, int frameIndex);
 		//Stores bounding boxes of active nodes for debug rendering
     void UpdateBoundingBoxes();
 
@@ -166,11 +200,6 @@ namespace Renderer
     RaymarchingData raymarchingData_;
     std::vector<LevelData> gridLevelData_;
 
-    std::vector<VolumeData> volumeData_;
-    std::vector<int> volumeIndices_;
-    std::vector<GridLevel::NodePushData> nodePushData_;
-    std::map<int, std::vector<int>> volumeIndiceMapping_;
-
     int raymarchingImageIndex_ = -1;
     int depthImageIndex_ = -1;
     int shadowMapIndex_ = -1;
@@ -190,19 +219,37 @@ namespace Renderer
     std::vector<BoundingBoxData> debugBoundingBoxes_;
 
     int frameCount_ = 0;
+    //Screen pixels per raymarching texel, the raymarching image keeps the full size
+    int resolutionDivision_ = 1;
+    //Statistic buffers contain valid data after each of them has been reset once
+    int statisticsResetCount_ = 0;
     bool initialized_ = false;
     bool resizing_ = false;
 
 		DebugTraversal debugTraversal_;
+		//Snapshot replacing the grid nodes and the atlas while it is open
+		FileIO::MappedGridSnapshot frozenGrid_;
+		//The atlas was recreated outside of ResizeGpuResources, the shader bindings are updated in the next frame
+		bool bindingsOutdated_ = false;
 		bool previousFrameTraversal_ = false;
 
 		GlobalVolume globalVolume_;
+		NoiseVolume noiseVolume_;
 		GroundFog groundFog_;
+		SmokeVolumes smokeVolumes_;
+		DensityGrids densityGrids_;
 		ParticleSystems particleSystems_;
 		MipMapping mipMapping_;
 		DebugFilling debugFilling_;
 		NeighborCells neighborCells_;
 		ImageAtlas imageAtlas_;
+		GridStatistics statistics_;
+		TemporalFilter temporalFilter_;
+		TileClassification tileClassification_;
+		FroxelVolume froxelVolume_;
+		LightTransmittance lightTransmittance_;
+
+		const BoundingVolumeHierarchy* sceneHierarchy_ = nullptr;
 
 		int mostDetailedParentLevel_ = 0;
 		
@@ -30,4 +30,6 @@ namespace GridConstants
 	constexpr int imageResolution = nodeResolution + 1;
 
 	constexpr int nodeResolutionSquared = nodeResolution * nodeResolution;
+	//Size of one atlas image with R16G16B16A16 texels
+	constexpr int imageByteSize = imageResolution * imageResolution * imageResolution * 8;
 }
\ No newline at end of file
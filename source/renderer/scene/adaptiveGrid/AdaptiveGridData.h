@@ -66,6 +66,23 @@ namespace Renderer
 		float nodeTexelSize;
 		int atlasSideLength;
 		int maxLevel;
+
+		float minTransmittance;
+		int adaptiveStepping;
+		float adaptiveStepScale;
+		int resolutionDivision;
+
+		float skipExtinction;
+		int rangeStepping;
+		int rootImageFilled;		//otherwise the root only contains the global medium which is added analytically
+		float paddingRange;
+	};
+
+	//Written by the raymarching shader, read back after the frame finished
+	struct RaymarchingStatistics
+	{
+		uint32_t stepCount;
+		uint32_t rayCount;
 	};
 
 	struct LevelData
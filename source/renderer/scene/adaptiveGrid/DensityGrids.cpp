@@ -0,0 +1,432 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "DensityGrids.h"
+
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <map>
+#include <cstring>
+#include <sys\stat.h>
+#include <glm\gtc\packing.hpp>
+
+#include "GridLevel.h"
+#include "AdaptiveGridConstants.h"
+#include "..\..\resources\BufferManager.h"
+#include "..\..\resources\ImageManager.h"
+#include "..\..\wrapper\Barrier.h"
+#include "..\..\..\scene\Scene.h"
+#include "..\..\..\utility\Math.h"
+
+namespace
+{
+	constexpr uint32_t gridMagic = 0x44524744;		//DGRD
+	constexpr uint32_t cacheMagic = 0x42524744;		//DGRB
+	constexpr uint32_t cacheVersion = 1;
+
+	constexpr int brickResolution = GridConstants::imageResolution;
+	constexpr size_t brickTexelCount = brickResolution * brickResolution * brickResolution;
+
+	struct GridHeader
+	{
+		uint32_t magic;
+		glm::ivec3 resolution;
+	};
+
+	struct CacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t signature;
+		uint32_t brickCount;
+		uint32_t dataCount;
+	};
+
+	//Trilinear sample at the voxel coordinate, the density outside the grid is zero
+	float SampleGrid(const std::vector<float>& densities, const glm::ivec3& resolution, const glm::vec3& voxel)
+	{
+		const glm::vec3 base = floor(voxel);
+		const glm::vec3 t = voxel - base;
+		const glm::ivec3 start = glm::ivec3(base);
+
+		float value = 0.0f;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const glm::ivec3 c = glm::ivec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+			const glm::ivec3 v = start + c;
+			if (glm::any(glm::lessThan(v, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(v, resolution)))
+			{
+				continue;
+			}
+			const glm::vec3 w = glm::mix(1.0f - t, t, glm::vec3(c));
+			const size_t index = (static_cast<size_t>(v.z) * resolution.y + v.y) * resolution.x + v.x;
+			value += w.x * w.y * w.z * densities[index];
+		}
+		return value;
+	}
+}
+
+namespace Renderer
+{
+	void DensityGrids::RequestResources(BufferManager* bufferManager)
+	{
+		BufferManager::BufferInfo bufferInfo;
+		bufferInfo.typeBits = BufferManager::BUFFER_GRID_BIT;
+		bufferInfo.pool = BufferManager::MEMORY_GRID;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.bufferingCount = 1;
+		//Resized after the scene was loaded
+		bufferInfo.size = brickTexelCount * sizeof(uint64_t);
+		stagingBuffer_ = { bufferInfo.size, bufferManager->Ref_RequestBuffer(bufferInfo) };
+	}
+
+	void DensityGrids::OnLoadScene(const Scene* scene, const AxisAlignedBoundingBox& gridBounds, float cellSize)
+	{
+		bricks_.clear();
+		brickData_.clear();
+		staged_ = false;
+		++contentVersion_;
+
+		const int cellsPerAxis = static_cast<int>(round((gridBounds.max.x - gridBounds.min.x) / cellSize));
+		const auto& boundingBoxes = scene->GetBoundingBoxes();
+		const auto& densityGrids = scene->GetDensityGrids();
+		for (auto it = densityGrids.begin(); it != densityGrids.end(); ++it)
+		{
+			const int guid = it->first;
+			if (guid >= static_cast<int>(boundingBoxes.size()))
+			{
+				printf("Density grid %d has no bounding box\n", guid);
+				continue;
+			}
+			const auto& densityGrid = densityGrids.data()[it->second];
+			//Grid space bounds, the dense grid is stretched over the bounding box
+			const auto bounds = boundingBoxes[guid] - gridBounds.min;
+
+			struct stat fileStatus;
+			if (stat(densityGrid.path.c_str(), &fileStatus) != 0)
+			{
+				printf("Density grid %s not found\n", densityGrid.path.c_str());
+				continue;
+			}
+			uint64_t signature = Math::hashSeed;
+			Math::HashCombine(signature, static_cast<int64_t>(fileStatus.st_size));
+			Math::HashCombine(signature, static_cast<int64_t>(fileStatus.st_mtime));
+			Math::HashCombine(signature, densityGrid.threshold);
+			Math::HashCombine(signature, densityGrid.absorption);
+			Math::HashCombine(signature, densityGrid.scattering);
+			Math::HashCombine(signature, densityGrid.phaseG);
+			Math::HashCombine(signature, bounds.min);
+			Math::HashCombine(signature, bounds.max);
+			Math::HashCombine(signature, gridBounds.max - gridBounds.min);
+			Math::HashCombine(signature, cellSize);
+
+			const std::string cachePath = densityGrid.path + ".bricks";
+			std::vector<Brick> bricks;
+			std::vector<uint64_t> data;
+			if (!LoadCache(cachePath, signature, bricks, data))
+			{
+				printf("Converting density grid %s\n", densityGrid.path.c_str());
+				if (!Convert(densityGrid, bounds, cellSize, cellsPerAxis, bricks, data))
+				{
+					continue;
+				}
+				SaveCache(cachePath, signature, bricks, data);
+			}
+
+			const int dataOffset = static_cast<int>(brickData_.size() / brickTexelCount);
+			for (auto& brick : bricks)
+			{
+				brick.dataIndex += dataOffset;
+			}
+			bricks_.insert(bricks_.end(), bricks.begin(), bricks.end());
+			brickData_.insert(brickData_.end(), data.begin(), data.end());
+			printf("Density grid %s uses %d bricks with %d unique images\n", densityGrid.path.c_str(),
+				static_cast<int>(bricks.size()), static_cast<int>(data.size() / brickTexelCount));
+		}
+	}
+
+	bool DensityGrids::Convert(const DensityGrid& densityGrid, const AxisAlignedBoundingBox& bounds, float cellSize, int cellsPerAxis,
+		std::vector<Brick>& bricks, std::vector<uint64_t>& data) const
+	{
+		std::ifstream file(densityGrid.path, std::ios::in | std::ios::binary);
+		GridHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(GridHeader));
+		if (!file || header.magic != gridMagic || glm::any(glm::lessThanEqual(header.resolution, glm::ivec3(0))))
+		{
+			printf("Invalid density grid %s\n", densityGrid.path.c_str());
+			return false;
+		}
+		const glm::ivec3 resolution = header.resolution;
+		std::vector<float> densities(static_cast<size_t>(resolution.x) * resolution.y * resolution.z);
+		file.read(reinterpret_cast<char*>(densities.data()), densities.size() * sizeof(float));
+		if (!file)
+		{
+			printf("Density grid %s is incomplete\n", densityGrid.path.c_str());
+			return false;
+		}
+
+		const float texelSize = cellSize / GridConstants::nodeResolution;
+		const glm::vec3 voxelScale = glm::vec3(resolution) / (bounds.max - bounds.min);
+		const glm::ivec3 minCell = glm::max(glm::ivec3(floor(bounds.min / cellSize)), glm::ivec3(0));
+		const glm::ivec3 maxCell = glm::min(glm::ivec3(ceil(bounds.max / cellSize)), glm::ivec3(cellsPerAxis));
+		const glm::ivec3 cellCount = glm::max(maxCell - minCell, glm::ivec3(0));
+		const int totalCells = cellCount.x * cellCount.y * cellCount.z;
+
+		const glm::vec4 mediumScale = glm::vec4(densityGrid.scattering, densityGrid.scattering + densityGrid.absorption, 0.0f, 0.0f);
+		const glm::vec4 mediumOffset = glm::vec4(0.0f, 0.0f, densityGrid.phaseG, 0.0f);
+
+		struct ThreadResult
+		{
+			std::vector<glm::ivec3> cells;
+			std::vector<uint64_t> data;
+			//Constant bricks only store the packed density
+			std::vector<std::pair<glm::ivec3, uint16_t>> constantCells;
+		};
+		const int threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+		std::vector<ThreadResult> results(threadCount);
+
+		std::atomic<int> nextCell{ 0 };
+		const auto ConvertCells = [&](ThreadResult& result)
+		{
+			std::vector<uint16_t> brick(brickTexelCount);
+			for (int i = nextCell++; i < totalCells; i = nextCell++)
+			{
+				const glm::ivec3 cell = minCell + glm::ivec3(
+					i % cellCount.x, (i / cellCount.x) % cellCount.y, i / (cellCount.x * cellCount.y));
+				const glm::vec3 cellOffset = glm::vec3(cell) * cellSize;
+
+				float maxDensity = 0.0f;
+				for (int z = 0; z < brickResolution; ++z)
+				{
+					for (int y = 0; y < brickResolution; ++y)
+					{
+						for (int x = 0; x < brickResolution; ++x)
+						{
+							const glm::vec3 position = cellOffset + glm::vec3(x, y, z) * texelSize;
+							//Densities are stored at the voxel centers
+							const glm::vec3 voxel = (position - bounds.min) * voxelScale - 0.5f;
+							const float density = SampleGrid(densities, resolution, voxel);
+							brick[(z * brickResolution + y) * brickResolution + x] = static_cast<uint16_t>(glm::packHalf1x16(density));
+							maxDensity = std::max(maxDensity, density);
+						}
+					}
+				}
+
+				if (maxDensity <= densityGrid.threshold)
+				{
+					continue;
+				}
+				if (std::all_of(brick.begin(), brick.end(), [&](uint16_t value) { return value == brick[0]; }))
+				{
+					result.constantCells.push_back({ cell, brick[0] });
+					continue;
+				}
+
+				result.cells.push_back(cell);
+				for (const auto value : brick)
+				{
+					const glm::vec4 texel = mediumScale * glm::unpackHalf1x16(value) + mediumOffset;
+					result.data.push_back(glm::packHalf4x16(texel));
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < threadCount; ++i)
+		{
+			threads.push_back(std::thread(ConvertCells, std::ref(results[i])));
+		}
+		ConvertCells(results[0]);
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		bricks.clear();
+		data.clear();
+		std::map<uint16_t, int> constantBricks;
+		for (const auto& result : results)
+		{
+			for (size_t i = 0; i < result.cells.size(); ++i)
+			{
+				bricks.push_back({ result.cells[i], static_cast<int>(data.size() / brickTexelCount) });
+				data.insert(data.end(), result.data.begin() + i * brickTexelCount, result.data.begin() + (i + 1) * brickTexelCount);
+			}
+		}
+		for (const auto& result : results)
+		{
+			for (const auto& constantCell : result.constantCells)
+			{
+				auto constantBrick = constantBricks.find(constantCell.second);
+				if (constantBrick == constantBricks.end())
+				{
+					const int dataIndex = static_cast<int>(data.size() / brickTexelCount);
+					const glm::vec4 texel = mediumScale * glm::unpackHalf1x16(constantCell.second) + mediumOffset;
+					data.insert(data.end(), brickTexelCount, glm::packHalf4x16(texel));
+					constantBrick = constantBricks.insert({ constantCell.second, dataIndex }).first;
+				}
+				bricks.push_back({ constantCell.first, constantBrick->second });
+			}
+		}
+		return true;
+	}
+
+	bool DensityGrids::LoadCache(const std::string& path, uint64_t signature,
+		std::vector<Brick>& bricks, std::vector<uint64_t>& data) const
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+
+		CacheHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader));
+		if (!file || header.magic != cacheMagic || header.version != cacheVersion || header.signature != signature)
+		{
+			printf("Density grid cache %s is outdated\n", path.c_str());
+			return false;
+		}
+
+		bricks.resize(header.brickCount);
+		data.resize(static_cast<size_t>(header.dataCount) * brickTexelCount);
+		file.read(reinterpret_cast<char*>(bricks.data()), bricks.size() * sizeof(Brick));
+		file.read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(uint64_t));
+		if (!file)
+		{
+			printf("Density grid cache %s is incomplete\n", path.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	void DensityGrids::SaveCache(const std::string& path, uint64_t signature,
+		const std::vector<Brick>& bricks, const std::vector<uint64_t>& data) const
+	{
+		std::ofstream file(path, std::ios::out | std::ios::binary);
+		if (!file)
+		{
+			printf("Unable to write density grid cache %s\n", path.c_str());
+			return;
+		}
+
+		const CacheHeader header = { cacheMagic, cacheVersion, signature,
+			static_cast<uint32_t>(bricks.size()), static_cast<uint32_t>(data.size() / brickTexelCount) };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+		file.write(reinterpret_cast<const char*>(bricks.data()), bricks.size() * sizeof(Brick));
+		file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(uint64_t));
+	}
+
+	void DensityGrids::GridInsertNodes(GridLevel* leafLevel)
+	{
+		nodeIndices_.clear();
+		const float cellSize = leafLevel->GetGridCellSize();
+		for (const auto& brick : bricks_)
+		{
+			//Offset into the cell to avoid rounding to the neighbor cell
+			nodeIndices_.push_back(leafLevel->AddNode((glm::vec3(brick.cell) + 0.5f) * cellSize));
+		}
+	}
+
+	void DensityGrids::AddContentStamps(std::vector<uint64_t>& leafStamps) const
+	{
+		for (const auto indexNode : nodeIndices_)
+		{
+			Math::HashCombine(leafStamps[indexNode], contentVersion_);
+		}
+	}
+
+	void DensityGrids::UpdateCopyRegions(const GridLevel* leafLevel)
+	{
+		copyRegions_.clear();
+		imageIndices_.clear();
+
+		VkBufferImageCopy region = {};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { brickResolution, brickResolution, brickResolution };
+
+		const auto& imageInfos = leafLevel->GetNodeData().imageInfos_;
+		for (size_t i = 0; i < bricks_.size(); ++i)
+		{
+			const auto& imageInfo = imageInfos[nodeIndices_[i]];
+			const glm::ivec3 texelOffset = imageInfo.image * brickResolution;
+			region.bufferOffset = static_cast<VkDeviceSize>(bricks_[i].dataIndex) * brickTexelCount * sizeof(uint64_t);
+			region.imageOffset = { texelOffset.x, texelOffset.y, texelOffset.z };
+			copyRegions_.push_back(region);
+			imageIndices_.push_back(imageInfo.imageIndex);
+		}
+		std::sort(imageIndices_.begin(), imageIndices_.end());
+	}
+
+	bool DensityGrids::ResizeGpuResources(std::vector<ResourceResize>& resourceResizes)
+	{
+		bool resize = false;
+		const VkDeviceSize size = std::max(brickData_.size(), brickTexelCount) * sizeof(uint64_t);
+		if (stagingBuffer_.size < size)
+		{
+			stagingBuffer_.size = size;
+			resize = true;
+		}
+		resourceResizes.push_back(stagingBuffer_);
+		return resize;
+	}
+
+	void DensityGrids::UpdateGpuResources(BufferManager* bufferManager)
+	{
+		if (!staged_ && !brickData_.empty())
+		{
+			auto dataPtr = bufferManager->Ref_Map(stagingBuffer_.index, 0, BufferManager::BUFFER_GRID_BIT);
+			memcpy(dataPtr, brickData_.data(), brickData_.size() * sizeof(uint64_t));
+			bufferManager->Ref_Unmap(stagingBuffer_.index, 0, BufferManager::BUFFER_GRID_BIT);
+			staged_ = true;
+		}
+	}
+
+	void DensityGrids::Dispatch(ImageManager* imageManager, BufferManager* bufferManager, VkCommandBuffer commandBuffer,
+		int atlasImageIndex)
+	{
+		if (copyRegions_.empty() || !staged_)
+		{
+			return;
+		}
+
+		vkCmdCopyBufferToImage(commandBuffer,
+			bufferManager->Ref_GetBuffer(stagingBuffer_.index, BufferManager::BUFFER_GRID_BIT, 0),
+			imageManager->Ref_GetImage(atlasImageIndex), VK_IMAGE_LAYOUT_GENERAL,
+			static_cast<uint32_t>(copyRegions_.size()), copyRegions_.data());
+
+		//The bricks are read by the mip mapping and may be overwritten by smoke and particles
+		std::vector<VkMemoryBarrier> memoryBarriers(1, { VK_STRUCTURE_TYPE_MEMORY_BARRIER });
+		memoryBarriers[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memoryBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		Wrapper::PipelineBarrierInfo pipelineBarrierInfo{};
+		pipelineBarrierInfo.src = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		pipelineBarrierInfo.dst = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		pipelineBarrierInfo.AddMemoryBarriers(memoryBarriers);
+		Wrapper::AddPipelineBarrier(commandBuffer, pipelineBarrierInfo);
+	}
+}
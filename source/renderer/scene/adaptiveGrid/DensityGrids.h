@@ -0,0 +1,99 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <glm\glm.hpp>
+#include <vulkan\vulkan.h>
+
+#include "AdaptiveGridData.h"
+#include "..\..\..\scene\components\AABoundingBox.h"
+
+class Scene;
+struct DensityGrid;
+
+namespace Renderer
+{
+	class GridLevel;
+	class BufferManager;
+	class ImageManager;
+
+	//Imports dense density grids authored in external tools into the leaf level of the grid
+	//Dense grid file: uint32 magic "DGRD", int32 resolution x, y, z followed by the densities as floats, x fastest
+	//The grid is converted into bricks of the leaf node images with the scene medium values applied
+	//Empty bricks are skipped and bricks with a constant density share their data
+	//The bricks are cached next to the source file in the image format so they can be copied directly
+	class DensityGrids
+	{
+	public:
+		//Resources:
+		//	- Staging buffer containing the brick data of all grids
+		void RequestResources(BufferManager* bufferManager);
+		//Loads the bricks of all density grids of the scene from the cache or converts the grids
+		void OnLoadScene(const Scene* scene, const AxisAlignedBoundingBox& gridBounds, float cellSize);
+		//Adds the nodes of all bricks into the leaf level
+		void GridInsertNodes(GridLevel* leafLevel);
+		//Needs to be called after the image indices for the grid are computed
+		void UpdateCopyRegions(const GridLevel* leafLevel);
+		//Incremented whenever the bricks are loaded
+		int GetContentVersion() const { return contentVersion_; }
+		//Combines the content version into the content stamps of the brick nodes
+		void AddContentStamps(std::vector<uint64_t>& leafStamps) const;
+		//Sorted atlas image indices of the bricks, they are filled completely by the copy
+		const std::vector<int>& GetImageIndices() const { return imageIndices_; }
+
+		bool ResizeGpuResources(std::vector<ResourceResize>& resourceResizes);
+		//Copies the brick data into the staging buffer once
+		void UpdateGpuResources(BufferManager* bufferManager);
+		//The staging buffer lost its content because the memory pool was recreated
+		void InvalidateGpuResources() { staged_ = false; }
+		//Copies the bricks into their atlas images
+		void Dispatch(ImageManager* imageManager, BufferManager* bufferManager, VkCommandBuffer commandBuffer, int atlasImageIndex);
+	private:
+		struct Brick
+		{
+			glm::ivec3 cell;		//leaf cell in the grid
+			int dataIndex;			//index of the brick data, shared by constant bricks with the same value
+		};
+
+		//Sample the dense grid at the texel positions of each leaf cell inside the grid bounds
+		bool Convert(const DensityGrid& densityGrid, const AxisAlignedBoundingBox& bounds, float cellSize, int cellsPerAxis,
+			std::vector<Brick>& bricks, std::vector<uint64_t>& data) const;
+		bool LoadCache(const std::string& path, uint64_t signature, std::vector<Brick>& bricks, std::vector<uint64_t>& data) const;
+		void SaveCache(const std::string& path, uint64_t signature, const std::vector<Brick>& bricks, const std::vector<uint64_t>& data) const;
+
+		std::vector<Brick> bricks_;
+		//Texels of all bricks as packed half floats in the atlas format
+		std::vector<uint64_t> brickData_;
+		std::vector<int> nodeIndices_;
+		std::vector<int> imageIndices_;
+		std::vector<VkBufferImageCopy> copyRegions_;
+
+		ResourceResize stagingBuffer_ = { 0, -1 };
+		bool staged_ = false;
+		int contentVersion_ = 0;
+	};
+}
@@ -109,6 +109,14 @@ namespace Renderer
 		parentChildIndices_[indexNode][childIndexGrid] = childIndexNode;
 	}
 
+	void GridLevel::SetNodeValueRange(float minExtinction, float maxExtinction, float maxScattering)
+	{
+		for (int i = 0; i < nodeData_.GetNodeCount(); ++i)
+		{
+			nodeData_.SetValueRange(i, minExtinction, maxExtinction, maxScattering);
+		}
+	}
+
 	glm::vec3 GridLevel::CalcGridPos_Level(const glm::vec3& gridPos_World)
 	{
 		return floor(gridPos_World / gridCellSize_);
@@ -163,11 +171,23 @@ namespace Renderer
 		}
 		childOffset_ = parentChildOffset + 1;
 
+		if (nodeData_.nodeGridIndex != versionGridIndices_ || nodeData_.parentIndices_ != versionParentIndices_)
+		{
+			versionGridIndices_ = nodeData_.nodeGridIndex;
+			versionParentIndices_ = nodeData_.parentIndices_;
+			++version_;
+		}
+
 		return childOffset;
 	}
 
 	void GridLevel::UpdateImageIndices(int atlasSideLength)
 	{
+		if (atlasSideLength != versionAtlasSideLength_)
+		{
+			versionAtlasSideLength_ = atlasSideLength;
+			++version_;
+		}
 		nodeData_.UpdateAtlasSideLength(atlasSideLength);
 		nodeData_.UpdateImageOffsets(parentImageOffset_);
 	}
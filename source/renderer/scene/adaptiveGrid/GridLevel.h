@@ -39,13 +39,6 @@ namespace Renderer
   class GridLevel
   {
   public:
-    struct NodePushData
-    {
-      int indexStart;
-      int indexEnd;
-      int imageIndex;
-    };
-
 		enum BufferType
 		{
 			BUFFER_NODE_INFOS,
@@ -68,6 +61,8 @@ namespace Renderer
 		int AddNode(const glm::vec3& gridPos_World);
 		void SetChildIndex(int childIndexGrid, int childIndexNode, int indexNode);
 		void SetLeafLevel() { leafLevel_ = true; }
+		//Sets the same value range for all nodes of the level
+		void SetNodeValueRange(float minExtinction, float maxExtinction, float maxScattering);
 
 		//Calculate the grid pos on this level 
 		glm::vec3 CalcGridPos_Level(const glm::vec3& gridPos_World);
@@ -104,6 +99,8 @@ namespace Renderer
 		bool HasParent() const { return parentLevel_ != nullptr; }
 		bool IsLeafLevel() const { return leafLevel_; }
 		int GetChildOffset() const { return childOffset_; }
+		//Incremented if the node layout or the atlas size changed since the last frame
+		int GetVersion() const { return version_; }
 	private:
 		//Calculate the grid pos on this level for a specific node by taking the parent offset into account
 		glm::vec3 CalcGridPos_Node(const glm::vec3& gridPos_World, const glm::vec3& parentGridPos_Level);
@@ -127,6 +124,12 @@ namespace Renderer
 
 		int childOffset_ = 0;
 
+		//Node layout of the last version, the image offsets and child indices follow from it
+		std::vector<int> versionGridIndices_;
+		std::vector<int> versionParentIndices_;
+		int versionAtlasSideLength_ = 0;
+		int version_ = 0;
+
 		//True if this is the most detailed level of the tree
 		bool leafLevel_ = false;
   };
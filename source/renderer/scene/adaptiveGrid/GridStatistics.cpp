@@ -0,0 +1,111 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "GridStatistics.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace Renderer
+{
+	const char* GridStatistics::stageNames[STAGE_MAX] =
+	{
+		"UpdateCBData",
+		"UpdateGrid",
+		"ResizeGpuResources",
+		"UpdateGpuResources"
+	};
+
+	void GridStatistics::Reset()
+	{
+		const bool wasEnabled = enabled;
+		*this = GridStatistics();
+		enabled = wasEnabled;
+	}
+
+	void GridStatistics::UpdateParticleHistogram(const std::map<int, std::vector<int>>& nodeParticles)
+	{
+		particlesPerNode.fill(0);
+		for (const auto& node : nodeParticles)
+		{
+			int bin = 0;
+			for (size_t count = node.second.size(); count > 1 && bin < particleBinCount - 1; count >>= 1)
+			{
+				bin++;
+			}
+			particlesPerNode[bin]++;
+		}
+	}
+
+	std::string GridStatistics::ToJson() const
+	{
+		const auto WriteArray = [](std::ostringstream& stream, const auto& values)
+		{
+			stream << "[";
+			for (size_t i = 0; i < values.size(); ++i)
+			{
+				stream << (i > 0 ? ", " : "") << values[i];
+			}
+			stream << "]";
+		};
+
+		std::ostringstream stream;
+		stream << "{\n";
+		stream << "\t\"nodesPerLevel\": ";
+		WriteArray(stream, nodesPerLevel);
+		stream << ",\n\t\"geometryNodesPerLevel\": ";
+		WriteArray(stream, geometryNodesPerLevel);
+		stream << ",\n\t\"atlasSideLength\": " << atlasSideLength;
+		stream << ",\n\t\"atlasImageCount\": " << atlasImageCount;
+		stream << ",\n\t\"atlasOccupancy\": " << atlasOccupancy;
+		stream << ",\n\t\"mipMapCount\": " << mipMapCount;
+		stream << ",\n\t\"particlesPerNode\": ";
+		WriteArray(stream, particlesPerNode);
+		stream << ",\n\t\"nodeInfoBytes\": " << nodeInfoBytes;
+		stream << ",\n\t\"activeBitBytes\": " << activeBitBytes;
+		stream << ",\n\t\"bitCountBytes\": " << bitCountBytes;
+		stream << ",\n\t\"childIndexBytes\": " << childIndexBytes;
+		stream << ",\n\t\"mappedBytes\": " << mappedBytes;
+		stream << ",\n\t\"uploadedBytes\": " << uploadedBytes;
+		stream << ",\n\t\"stageTimesMs\": {";
+		for (int i = 0; i < STAGE_MAX; ++i)
+		{
+			stream << (i > 0 ? ", " : "") << "\"" << stageNames[i] << "\": " << stageTimes[i];
+		}
+		stream << "}\n}\n";
+		return stream.str();
+	}
+
+	bool GridStatistics::SaveJson(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::out);
+		if (!file)
+		{
+			printf("Unable to write grid statistics %s\n", path.c_str());
+			return false;
+		}
+		file << ToJson();
+		return true;
+	}
+}
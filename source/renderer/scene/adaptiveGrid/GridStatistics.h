@@ -0,0 +1,78 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <map>
+#include <string>
+#include <cstdint>
+
+namespace Renderer
+{
+	//Per frame statistics of the grid build, only collected if enabled in the gui
+	struct GridStatistics
+	{
+		enum Stage
+		{
+			STAGE_UPDATE_CB_DATA,
+			STAGE_UPDATE_GRID,
+			STAGE_RESIZE_GPU_RESOURCES,
+			STAGE_UPDATE_GPU_RESOURCES,
+			STAGE_MAX
+		};
+		static const char* stageNames[STAGE_MAX];
+
+		//Bin i counts the nodes with [2^i, 2^(i+1)) particles, the last bin all nodes above
+		static constexpr int particleBinCount = 8;
+
+		bool enabled = false;
+		std::vector<int> nodesPerLevel;
+		std::vector<int> geometryNodesPerLevel;	//nodes overlapping scene meshes, candidates for occlusion pruning
+		int atlasSideLength = 0;
+		int atlasImageCount = 0;				//images used by nodes and mip maps
+		float atlasOccupancy = 0.0f;			//used images relative to the atlas capacity
+		int mipMapCount = 0;
+		std::array<int, particleBinCount> particlesPerNode = {};
+
+		//Sizes of the node buffers shared by all levels
+		uint64_t nodeInfoBytes = 0;
+		uint64_t activeBitBytes = 0;
+		uint64_t bitCountBytes = 0;
+		uint64_t childIndexBytes = 0;
+		//Node buffers mapped each frame and the bytes written into them
+		uint64_t mappedBytes = 0;
+		uint64_t uploadedBytes = 0;
+
+		std::array<float, STAGE_MAX> stageTimes = {};		//CPU time in ms
+
+		//Clears all values when the statistics are enabled again
+		void Reset();
+		//The key is the node index, the value the covering particle indices
+		void UpdateParticleHistogram(const std::map<int, std::vector<int>>& nodeParticles);
+		std::string ToJson() const;
+		bool SaveJson(const std::string& path) const;
+	};
+}
@@ -27,6 +27,9 @@ SOFTWARE.
 #include <math.h>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <limits>
+#include <cstring>
 
 #include "GridLevel.h"
 #include "AdaptiveGridConstants.h"
@@ -35,7 +38,10 @@ SOFTWARE.
 #include "..\..\passResources\ShaderBindingManager.h"
 #include "..\..\passes\GuiPass.h"
 #include "..\..\..\fileIO\FileDialog.h"
+#include "..\..\..\fileIO\BinaryExport.h"
 #include "..\..\..\utility\Status.h"
+#include "..\..\..\utility\Math.h"
+#include "..\..\..\utility\Noise.h"
 #include "..\..\wrapper\QueryPool.h"
 
 namespace
@@ -47,6 +53,9 @@ namespace
 	const glm::ivec2 debugStart = glm::ivec2(GridConstants::nodeResolution / 2);
 	const glm::ivec2 debugEnd = debugStart + glm::ivec2(2,1);
 	const char* mediumName = "groundFogMedium";
+
+	//One height per texel column of the medium level, neighboring nodes share the border texels
+	constexpr int heightfieldResolution = GridConstants::nodeResolution * GridConstants::nodeResolution + 1;
 }
 
 namespace Renderer
@@ -63,7 +72,8 @@ namespace Renderer
 		//cellBufferSize_ = (GridConstants::nodeResolution * GridConstants::nodeResolution + 1) * sizeof(PerCell);
 	}
 
-	void GroundFog::RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount, int atlasImageIndex)
+	void GroundFog::RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount, int atlasImageIndex,
+		int noiseImageIndex, float noiseTextureScale)
 	{
 		//Stores volumetric and fog values for all grid nodes
 		{
@@ -86,8 +96,19 @@ namespace Renderer
 			const int nodeResolutionSquared = GridConstants::nodeResolution * GridConstants::nodeResolution;
 			bufferInfo.size = (nodeResolutionSquared) * sizeof(PerNodeData);
 			nodeData_.resize(nodeResolutionSquared);
+			nodeDataSize_ = bufferInfo.size;
 			perNodeBuffer_ = bufferManager->Ref_RequestBuffer(bufferInfo);
 		}
+		//Grid space height of the fog surface per texel column
+		{
+			BufferManager::BufferInfo bufferInfo;
+			bufferInfo.typeBits = BufferManager::BUFFER_GRID_BIT;
+			bufferInfo.pool = BufferManager::MEMORY_GRID;
+			bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			bufferInfo.bufferingCount = frameCount;
+			bufferInfo.size = heightfieldResolution * heightfieldResolution * sizeof(float);
+			heightfieldBuffer_ = bufferManager->Ref_RequestBuffer(bufferInfo);
+		}
 
 		//Create optional texture to store density of ground fog
 		//Not added to a memory pool instead individual allocation
@@ -110,17 +131,21 @@ namespace Renderer
 		}
 
 		atlasImageIndex_ = atlasImageIndex;
+		noiseImageIndex_ = noiseImageIndex;
+		cbData_.noiseTextureScale = noiseTextureScale;
 	}
 
 	int GroundFog::GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount)
 	{
 		ShaderBindingManager::BindingInfo bindingInfo = {};
 		bindingInfo.pass = SUBPASS_VOLUME_ADAPTIVE_GROUND_FOG;
-		bindingInfo.resourceIndex = { atlasImageIndex_, cbIndex_, perNodeBuffer_ };
-		bindingInfo.stages = { VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT };
-		bindingInfo.types = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
+		bindingInfo.resourceIndex = { atlasImageIndex_, cbIndex_, perNodeBuffer_, noiseImageIndex_, heightfieldBuffer_ };
+		bindingInfo.stages = { VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT,
+			VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT };
+		bindingInfo.types = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
 		bindingInfo.Ref_image = true;
-		bindingInfo.refactoring_ = { true, true, true };
+		bindingInfo.refactoring_ = { true, true, true, true, true };
 		bindingInfo.setCount = frameCount;
 
 		if (createDebugTexture)
@@ -134,34 +159,165 @@ namespace Renderer
 		return bindingManager->RequestShaderBinding(bindingInfo);
 	}
 
-	void GroundFog::UpdateCBData(float heightPercentage, float scattering, float absorption, float phaseG, float noiseScale)
+	void GroundFog::UpdateCBData(float heightPercentage, float bandPercentage, float heightfieldAmplitude, float heightfieldScale,
+		float scattering, float absorption, float phaseG, float noiseScale, bool useNoiseVolume)
 	{
-		const float gridSpaceHeight = gridWorldSize_ - heightPercentage * gridWorldSize_;
-		gridYPos_ = static_cast<int>(floor(gridSpaceHeight / nodeWorldSize_));
-		coarseTexelPosition_ = gridYPos_ + 2;
-
 		cbData_.scattering = scattering;
 		cbData_.absorption = absorption + scattering;
 		cbData_.phaseG = phaseG;
 
-		const float cellSpaceHeight = gridSpaceHeight - gridYPos_ * nodeWorldSize_;
-		const float cellPercentage = 1.0f - cellSpaceHeight / nodeWorldSize_;
-		const float cellSpaceOffset = GridConstants::imageResolution * cellSpaceHeight / nodeWorldSize_;
-		cbData_.edgeTexelY = static_cast<int>(floor(cellSpaceOffset));
-		cbData_.cellFraction = (cbData_.edgeTexelY * childCellWorldSize_ - cellSpaceHeight) / childCellWorldSize_;
+		//The band covers at least one texel to avoid a hard edge
+		cbData_.bandWidth = std::max(bandPercentage * gridWorldSize_, childCellWorldSize_);
+		cbData_.heightfieldResolution = heightfieldResolution;
 
 		cbData_.noiseScale = noiseScale;
+		cbData_.noiseVolume = useNoiseVolume ? 1 : 0;
 
 		//Only add ground fog if a certain percentage is covered
 		active_ = heightPercentage > 0.0f;
+		if (!active_)
+		{
+			heightfieldSignature_ = 0;
+			gridYPos_ = GridConstants::nodeResolution;
+			coarseTexelStarts_.assign(GridConstants::imageResolution * GridConstants::imageResolution, 
+				GridConstants::imageResolution);
+			coveredBounds_.clear();
+			return;
+		}
+
+		const float gridSpaceHeight = gridWorldSize_ - heightPercentage * gridWorldSize_;
+		const float amplitude = heightfieldAmplitude * gridWorldSize_;
+		uint64_t signature = Math::hashSeed;
+		Math::HashCombine(signature, gridSpaceHeight);
+		Math::HashCombine(signature, amplitude);
+		Math::HashCombine(signature, heightfieldScale);
+		Math::HashCombine(signature, cbData_.bandWidth);
+		Math::HashCombine(signature, nodeWorldSize_);
+		if (signature != heightfieldSignature_)
+		{
+			UpdateHeightfield(gridSpaceHeight, amplitude, heightfieldScale);
+			UpdateCoveredCells();
+			heightfieldSignature_ = signature;
+		}
+		cbData_.coveredValue = GetCoveredValue();
+		std::copy(coarseTexelStarts_.begin(), coarseTexelStarts_.end(), &cbData_.coarseTexelStarts[0].x);
+	}
+
+	void GroundFog::UpdateHeightfield(float height, float amplitude, float scale)
+	{
+		//The scale is the frequency of the noise relative to the grid size
+		const float frequency = scale / gridWorldSize_;
+		heightfield_.resize(heightfieldResolution * heightfieldResolution);
+		for (int z = 0; z < heightfieldResolution; ++z)
+		{
+			for (int x = 0; x < heightfieldResolution; ++x)
+			{
+				const glm::vec3 position = glm::vec3(x, 0, z) * childCellWorldSize_ * frequency;
+				heightfield_[z * heightfieldResolution + x] = height - amplitude * Noise::Simplex(position);
+			}
+		}
+	}
+
+	void GroundFog::UpdateCoveredCells()
+	{
+		const int nodeResolution = GridConstants::nodeResolution;
+		bandRowStarts_.assign(nodeResolution * nodeResolution, nodeResolution);
+		bandRowEnds_.assign(nodeResolution * nodeResolution, nodeResolution);
+		coveredBounds_.clear();
+		gridYPos_ = nodeResolution;
+
+		for (int z = 0; z < nodeResolution; ++z)
+		{
+			for (int x = 0; x < nodeResolution; ++x)
+			{
+				float minHeight = std::numeric_limits<float>::max();
+				float maxHeight = std::numeric_limits<float>::lowest();
+				for (int tz = z * nodeResolution; tz <= (z + 1) * nodeResolution; ++tz)
+				{
+					for (int tx = x * nodeResolution; tx <= (x + 1) * nodeResolution; ++tx)
+					{
+						const float height = heightfield_[tz * heightfieldResolution + tx];
+						minHeight = std::min(minHeight, height);
+						maxHeight = std::max(maxHeight, height);
+					}
+				}
+
+				//Grid space y points downwards, rows below the band are fully covered
+				const int rowStart = glm::clamp(static_cast<int>(floor(minHeight / nodeWorldSize_)), 0, nodeResolution);
+				const int rowEnd = glm::clamp(static_cast<int>(ceil((maxHeight + cbData_.bandWidth) / nodeWorldSize_)),
+					rowStart, nodeResolution);
+				const int column = z * nodeResolution + x;
+				bandRowStarts_[column] = rowStart;
+				bandRowEnds_[column] = rowEnd;
+				gridYPos_ = std::min(gridYPos_, rowStart);
+			}
+		}
+
+		//Texels of the coarse level are shared by the adjacent cells, they can only contain fog if all
+		//of these cells lie below the band. Otherwise the fog would be interpolated into the empty cells
+		//and added a second time to the band cells, which have their own images
+		const int imageResolution = GridConstants::imageResolution;
+		coarseTexelStarts_.assign(imageResolution * imageResolution, imageResolution);
+		for (int z = 0; z < imageResolution; ++z)
+		{
+			for (int x = 0; x < imageResolution; ++x)
+			{
+				int fogRow = 0;
+				for (int cz = std::max(z - 1, 0); cz <= std::min(z, nodeResolution - 1); ++cz)
+				{
+					for (int cx = std::max(x - 1, 0); cx <= std::min(x, nodeResolution - 1); ++cx)
+					{
+						fogRow = std::max(fogRow, bandRowEnds_[cz * nodeResolution + cx]);
+					}
+				}
+				//Texel y lies between the cell rows y - 1 and y, both have to be fully covered
+				coarseTexelStarts_[z * imageResolution + x] = std::min(fogRow + 1, imageResolution);
+			}
+		}
+
+		//Cells touching a coarse texel without fog would only get the interpolated part of the fog,
+		//they are added to the band. The coarse fog at their lower corners is removed from their images
+		for (int z = 0; z < nodeResolution; ++z)
+		{
+			for (int x = 0; x < nodeResolution; ++x)
+			{
+				int texelStart = 0;
+				for (int tz = z; tz <= z + 1; ++tz)
+				{
+					for (int tx = x; tx <= x + 1; ++tx)
+					{
+						texelStart = std::max(texelStart, coarseTexelStarts_[tz * imageResolution + tx]);
+					}
+				}
+				const int column = z * nodeResolution + x;
+				bandRowEnds_[column] = std::max(bandRowEnds_[column], std::min(texelStart, nodeResolution));
+
+				const int rowEnd = bandRowEnds_[column];
+				if (rowEnd < nodeResolution)
+				{
+					coveredBounds_.push_back({ glm::vec3(x, rowEnd, z) * nodeWorldSize_,
+						glm::vec3(x + 1, nodeResolution, z + 1) * nodeWorldSize_ });
+				}
+			}
+		}
+	}
+
+	glm::vec4 GroundFog::GetCoveredValue() const
+	{
+		if (!active_)
+		{
+			return glm::vec4(0.0f);
+		}
+		//Mean density of the noise in the range [0,1]
+		const float density = 0.5f;
+		return glm::vec4(cbData_.scattering * density, cbData_.absorption * density, cbData_.phaseG, 0.0f);
 	}
 
 	void GroundFog::UpdateGridCells(GridLevel* gridLevel)
 	{
+		nodeIndices_.clear();
 		if (active_)
 		{
-			nodeIndices_.clear();
-
 			if (debugFilling)
 			{
 				//Only fill parts of the grid at a height of gridYPos_
@@ -176,28 +332,93 @@ namespace Renderer
 			}
 			else
 			{
-				for (size_t z = 0; z < GridConstants::nodeResolution; ++z)
+				for (int z = 0; z < GridConstants::nodeResolution; ++z)
 				{
-					for (size_t x = 0; x < GridConstants::nodeResolution; ++x)
+					for (int x = 0; x < GridConstants::nodeResolution; ++x)
 					{
-						glm::vec3 gridPos = glm::vec3(x, gridYPos_, z) * gridLevel->GetGridCellSize();
-						nodeIndices_.push_back(gridLevel->AddNode(gridPos));
+						const int column = z * GridConstants::nodeResolution + x;
+						for (int y = bandRowStarts_[column]; y < bandRowEnds_[column]; ++y)
+						{
+							glm::vec3 gridPos = glm::vec3(x, y, z) * gridLevel->GetGridCellSize();
+							nodeIndices_.push_back(gridLevel->AddNode(gridPos));
+						}
 					}
 				}
 			}
 		}	
 	}
 
+	void GroundFog::UpdateValueRange(GridLevel* gridLevel)
+	{
+		//The noise density is in the range [0,1], the coverage is zero at the heightfield
+		const float maxDensity = active_ ? 1.0f : 0.0f;
+		gridLevel->SetNodeValueRange(0.0f, maxDensity * cbData_.absorption, maxDensity * cbData_.scattering);
+	}
+
+	uint64_t GroundFog::CalcContentSignature() const
+	{
+		uint64_t signature = Math::hashSeed;
+		Math::HashCombine(signature, cbData_.scattering);
+		Math::HashCombine(signature, cbData_.absorption);
+		Math::HashCombine(signature, cbData_.phaseG);
+		Math::HashCombine(signature, cbData_.noiseScale);
+		Math::HashCombine(signature, cbData_.noiseVolume);
+		Math::HashCombine(signature, cbData_.texelWorldSize);
+		Math::HashCombine(signature, heightfieldSignature_);
+		return signature;
+	}
+
+	void GroundFog::AddContentStamps(std::vector<uint64_t>& nodeStamps) const
+	{
+		if (!active_)
+		{
+			return;
+		}
+		const uint64_t signature = CalcContentSignature();
+		for (const auto indexNode : nodeIndices_)
+		{
+			Math::HashCombine(nodeStamps[indexNode], signature);
+		}
+	}
+
+	void GroundFog::UpdateFilled(GridLevel* gridLevel, int atlasResolution)
+	{
+		const auto& imageInfos = gridLevel->GetNodeData().imageInfos_;
+
+		uint64_t signature = CalcContentSignature();
+		Math::HashCombine(signature, atlasResolution);
+		Math::HashCombine(signature, overlaySignature_);
+		keptImages_.clear();
+		for (const auto indexNode : nodeIndices_)
+		{
+			const int imageIndex = imageInfos[indexNode].imageIndex;
+			Math::HashCombine(signature, imageIndex);
+			keptImages_.push_back(imageIndex);
+		}
+		std::sort(keptImages_.begin(), keptImages_.end());
+
+		//The coverage of each node depends on the heightfield, all nodes are filled again if anything changed
+		dispatchCount_ = !cacheValid_ || signature != cacheSignature_ ? static_cast<int>(nodeIndices_.size()) : 0;
+
+		cacheSignature_ = signature;
+		cacheValid_ = true;
+	}
+
 	void GroundFog::UpdatePerNodeBuffer(BufferManager* bufferManager, GridLevel* gridLevel, int frameIndex, int atlasResolution)
 	{
-		if (active_)
+		if (!active_)
 		{
-			auto bufferDataPtr = bufferManager->Ref_Map(perNodeBuffer_, frameIndex, BufferManager::BUFFER_GRID_BIT);
+			cacheValid_ = false;
+			keptImages_.clear();
+			dispatchCount_ = 0;
+		}
+		else
+		{
+			UpdateFilled(gridLevel, atlasResolution);
 
 			nodeData_.clear();
 			//TODO check if these values are correct or the same as grid world size
 			const float cellSize = gridLevel->GetGridCellSize();
-			const float cellOffset = cellSize / gridLevel->gridResolution_ * 0.5f;
 
 			const auto& gridNodeData = gridLevel->GetNodeData();
 			const auto& nodeInfos = gridNodeData.GetNodeInfos();
@@ -210,22 +431,30 @@ namespace Renderer
 				nodeData_.push_back(nodeData);
 			}
 
-			dispatchCount_ = static_cast<int>(nodeData_.size());
+			if (dispatchCount_ > 0)
+			{
+				auto bufferDataPtr = bufferManager->Ref_Map(perNodeBuffer_, frameIndex, BufferManager::BUFFER_GRID_BIT);
+				memcpy(bufferDataPtr, nodeData_.data(), nodeData_.size() * sizeof(PerNodeData));
+				bufferManager->Ref_Unmap(perNodeBuffer_, frameIndex, BufferManager::BUFFER_GRID_BIT);
 
-			memcpy(bufferDataPtr, nodeData_.data(), nodeData_.size() * sizeof(PerNodeData));
-			bufferManager->Ref_Unmap(perNodeBuffer_, frameIndex, BufferManager::BUFFER_GRID_BIT);
+				bufferDataPtr = bufferManager->Ref_Map(heightfieldBuffer_, frameIndex, BufferManager::BUFFER_GRID_BIT);
+				memcpy(bufferDataPtr, heightfield_.data(), heightfield_.size() * sizeof(float));
+				bufferManager->Ref_Unmap(heightfieldBuffer_, frameIndex, BufferManager::BUFFER_GRID_BIT);
+			}
 		}
 	}
 
 	bool GroundFog::ResizeGPUResources(std::vector<ResourceResize>& resourceResizes)
 	{
-		const size_t newSize = nodeData_.size() * sizeof(NodeData);
+		//The nodes of this frame are already inserted but the per node data is filled later
+		const size_t newSize = nodeIndices_.size() * sizeof(PerNodeData);
 		const bool resize = nodeDataSize_ < newSize;
 		if (resize)
 		{
 			nodeDataSize_ = newSize;
 		}
 		resourceResizes.push_back({ nodeDataSize_, perNodeBuffer_ });
+		resourceResizes.push_back({ heightfieldResolution * heightfieldResolution * sizeof(float), heightfieldBuffer_ });
 		return resize;
 	}
 
@@ -296,15 +525,12 @@ namespace Renderer
 
 	void GroundFog::SaveTextureData(void* dataPtr, VkDeviceSize imageSize, const VkExtent3D& imageExtent)
 	{
-		const auto filePath = FileIO::SaveFileDialog(L"pbrt");
+		const auto filePath = FileIO::SaveFileDialog(L"vfog");
 		const auto fileName = FileIO::GetFileNameWithExtension(filePath);
 
-		std::ofstream file;
-		file.open(filePath.c_str(), std::ios::out);
-		if (file)
+		FileIO::BinaryWriter writer;
+		if (writer.Open(filePath, FileIO::EXPORT_FOG_VOLUME))
 		{
-			const auto floatValues = reinterpret_cast<glm::float32*>(dataPtr);
-			const auto elementSize = sizeof(glm::float32);
 			const auto elementCount = imageExtent.width * imageExtent.height * imageExtent.depth;
 
 			const auto& s_a = cbData_.absorption;
@@ -323,36 +549,26 @@ namespace Renderer
 			maxTexturePos.y = -minTexturePos.y;
 			minTexturePos.y = yMin;
 						
-			file <<
-				"\nAttributeBegin" <<
-				"\nMakeNamedMedium \"" << mediumName << "\"" <<
-				"\n\t\"string type\" \"heterogeneous\"" <<
-				"\n\t\"rgb	sigma_a\" [" << s_a << " " << s_a << " " << s_a << "]" <<
-				"\n\t\"rgb sigma_s\" [" << s_s << " " << s_s << " " << s_s << "]" <<
-				"\n\t\"float g\" " << cbData_.phaseG << "" <<
-				"\n\t\"point p0\" [" << minTexturePos.x << " " << minTexturePos.y << " " << minTexturePos.z << "]" <<
-				"\n\t\"point p1\" [" << maxTexturePos.x << " " << maxTexturePos.y << " " << maxTexturePos .z << "]" <<
-				"\n\t\"integer nx\" " << imageExtent.width << "" <<
-				"\n\t\"integer ny\" " << imageExtent.height << "" <<
-				"\n\t\"integer nz\" " << imageExtent.depth << "" <<
-
-				"\n\t\"float density\" [\n";
-
-			for (uint32_t i = 0; i < elementCount; ++i)
-			{
-				file << floatValues[i] << " ";
-				if (i % imageExtent.width == 0)
-				{
-					file << "\n";
-				}
-			}
-
-			file << "\n]" <<
-				"\nAttributeEnd\n";
+			FileIO::FogVolumeInfo info = {};
+			strncpy(info.mediumName, mediumName, sizeof(info.mediumName) - 1);
+			info.absorption = s_a;
+			info.scattering = s_s;
+			info.phaseG = cbData_.phaseG;
+			memcpy(info.p0, &minTexturePos.x, sizeof(info.p0));
+			memcpy(info.p1, &maxTexturePos.x, sizeof(info.p1));
+			info.nx = imageExtent.width;
+			info.ny = imageExtent.height;
+			info.nz = imageExtent.depth;
+			writer.Write(info);
+			//The density is copied into chunks, the file itself is written in the background
+			writer.Write(dataPtr, elementCount * sizeof(glm::float32));
+			writer.Close();
 
 			const float yOffset = maxTexturePos.y - cellSize * 0.5f;
 			
-			Status::UpdateGroundFog(fileName, mediumName, scale, yOffset);
+			//The scene includes the pbrt file created by the export converter next to the binary file
+			Status::UpdateGroundFog(FileIO::ReplaceExtension(fileName, "pbrt"), mediumName, scale, yOffset);
+			FileIO::BinaryWriter::PrintConverterCommand(filePath, FileIO::ReplaceExtension(filePath, "pbrt"));
 		}
 	}
 }
\ No newline at end of file
@@ -29,6 +29,8 @@ SOFTWARE.
 #include <vulkan\vulkan.h>
 
 #include "AdaptiveGridData.h"
+#include "AdaptiveGridConstants.h"
+#include "..\..\..\scene\components\AABoundingBox.h"
 
 namespace Renderer
 {
@@ -38,9 +40,10 @@ namespace Renderer
 	class ShaderBindingManager;
 	class QueueManager;
 
-	//Ground fog effect at a ceratin height with noise
-	//The top layer of the fog is the only one which is detailed
-	//below the top layer the coarser level is used
+	//Ground fog effect below a 2D heightfield with noise
+	//The density increases from zero at the heightfield to full density inside a band below it
+	//Only nodes intersecting the band get images, the fully covered nodes below use constant values
+	//in the image of the coarser level
 	class GroundFog
 	{
 	public:
@@ -51,29 +54,64 @@ namespace Renderer
 		//Resources:
 		//	- Constant buffer with volumetric values and fog variables
 		//	- Constant buffer with world offsets + image offsets per node
+		//	- Storage buffer with the heightfield
 		//	- Optional: 3D texture covering the whole ground fog in world space
-		void RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount, int atlasImageIndex);
+		void RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount, int atlasImageIndex,
+			int noiseImageIndex, float noiseTextureScale);
 		//Bindings:
 		//	- In: Volumetric, ground fog data CB
 		//	- In: Per node world, image offsets
+		//	- In: Precomputed noise volume
+		//	- In: Heightfield
 		//	- Out: Image atlas as storage image
 		//	- Out: Optional debug texture storage image
 		int GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount);
 		
 		//Calculate which nodes are covered by the ground fog
-		void UpdateCBData(float heightPercentage, float scattering, float absorption, float phaseG, float noiseScale);
-		//Inserts needed grid cells into the medium scale grid level
+		//The heightfield is the mean height plus noise scaled by the amplitude, heights are percentages of the grid size
+		//If useNoiseVolume is set the density is sampled from the noise volume instead of evaluating the noise
+		void UpdateCBData(float heightPercentage, float bandPercentage, float heightfieldAmplitude, float heightfieldScale,
+			float scattering, float absorption, float phaseG, float noiseScale, bool useNoiseVolume);
+		//Inserts the grid cells intersecting the band into the medium scale grid level
 		void UpdateGridCells(GridLevel* gridLevel);
+		
+		//First texel row of each texel column of the coarse image which is inside the fog,
+		//imageResolution if the column is not covered
+		const std::vector<int>& GetCoarseTexelStarts() const { return coarseTexelStarts_; }
+		//Scattering, extinction and phase function of the fully covered cells
+		glm::vec4 GetCoveredValue() const;
+		//Grid space bounds of the fully covered cells per column
+		const std::vector<AxisAlignedBoundingBox>& GetCoveredBounds() const { return coveredBounds_; }
+		//Stores the value range of the ground fog for all nodes of the level without reading back the images
+		//The neighbor update can copy fog values into the border of nodes not covered by the fog
+		void UpdateValueRange(GridLevel* gridLevel);
 		//Needs to be called after the image indices for the grid are computed
 		//Stores the world offsets and image offset for each node
+		//Nothing is dispatched if the fog parameters and the atlas images of the nodes are unchanged
 		void UpdatePerNodeBuffer(BufferManager* bufferManager, GridLevel* gridLevel, int frameIndex, int atlasResolution);
 		bool ResizeGPUResources(std::vector<ResourceResize>& resourceResizes);
+		//The content of the fog images is lost, e.g. the atlas was recreated or overwritten by debug filling
+		void InvalidateCache() { cacheValid_ = false; }
+		//Hash of the data other passes add onto the fog images, the fog is only filled again if it changes
+		void SetOverlaySignature(uint64_t signature) { overlaySignature_ = signature; }
+		//The fog images are filled in this frame, otherwise the kept images contain the content of the last frame
+		bool IsFilledThisFrame() const { return dispatchCount_ > 0; }
+		//Changes whenever the heightfield and the covered cells are recalculated, zero if inactive
+		uint64_t GetHeightfieldSignature() const { return heightfieldSignature_; }
+		//Combines the hash of the fog values into the content stamps of the fog nodes of the medium scale level
+		void AddContentStamps(std::vector<uint64_t>& nodeStamps) const;
+		//Indices of the fog nodes in the medium scale grid level
+		const std::vector<int>& GetNodeIndices() const { return nodeIndices_; }
+		//Sorted atlas image indices of the fog nodes which keep their content from the last frame
+		const std::vector<int>& GetKeptImages() const { return keptImages_; }
 
 		//Fills the ground fog with volumetric data based on 3D noise density
 		//If a debug texture is to be created it is filled and exported
 		void Dispatch(QueueManager* queueManager, ImageManager* imageManager, 
 			BufferManager* bufferManager, VkCommandBuffer commandBuffer, int frameIndex);
 	private:
+		//Texel columns of the coarse image packed into ivec4 for the std140 layout
+		static constexpr int texelStartVectors = (GridConstants::imageResolution * GridConstants::imageResolution + 3) / 4;
 		struct CBData
 		{
 			float scattering;
@@ -82,8 +120,13 @@ namespace Renderer
 
 			float texelWorldSize;
 			float noiseScale;
-			float cellFraction;		//amount that the edge texel is covered
-			int edgeTexelY;				//texel at which the height fog stops
+			float bandWidth;			//distance below the heightfield until full density is reached
+			int heightfieldResolution;
+			int noiseVolume;			//sample the precomputed noise
+			float noiseTextureScale;	//noise space to texture coordinates of the noise volume
+			glm::vec3 padding;
+			glm::vec4 coveredValue;		//value of the coarse texels with fog, it is removed from the band nodes
+			glm::ivec4 coarseTexelStarts[texelStartVectors];
 		};
 		
 		struct PerNodeData
@@ -92,6 +135,15 @@ namespace Renderer
 			uint32_t imageOffset;		//x,y,z values 10 bit 
 		};
 		
+		//Grid space height of the fog surface for each texel column of the level
+		void UpdateHeightfield(float height, float amplitude, float scale);
+		//Range of node rows per column which intersect the band, the texel starts and bounds for the coarse level
+		//The band is extended until the cells only touch coarse texels containing fog
+		void UpdateCoveredCells();
+		//Hash of the parameters which define the fog density
+		uint64_t CalcContentSignature() const;
+		//Compares the fog parameters and node images with the last filled ones, nothing is filled if they are equal
+		void UpdateFilled(GridLevel* gridLevel, int atlasResolution);
 		//Copy the ground fog density texture from GPU to CPU
 		void ExportGroundFogTexture(QueueManager* queueManager, ImageManager* imageManager, BufferManager* bufferManager);
 		//Save in PBRT file format
@@ -104,21 +156,34 @@ namespace Renderer
 		float gridWorldSize_ = 0.0f;
 		float nodeWorldSize_ = 0.0f;
 		bool active_ = false;
-		//Node position inside the grid
+		//Topmost node row of the fog inside the grid
 		int gridYPos_ = 15;
-		int coarseTexelPosition_ = 15;
 		int dispatchCount_ = 0;
+
+		std::vector<float> heightfield_;
+		uint64_t heightfieldSignature_ = 0;
+		//First and last node row per column with an image, rows below are fully covered by the coarse texels
+		std::vector<int> bandRowStarts_;
+		std::vector<int> bandRowEnds_;
+		std::vector<int> coarseTexelStarts_;
+		std::vector<AxisAlignedBoundingBox> coveredBounds_;
 				
 		CBData cbData_;
 		std::vector<PerNodeData> nodeData_;
 		size_t nodeDataSize_ = 0;
 		//Indices of the nodes inside the grid level
 		std::vector<int> nodeIndices_;
-		
+		std::vector<int> keptImages_;
+
+		uint64_t cacheSignature_ = 0;
+		uint64_t overlaySignature_ = 0;
+		bool cacheValid_ = false;
 		
 		int cbIndex_ = -1;
 		int perNodeBuffer_ = -1;
+		int heightfieldBuffer_ = -1;
 		int atlasImageIndex_ = -1;
+		int noiseImageIndex_ = -1;
 		//Used for storing the density of the ground fog in world space
 		int debugTextureIndex_ = -1;
 	};
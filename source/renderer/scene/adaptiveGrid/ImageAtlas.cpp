@@ -35,14 +35,14 @@ namespace Renderer
 	{}
 
 	void ImageAtlas::RequestResources(ImageManager* imageManager, BufferManager* bufferManager, 
-		ImageManager::ImageMemoryPool memoryPool, int frameCount)
+		ImageManager::ImageMemoryPool memoryPool, int frameCount, VkFormat format)
 	{
 		memoryPool_ = memoryPool;
 
 		ImageManager::Ref_ImageInfo imageInfo;
 		const uint32_t imageResolution = static_cast<uint32_t>(cbData_.imageResolution);
 		imageInfo.extent = { imageResolution,imageResolution,imageResolution };
-		imageInfo.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+		imageInfo.format = format;
 		imageInfo.imageType = ImageManager::IMAGE_GRID;
 		imageInfo.layout = VK_IMAGE_LAYOUT_GENERAL;
 		imageInfo.pool = memoryPool_;
@@ -68,7 +68,13 @@ namespace Renderer
 		cbData_.atlasSideLength = sideLength_;
 	}
 
-	void ImageAtlas::ResizeImage(ImageManager* imageManager)
+	void ImageAtlas::SetSideLength(int sideLength)
+	{
+		sideLength_ = std::max(1, sideLength);
+		cbData_.atlasSideLength = sideLength_;
+	}
+
+	bool ImageAtlas::ResizeImage(ImageManager* imageManager)
 	{
 		VkDeviceSize newSize = sideLength_ * cbData_.imageResolution;
 		auto& maxSize = imageResource.maxSize;
@@ -77,7 +83,9 @@ namespace Renderer
 		{
 			maxSize = newSize;
 			imageManager->Ref_ResizeImages(imageResource.index, maxSize, memoryPool_);
+			return true;
 		}
+		return false;
 	}
 
 }
\ No newline at end of file
@@ -41,13 +41,16 @@ namespace Renderer
 	public:
 		ImageAtlas(int imageResolution);
 		//Resources:
-		//	- R16G16B16A16_SFLOAT 3D Storage image 
+		//	- 3D Storage image, R16G16B16A16_SFLOAT by default
 		//	- Constant buffer containing the size and image resolution of the atlas
 		void RequestResources(ImageManager* imageManager, BufferManager* bufferManager, 
-			ImageManager::ImageMemoryPool memoryPool, int frameCount);
+			ImageManager::ImageMemoryPool memoryPool, int frameCount, VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT);
 		//Calculate new side length of the atlas
 		void UpdateSize(int maxImageOffset);
-		void ResizeImage(ImageManager* imageManager);
+		//Keeps the layout of an atlas stored with the given side length
+		void SetSideLength(int sideLength);
+		//Returns true if the image was recreated
+		bool ResizeImage(ImageManager* imageManager);
 
 		const int GetImageIndex() const { return imageResource.index; }
 		const int GetBufferIndex() const { return cbIndex_; }
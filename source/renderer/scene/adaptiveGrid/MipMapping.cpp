@@ -35,121 +35,98 @@ SOFTWARE.
 
 namespace Renderer
 {
-	MipMapping::MipMapping() :
-		mipMapImageAtlas_{GridConstants::nodeResolution + 1}		//One pixel padding for sampling of the texture
-	{}
-
-	void MipMapping::RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount, int atlasImageIndex)
+	namespace
 	{
-		mipMapImageAtlas_.RequestResources(imageManager, bufferManager, ImageManager::MEMORY_POOL_GRID_MIPMAP, frameCount);
-		
-		{
-			BufferManager::BufferInfo cbInfo;
-			cbInfo.typeBits = BufferManager::BUFFER_CONSTANT_BIT | BufferManager::BUFFER_SCENE_BIT;
-			cbInfo.pool = BufferManager::MEMORY_CONSTANT;
-			cbInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-			cbInfo.bufferingCount = frameCount;
-			cbInfo.data = &cbData_;
-			cbInfo.size = sizeof(CBData);
-			cbIndex_ = bufferManager->Ref_RequestBuffer(cbInfo);
-		}
+		//Minimum of maxComputeWorkGroupCount guaranteed by Vulkan
+		constexpr int maxWorkGroupCount = 65535;
+	}
 
+	void MipMapping::RequestResources(BufferManager* bufferManager, int frameCount, int atlasImageIndex, int nodeInfoBufferIndex)
+	{
+		BufferManager::BufferInfo storageBufferInfo;
+		storageBufferInfo.typeBits = BufferManager::BUFFER_GRID_BIT;
+		storageBufferInfo.pool = BufferManager::MEMORY_GRID;
+		storageBufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		storageBufferInfo.bufferingCount = frameCount;
+		storageBufferInfo.size = sizeof(int);
+		for (auto& bufferInfo : storageBuffers_)
 		{
-			BufferManager::BufferInfo storageBufferInfo;
-			storageBufferInfo.typeBits = BufferManager::BUFFER_GRID_BIT;
-			storageBufferInfo.pool = BufferManager::MEMORY_GRID;
-			storageBufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-			storageBufferInfo.bufferingCount = frameCount;
-			storageBufferInfo.size = sizeof(int);
-			for (auto& bufferInfo : storageBuffers_)
-			{
-				bufferInfo.index = bufferManager->Ref_RequestBuffer(storageBufferInfo);
-				bufferInfo.size = storageBufferInfo.size;
-			}
+			//The value ranges and averages are only written by the GPU, the ranges are read in later frames
+			const bool gpuOnly = &bufferInfo == &storageBuffers_[BUFFER_VALUE_RANGES] ||
+				&bufferInfo == &storageBuffers_[BUFFER_CHILD_AVERAGES];
+			storageBufferInfo.bufferingCount = gpuOnly ? 1 : frameCount;
+			bufferInfo.index = bufferManager->Ref_RequestBuffer(storageBufferInfo);
+			bufferInfo.size = storageBufferInfo.size;
 		}
 
 		atlasImageIndex_ = atlasImageIndex;
+		nodeInfoBufferIndex_ = nodeInfoBufferIndex;
+		uploadedVersions_.assign(frameCount, -1);
 	}
 
-	int MipMapping::GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount, int pass)
+	int MipMapping::GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount)
 	{
 		ShaderBindingManager::BindingInfo bindingInfo = {};
 		bindingInfo.setCount = frameCount;
 
 		bindingManager_ = bindingManager;
 
-		switch (pass)
-		{
-		case MIPMAP_AVERAGING:
-		{
-			ShaderBindingManager::PushConstantInfo pushConstantInfo{};
-			VkPushConstantRange objectIds = {};
-			objectIds.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-			objectIds.offset = 0;
-			objectIds.size = sizeof(int);
-			pushConstantInfo.pushConstantRanges.push_back(objectIds);
-			pushConstantInfo.pass = SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING;
-			perLevelPushConstantIndex_ = bindingManager->RequestPushConstants(pushConstantInfo)[0];
-
-			bindingInfo.pass = SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING;
-			bindingInfo.resourceIndex = { atlasImageIndex_, cbIndex_, 
-				storageBuffers_[pass].index, mipMapImageAtlas_.GetImageIndex() };
-			bindingInfo.stages = { VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT,
-				VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT };
-			bindingInfo.types = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 
-				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE };
-			bindingInfo.Ref_image = true;
-			bindingInfo.refactoring_ = { true, true, true, true };
-		} break;
-		case MIPMAP_MERGING:
-		{
-			ShaderBindingManager::PushConstantInfo pushConstantInfo{};
-			VkPushConstantRange objectIds = {};
-			objectIds.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-			objectIds.offset = 0;
-			objectIds.size = sizeof(int);
-			pushConstantInfo.pushConstantRanges.push_back(objectIds);
-			pushConstantInfo.pass = SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING_MERGING;
-			perLevelMergingPushConstantIndex_ = bindingManager->RequestPushConstants(pushConstantInfo)[0];
-
-			bindingInfo.pass = SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING_MERGING;
-			bindingInfo.resourceIndex = { atlasImageIndex_, mipMapImageAtlas_.GetImageIndex(),
-				cbIndex_, storageBuffers_[pass].index };
-			bindingInfo.stages = { VK_SHADER_STAGE_COMPUTE_BIT,VK_SHADER_STAGE_COMPUTE_BIT,
-				VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT };
-			bindingInfo.types = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
-			bindingInfo.Ref_image = true;
-			bindingInfo.refactoring_ = { true, true, true, true };
-		} break;
-		}
+		ShaderBindingManager::PushConstantInfo pushConstantInfo{};
+		VkPushConstantRange objectIds = {};
+		objectIds.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		objectIds.offset = 0;
+		objectIds.size = sizeof(PushConstants);
+		pushConstantInfo.pushConstantRanges.push_back(objectIds);
+		pushConstantInfo.pass = SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING;
+		perLevelPushConstantIndex_ = bindingManager->RequestPushConstants(pushConstantInfo)[0];
+
+		bindingInfo.pass = SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING;
+		bindingInfo.resourceIndex = { atlasImageIndex_, 
+			storageBuffers_[BUFFER_CHILD_NODES].index, storageBuffers_[BUFFER_PARENT_NODES].index, nodeInfoBufferIndex_,
+			storageBuffers_[BUFFER_DIRTY_PARENTS].index, storageBuffers_[BUFFER_VALUE_RANGES].index,
+			storageBuffers_[BUFFER_DIRTY_CHILDREN].index, storageBuffers_[BUFFER_CHILD_AVERAGES].index };
+		bindingInfo.stages = { VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT,
+			VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT,
+			VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT };
+		bindingInfo.types = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
+		bindingInfo.Ref_image = true;
+		bindingInfo.refactoring_ = { true, true, true, true, true, true, true, true };
 
 		return bindingManager->RequestShaderBinding(bindingInfo);
 	}
 
 	void MipMapping::UpdateMipMapNodes(const GridLevel* parentLevel, const GridLevel* childLevel)
 	{
-		//Clear the vectors on a new frame if the top most level is called
+		//Start a new frame if the top most level is called
 		if (!parentLevel->HasParent())
 		{
-			perChildData_.clear();
-			mipmapIndices_.clear();
-			perLevelDataChild_.clear();
-			perLevelChildCount_.clear();
-			mipmapCount_ = 0;
-
-			perParentData_.clear();
-			perLevelDataParent_.clear(); 
-			perLevelParentCount_.clear();
+			currentLevel_ = 0;
+			dataChanged_ = false;
 		}
+		const int level = currentLevel_++;
 
-		LevelData_New levelData;
-		levelData.averagingStart = static_cast<uint32_t>(perChildData_.size());
+		//The data of all levels is stored consecutively, a level can only be kept if all levels above are kept
+		const auto versions = std::make_pair(parentLevel->GetVersion(), childLevel->GetVersion());
+		if (!dataChanged_)
+		{
+			if (level < static_cast<int>(levelVersions_.size()) && levelVersions_[level] == versions)
+			{
+				return;
+			}
+			RemoveLevels(level);
+			dataChanged_ = true;
+			++dataVersion_;
+		}
+		levelVersions_.push_back(versions);
 
 		const auto& nodeDataParent = parentLevel->GetNodeData();
 		const auto& nodeInfoParent = nodeDataParent.GetNodeInfos();
 		const int parentNodeCount = nodeDataParent.GetNodeCount();
-		perLevelDataParent_.push_back({ static_cast<uint32_t>(mipmapCount_ )});
+		perLevelDataChild_.push_back({ static_cast<uint32_t>(perChildData_.size()) });
+		perLevelDataParent_.push_back({ static_cast<uint32_t>(perParentData_.size()) });
 		const auto& childNodeIndices = parentLevel->GetChildIndices();
 
 		const auto& nodeDataChild = childLevel->GetNodeData();
@@ -167,56 +144,172 @@ namespace Renderer
 		for (int parentNodeIndex = 0; parentNodeIndex < parentNodeCount; ++parentNodeIndex)
 		{
 			const int nodeCount = nodeDataParent.childCount_[parentNodeIndex];
-			//for each child store the start in the image atlas 
-			for (int i = childNodeOffset; i < nodeCount + childNodeOffset; ++i)
-			{
-				const int childNodeIndex = childNodeIndices[i] + parentNodeOffset;
-				perChildData_.push_back(GetChildNodeData(nodeDataChild, childNodeIndex, childIsLeafLevel));
-				mipmapIndices_.push_back(mipmapCount_);
-			}
-			//Advance the number of needed mipmaps for parent nodes with active children
+			//Only parent nodes with active children are mip mapped
 			if (nodeCount > 0)
 			{
 				const auto& parentNodeInfo = nodeInfoParent[parentNodeIndex];
 				ParentNodeData parentData;
 				parentData.imageAtlasOffset = parentNodeInfo.textureOffset;
 				parentData.imageAtlas_mipmapOffset = parentNodeInfo.textureOffsetMipMap;
-				parentData.mipmapOffset = mipmapCount_;
+				parentData.childStart = static_cast<uint32_t>(perChildData_.size());
+				parentData.childCount = static_cast<uint32_t>(nodeCount);
 				perParentData_.push_back(parentData);
-				
-				mipmapCount_++;
+				perParentNodeIndex_.push_back(parentNodeIndex);
+			}
+			//for each child store the start in the image atlas 
+			for (int i = childNodeOffset; i < nodeCount + childNodeOffset; ++i)
+			{
+				const int childNodeIndex = childNodeIndices[i] + parentNodeOffset;
+				perChildData_.push_back(GetChildNodeData(nodeDataChild, childNodeIndex, -parentNodeOffset, childIsLeafLevel));
 			}
 
 			childNodeOffset += nodeCount;
 		}
 
-		perLevelDataChild_.push_back(levelData);
-		perLevelChildCount_.push_back(childNodeOffset);
-		perLevelParentCount_.push_back(mipmapCount_ - perLevelDataParent_.back().averagingStart);
+		perLevelParentCount_.push_back(static_cast<int>(perParentData_.size() - perLevelDataParent_.back().averagingStart));
 	}
 	
+	void MipMapping::UpdateDirtyNodes(const std::vector<GridLevel>& gridLevels, 
+		const std::vector<std::vector<uint64_t>>& contentStamps, bool forceAll, int atlasSideLength)
+	{
+		const int levelCount = static_cast<int>(gridLevels.size());
+		valueRangeCount_ = atlasSideLength * atlasSideLength * atlasSideLength;
+
+		//The key identifies the position of a node inside the tree, calculated from the root downwards
+		std::vector<std::vector<uint64_t>> keys(levelCount);
+		for (int level = 0; level < levelCount; ++level)
+		{
+			const auto& nodeData = gridLevels[level].GetNodeData();
+			keys[level].resize(nodeData.GetNodeCount(), Math::hashSeed);
+			for (int i = 0; i < nodeData.GetNodeCount(); ++i)
+			{
+				if (level > 0)
+				{
+					keys[level][i] = keys[level - 1][nodeData.parentIndices_[i]];
+				}
+				Math::HashCombine(keys[level][i], nodeData.nodeGridIndex[i]);
+			}
+		}
+
+		//The states are calculated from the leaf level upwards, the children of each parent are summed
+		//because their order does not change the mip map
+		std::vector<uint64_t> imageStates(valueRangeCount_, 0);
+		std::vector<std::vector<bool>> dirty(levelCount);
+		std::vector<uint64_t> childStates;
+		for (int level = levelCount - 1; level >= 0; --level)
+		{
+			const auto& nodeData = gridLevels[level].GetNodeData();
+			const int nodeCount = nodeData.GetNodeCount();
+			std::vector<uint64_t> parentChildStates(level > 0 ? gridLevels[level - 1].GetNodeCount() : 0, 0);
+			dirty[level].resize(nodeCount, forceAll);
+			for (int i = 0; i < nodeCount; ++i)
+			{
+				const auto& imageInfo = nodeData.imageInfos_[i];
+				uint64_t state = keys[level][i];
+				Math::HashCombine(state, contentStamps[level][i]);
+				Math::HashCombine(state, imageInfo.imageIndex);
+				Math::HashCombine(state, imageInfo.mipMapImageIndex);
+				if (!childStates.empty())
+				{
+					Math::HashCombine(state, childStates[i]);
+				}
+				
+				const int imageIndex = imageInfo.imageIndex;
+				if (imageIndex < valueRangeCount_)
+				{
+					imageStates[imageIndex] = state;
+					if (imageIndex >= static_cast<int>(imageStates_.size()) || imageStates_[imageIndex] != state)
+					{
+						dirty[level][i] = true;
+					}
+				}
+				if (level > 0)
+				{
+					parentChildStates[nodeData.parentIndices_[i]] += state;
+				}
+			}
+			childStates.swap(parentChildStates);
+		}
+		//Forced mip maps do not depend on the states, the following frame has to write all of them again
+		imageStates_.swap(imageStates);
+		if (forceAll)
+		{
+			imageStates_.clear();
+		}
+		UpdateDirtyParents([&](int level, int indexNode) { return dirty[level][indexNode]; });
+	}
+
+	template<class IsDirty>
+	void MipMapping::UpdateDirtyParents(IsDirty isDirty)
+	{
+		dirtyParents_.clear();
+		perLevelDirtyStart_.clear();
+		perLevelDirtyCount_.clear();
+		dirtyChildren_.clear();
+		perLevelDirtyChildStart_.clear();
+		perLevelDirtyChildCount_.clear();
+		for (size_t level = 0; level < perLevelDataParent_.size(); ++level)
+		{
+			perLevelDirtyStart_.push_back(static_cast<int>(dirtyParents_.size()));
+			perLevelDirtyChildStart_.push_back(static_cast<int>(dirtyChildren_.size()));
+			const int parentStart = perLevelDataParent_[level].averagingStart;
+			for (int i = parentStart; i < parentStart + perLevelParentCount_[level]; ++i)
+			{
+				if (isDirty(static_cast<int>(level), perParentNodeIndex_[i]))
+				{
+					dirtyParents_.push_back(i);
+					const auto& parentData = perParentData_[i];
+					for (uint32_t child = 0; child < parentData.childCount; ++child)
+					{
+						dirtyChildren_.push_back(static_cast<int>(parentData.childStart + child));
+					}
+				}
+			}
+			perLevelDirtyCount_.push_back(static_cast<int>(dirtyParents_.size()) - perLevelDirtyStart_.back());
+			perLevelDirtyChildCount_.push_back(static_cast<int>(dirtyChildren_.size()) - perLevelDirtyChildStart_.back());
+		}
+	}
+
 	void MipMapping::UpdateGpuResources(BufferManager* bufferManager, int frameIndex)
 	{
 		if (perChildData_.empty())
 		{
 			return;
 		}
-
 		const int bufferTypeBits = BufferManager::BUFFER_GRID_BIT;
-		for (int i = 0; i < MIPMAP_MAX; ++i)
+		const auto UploadIndices = [&](StorageBuffers buffer, const std::vector<int>& indices)
+		{
+			if (!indices.empty())
+			{
+				const int bufferIndex = storageBuffers_[buffer].index;
+				auto bufferPtr = bufferManager->Ref_Map(bufferIndex, frameIndex, bufferTypeBits);
+				memcpy(bufferPtr, indices.data(), sizeof(int) * indices.size());
+				bufferManager->Ref_Unmap(bufferIndex, frameIndex, bufferTypeBits);
+			}
+		};
+		UploadIndices(BUFFER_DIRTY_PARENTS, dirtyParents_);
+		UploadIndices(BUFFER_DIRTY_CHILDREN, dirtyChildren_);
+
+		if (uploadedVersions_[frameIndex] == dataVersion_)
+		{
+			return;
+		}
+		uploadedVersions_[frameIndex] = dataVersion_;
+
+		for (int i = BUFFER_CHILD_NODES; i <= BUFFER_PARENT_NODES; ++i)
 		{
 			const int bufferIndex = storageBuffers_[i].index;
 			auto bufferPtr = bufferManager->Ref_Map(bufferIndex, frameIndex, bufferTypeBits);
 
 			void* source = nullptr;
-			VkDeviceSize copySize = CalcStorageBufferSize(static_cast<Passes>(i));
+			VkDeviceSize copySize = CalcStorageBufferSize(static_cast<StorageBuffers>(i));
 
 			switch (i)
 			{
-			case MIPMAP_AVERAGING:
+			case BUFFER_CHILD_NODES:
 				source = perChildData_.data();
 				break;
-			case MIPMAP_MERGING:
+			case BUFFER_PARENT_NODES:
 				source = perParentData_.data();
 				break;
 			}
@@ -226,14 +319,12 @@ namespace Renderer
 		}
 	}
 
-	bool MipMapping::ResizeGpuResources(ImageManager* imageManager, std::vector<ResourceResize>& resourceResizes)
+	bool MipMapping::ResizeGpuResources(std::vector<ResourceResize>& resourceResizes)
 	{
-		UpdateImageOffsets(imageManager);
-
 		bool resize = false;
-		for (int i = 0; i < MIPMAP_MAX; ++i)
+		for (int i = 0; i < BUFFER_MAX; ++i)
 		{
-			const auto newSize = CalcStorageBufferSize(static_cast<Passes>(i));
+			const auto newSize = CalcStorageBufferSize(static_cast<StorageBuffers>(i));
 			if (storageBuffers_[i].size < newSize)
 			{
 				resize = true;
@@ -244,64 +335,67 @@ namespace Renderer
 		return resize;
 	}
 
-	void MipMapping::Dispatch(ImageManager* imageManager, BufferManager* bufferManager, VkCommandBuffer commandBuffer, int frameIndex, int level, int pass)
+	void MipMapping::InvalidateGpuResources()
+	{
+		uploadedVersions_.assign(uploadedVersions_.size(), -1);
+		//The atlas is recreated after the changed parents of the frame were calculated
+		imageStates_.clear();
+		UpdateDirtyParents([](int, int) { return true; });
+	}
+
+	void MipMapping::Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex, int level)
 	{
 		Wrapper::TimeStamps timeStampMipMapping;
-		Wrapper::TimeStamps timeStampMipMappingMerging;
 		switch (level)
 		{
 		case 0:
 			timeStampMipMapping = Wrapper::TIMESTAMP_GRID_MIPMAPPING_0;
-			timeStampMipMappingMerging = Wrapper::TIMESTAMP_GRID_MIPMAPPING_MERGIN_0;
 			break;
 		case 1:
 			timeStampMipMapping = Wrapper::TIMESTAMP_GRID_MIPMAPPING_1;
-			timeStampMipMappingMerging = Wrapper::TIMESTAMP_GRID_MIPMAPPING_MERGIN_1;
 			break;
 		}
 
-		switch (pass)
-		{
-		case MIPMAP_AVERAGING:
-		{
-			const uint32_t dispatchCount = static_cast<uint32_t>(perLevelChildCount_[level]);
+		auto& queryPool = Wrapper::QueryPool::GetInstance();
+		queryPool.TimestampStart(commandBuffer, timeStampMipMapping, frameIndex);
 
-			if (dispatchCount > 0)
+		const auto pipelineLayout = bindingManager_->GetPipelineLayout(SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING);
+		const int dirtyCount = level < static_cast<int>(perLevelDirtyCount_.size()) ? perLevelDirtyCount_[level] : 0;
+		if (dirtyCount > 0)
+		{
+			//One work group per child, split to stay below the work group count limit
+			const int childStart = perLevelDirtyChildStart_[level];
+			const int childEnd = childStart + perLevelDirtyChildCount_[level];
+			for (int start = childStart; start < childEnd; start += maxWorkGroupCount)
 			{
-				auto& queryPool = Wrapper::QueryPool::GetInstance();
-				queryPool.TimestampStart(commandBuffer, timeStampMipMapping, frameIndex);
-
-				vkCmdPushConstants(commandBuffer, bindingManager_->GetPipelineLayout(SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING),
-					VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(int), &perLevelDataChild_[level].averagingStart);
-				vkCmdDispatch(commandBuffer, dispatchCount, 1, 1);
-
-				queryPool.TimestampEnd(commandBuffer, timeStampMipMapping, frameIndex);
+				const int count = std::min(childEnd - start, maxWorkGroupCount);
+				const PushConstants reduceConstants = { start, count, PASS_REDUCE_CHILDREN };
+				vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &reduceConstants);
+				vkCmdDispatch(commandBuffer, static_cast<uint32_t>(count), 1, 1);
 			}
+			AddBarrier(imageManager, commandBuffer, false);
 
-			AddBarriers(imageManager, commandBuffer, frameIndex);
+			const PushConstants pushConstants = { perLevelDirtyStart_[level], dirtyCount, PASS_MERGE };
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+			vkCmdDispatch(commandBuffer, static_cast<uint32_t>(dirtyCount), GridConstants::imageResolution, 1);
 		}
-		break;
-		case MIPMAP_MERGING:
+		//The node infos are uploaded each frame, the ranges of the children of unchanged parents are copied as well
+		if (level == 0 && !perChildData_.empty())
 		{
-			const uint32_t dispatchCount = static_cast<uint32_t>(perLevelParentCount_[level]);
-
-			auto& queryPool = Wrapper::QueryPool::GetInstance();
-			queryPool.TimestampStart(commandBuffer, timeStampMipMappingMerging, frameIndex);
-			
-			vkCmdPushConstants(commandBuffer, bindingManager_->GetPipelineLayout(SUBPASS_VOLUME_ADAPTIVE_MIPMAPPING_MERGING),
-				VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(int), &perLevelDataParent_[level].averagingStart);
-			vkCmdDispatch(commandBuffer, dispatchCount, 1, 1);
-			
-			queryPool.TimestampEnd(commandBuffer, timeStampMipMappingMerging, frameIndex);
-
-			const bool firstLevel = level == perLevelDataChild_.size() - 1;
-			AddMergingBarrier(imageManager, commandBuffer, frameIndex, !firstLevel);
-		}
-		break;
+			AddBarrier(imageManager, commandBuffer, false);
+			const int childCount = static_cast<int>(perChildData_.size());
+			const int threadCount = GridConstants::imageResolution * GridConstants::imageResolution;
+			const PushConstants pushConstants = { 0, childCount, PASS_VALUE_RANGES };
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+			vkCmdDispatch(commandBuffer, static_cast<uint32_t>((childCount + threadCount - 1) / threadCount), 1, 1);
 		}
+
+		queryPool.TimestampEnd(commandBuffer, timeStampMipMapping, frameIndex);
+
+		AddBarrier(imageManager, commandBuffer, level == 0);
 	}
 
-	MipMapping::ChildNodeData MipMapping::GetChildNodeData(const Renderer::NodeData& data, int childNodeIndex, bool leafLevel)
+	MipMapping::ChildNodeData MipMapping::GetChildNodeData(const Renderer::NodeData& data, int childNodeIndex, int nodeOffset, bool leafLevel)
 	{
 		const auto& nodeInfo = data.GetNodeInfos()[childNodeIndex];
 
@@ -309,97 +403,74 @@ namespace Renderer
 		childNodeData.imageOffset = leafLevel ? nodeInfo.textureOffset : nodeInfo.textureOffsetMipMap;
 		//The parent texel is based on the node position of the child node
 		childNodeData.parentTexel = NodeData::PackTextureOffset(data.gridPos_[childNodeIndex]);
+		//The value range is calculated for the original image which is sampled during raymarching
+		childNodeData.nodeImageOffset = nodeInfo.textureOffset;
+		childNodeData.nodeIndex = childNodeIndex + nodeOffset;
+		childNodeData.valueRangeIndex = data.imageInfos_[childNodeIndex].imageIndex;
 		return childNodeData;
 	}
 
-	void MipMapping::UpdateImageOffsets(ImageManager* imageManager)
+	void MipMapping::RemoveLevels(int level)
 	{
-		mipMapImageAtlas_.UpdateSize(mipmapCount_);
-
-		const int atlasSideLength = mipMapImageAtlas_.GetSideLength();
-		const int atlasResolution = mipMapImageAtlas_.GetResolution();
-		//Add the offsets into the image atlas to the texel coordinates
-		for (size_t i = 0; i < mipmapIndices_.size(); ++i)
+		levelVersions_.resize(std::min(levelVersions_.size(), static_cast<size_t>(level)));
+		if (level >= static_cast<int>(perLevelDataChild_.size()))
 		{
-			const int mipmapIndex = mipmapIndices_[i];
-			const auto atlasOffset = Math::Index1Dto3D(mipmapIndex, atlasSideLength)
-				* atlasResolution;
-			const uint32_t offset = NodeData::PackTextureOffset(atlasOffset);
-			perChildData_[i].parentTexel += offset;
-			perParentData_[mipmapIndex].mipmapOffset = offset;
+			return;
 		}
-		
-		mipMapImageAtlas_.ResizeImage(imageManager);
-	}
-	
-	void MipMapping::UpdateAtlasProperties(int atlasSideLength, int atlasResolution)
-	{
-		cbData_.atlasSideLength_Reciprocal = 1.0f / atlasSideLength;
-		cbData_.texelSize = 1.0f / (atlasResolution * atlasSideLength);
-		cbData_.texelSize_Half = cbData_.texelSize * 0.5f;
-		cbData_.texelSizeMipmap = 1.0f / (mipMapImageAtlas_.GetResolution() * mipMapImageAtlas_.GetSideLength());
+
+		perChildData_.resize(perLevelDataChild_[level].averagingStart);
+		perLevelDataChild_.resize(level);
+
+		perParentData_.resize(perLevelDataParent_[level].averagingStart);
+		perParentNodeIndex_.resize(perParentData_.size());
+		perLevelDataParent_.resize(level);
+		perLevelParentCount_.resize(level);
 	}
 
-	int MipMapping::CalcStorageBufferSize(MipMapping::Passes pass)
+	int MipMapping::CalcStorageBufferSize(MipMapping::StorageBuffers buffer)
 	{
-		switch (pass)
+		switch (buffer)
 		{
-		case MIPMAP_AVERAGING:
+		case BUFFER_CHILD_NODES:
 			return static_cast<int>(sizeof(ChildNodeData) * std::max(perChildData_.size(), 1ull));
-		case MIPMAP_MERGING:
+		case BUFFER_PARENT_NODES:
 			return static_cast<int>(sizeof(ParentNodeData) * std::max(perParentData_.size(), 1ull));
+		case BUFFER_DIRTY_PARENTS:
+			return static_cast<int>(sizeof(int) * std::max(perParentData_.size(), 1ull));
+		case BUFFER_VALUE_RANGES:
+			return static_cast<int>(sizeof(ValueRange) * std::max(valueRangeCount_, 1));
+		case BUFFER_DIRTY_CHILDREN:
+			return static_cast<int>(sizeof(int) * std::max(perChildData_.size(), 1ull));
+		case BUFFER_CHILD_AVERAGES:
+			return static_cast<int>(sizeof(glm::vec4) * std::max(perChildData_.size(), 1ull));
 		default:
-			printf("Invalide mip mapping buffer type %d\n", pass);
+			printf("Invalide mip mapping buffer type %d\n", buffer);
 			return 0;
 		}
 	}
 
-	void MipMapping::AddBarriers(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex)
-	{
-		Wrapper::PipelineBarrierInfo pipelineBarrierInfo{};
-		pipelineBarrierInfo.src = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-		pipelineBarrierInfo.dst = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-				
-		
-		ImageManager::BarrierInfo imageAtlasBarrier{};
-		imageAtlasBarrier.type = ImageManager::BARRIER_WRITE_WRITE;
-		imageAtlasBarrier.imageIndex = atlasImageIndex_;
-		ImageManager::BarrierInfo mipMapAtlasBarrier{};
-		mipMapAtlasBarrier.type = ImageManager::BARRIER_WRITE_READ;
-		mipMapAtlasBarrier.imageIndex = mipMapImageAtlas_.GetImageIndex();
-		
-		auto imageBarriers = imageManager->Barrier({ imageAtlasBarrier, mipMapAtlasBarrier });
-		pipelineBarrierInfo.AddImageBarriers(imageBarriers);
-				
-		Wrapper::AddPipelineBarrier(commandBuffer, pipelineBarrierInfo);
-	}
-
-	void MipMapping::AddMergingBarrier(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex, bool lastLevel)
+	void MipMapping::AddBarrier(ImageManager* imageManager, VkCommandBuffer commandBuffer, bool lastLevel)
 	{
 		Wrapper::PipelineBarrierInfo pipelineBarrierInfo{};
 		pipelineBarrierInfo.src = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 		pipelineBarrierInfo.dst = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 
-		ImageManager::BarrierInfo imageAtlasBarrier{};
-		imageAtlasBarrier.imageIndex = atlasImageIndex_;
-
-		//Writing mip map values must be finished
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		//The next level loads the written mip maps of its children and writes its own
+		//After the last level it covers the value ranges written into the node infos
+		std::vector<VkMemoryBarrier> memoryBarriers(1, { VK_STRUCTURE_TYPE_MEMORY_BARRIER });
+		memoryBarriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		memoryBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		pipelineBarrierInfo.AddMemoryBarriers(memoryBarriers);
 		if (lastLevel)
 		{
 			//After last level atlasImage is read only
+			ImageManager::BarrierInfo imageAtlasBarrier{};
+			imageAtlasBarrier.imageIndex = atlasImageIndex_;
 			imageAtlasBarrier.type = ImageManager::BARRIER_WRITE_READ;
+			imageBarriers = imageManager->Barrier({ imageAtlasBarrier });
+			pipelineBarrierInfo.AddImageBarriers(imageBarriers);
 		}
-		else
-		{
-			imageAtlasBarrier.type = ImageManager::BARRIER_WRITE_WRITE;
-		}
-		ImageManager::BarrierInfo mipMapAtlasBarrier{};
-		mipMapAtlasBarrier.imageIndex = mipMapImageAtlas_.GetImageIndex();
-		mipMapAtlasBarrier.type = ImageManager::BARRIER_READ_WRITE;
-
-		auto barriers = imageManager->Barrier({ imageAtlasBarrier, mipMapAtlasBarrier});
-
-		pipelineBarrierInfo.AddImageBarriers(barriers);
 		Wrapper::AddPipelineBarrier(commandBuffer, pipelineBarrierInfo);
 	}
-}
\ No newline at end of file
+}
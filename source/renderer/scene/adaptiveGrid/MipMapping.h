@@ -26,11 +26,11 @@ SOFTWARE.
 
 #include <vector>
 #include <array>
+#include <utility>
 #include <glm\glm.hpp>
 #include <vulkan\vulkan.h>
 
 #include "AdaptiveGridData.h"
-#include "ImageAtlas.h"
 #include "Node.h"
 
 namespace Renderer
@@ -40,118 +40,164 @@ namespace Renderer
 	class ShaderBindingManager;
 	class ImageManager;
 
-	//Calculate mip map 3D volume textures containing the volumetric data from lower levels
-	//The lower levels are averaged and stored on coarser resolution where each node corresponds to one texel
-	//This texture is then combined with the original data on the respective level
+	//Calculate the mip mapped data of each parent node containing the volumetric data from lower levels
+	//The child nodes are averaged, each child corresponds to one cell of the parent node
+	//The averages are combined with the original data of the parent and stored in its mip map image
+	//Each child is reduced once by a work group, the merge dispatch uses one work group per z slice of a parent node
 	//The mipmaps have to be created starting on the lowest level to use these during calculation on higher levels
+	//Only parents whose subtree changed since the last frame are dispatched, the others keep their mip map image
+	//The reduction also stores the value range of each child image in a persistent buffer indexed by the atlas image,
+	//after the last level the ranges of all children are copied into the node infos for skipping during raymarching
 	class MipMapping
 	{
 	public:
-		MipMapping();
 		//Resources:
-		//	- 3D storage image used as an image atlas for the averaged mipmaps
-		//	- Constant buffer for image atlas properties
 		//	- Storage buffer for each child node for averaging
-		//	- Storage buffer for each parent node for merging
-		void RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount, int atlasImageIndex);
+		//	- Storage buffer for each parent node with the range of its children
+		//	- Storage buffer with the indices of the parent nodes which are mip mapped in the current frame
+		//	- Storage buffer with the value range of each atlas image, not buffered because it is kept over frames
+		//	- Storage buffer with the indices of the children of the mip mapped parents
+		//	- Storage buffer with the average of each child, only used during the dispatch
+		void RequestResources(BufferManager* bufferManager, int frameCount, int atlasImageIndex, int nodeInfoBufferIndex);
 		//Bindings:
-		//Averaging:
-		//	- In: Image atlas with original data
+		//	- In\Out: Image atlas with original data, the mipmaps are written into it
 		//	- In: Storage buffer with per child node data
-		//	- In: Constant buffer with image atlas properties
-		//	- Out: Mip map image atlas as storage image
-		//	- In: Push constant with start offset for the current level into the child node data
-		//Merging:
-		//	- In\Out: Image atlas
-		//	- In: mipmap image atlas
-		//	- In: Constant buffer with image atlas properties
-		//	- In: Storage buffer with parent node data
-		//	- In: Push constant with start offset for the current level into parent node data
-		int GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount, int pass);
+		//	- In: Storage buffer with per parent node data
+		//	- Out: Node infos of all levels, the value ranges of the child nodes are written
+		//	- In: Storage buffer with the mip mapped parent nodes
+		//	- In\Out: Storage buffer with the value ranges of the atlas images
+		//	- In: Storage buffer with the indices of the averaged children
+		//	- In\Out: Storage buffer with the child averages
+		//	- In: Push constant with start offset and count into the mip mapped parents and the pass type
+		int GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount);
 
 		//Add each parent node that has children to the mipmapping
-		//Should be called after all grid levels were updated
+		//Should be called after all grid levels were updated, starting at the top most level
+		//The node data of a level is only rebuilt if the version of its parent or child level changed
+		//or one of the levels above was rebuilt
 		void UpdateMipMapNodes(const GridLevel* parentLevel, const GridLevel* childLevel);
 		//Should be called after UpdateMipMapNodes was called for all parent levels
-		//Fill storage buffers with data
+		//contentStamps contains a hash of the data the producers write into each node image, indexed by level and node
+		//The state of each node combines its position, image slots, stamp and the states of its children
+		//Parents are mip mapped if their state differs from the one stored for their image in the last frame,
+		//changes of a node therefore mark all its ancestors, forceAll marks every parent
+		void UpdateDirtyNodes(const std::vector<GridLevel>& gridLevels, const std::vector<std::vector<uint64_t>>& contentStamps,
+			bool forceAll, int atlasSideLength);
+		//Fill storage buffers with data, each buffered copy is only written after the node data changed
+		//The mip mapped parents are written every frame
 		void UpdateGpuResources(BufferManager* bufferManager, int frameIndex);
+		//The storage buffers and the image atlas lost their content because the memory pool was recreated
+		void InvalidateGpuResources();
+		//The mip maps of the last frames were not written, e.g. because no scene was loaded
+		void InvalidateContent() { imageStates_.clear(); }
 		//Returns true if the storage buffers need to be resized and stores the new size and ids in resourceResizes
-		bool ResizeGpuResources(ImageManager* imageManager, std::vector<ResourceResize>& resourceResizes);
-		//Update the properties of the atlas containing the original data
-		void UpdateAtlasProperties(int atlasSideLength, int atlasResolution);
+		bool ResizeGpuResources(std::vector<ResourceResize>& resourceResizes);
 
-		//TODO
-		void Dispatch(ImageManager* imageManager, BufferManager* bufferManager, 
-			VkCommandBuffer commandBuffer, int frameIndex, int level, int pass);
-
-
-
-		int GetImageAtlasIndex() const { return mipMapImageAtlas_.GetImageIndex(); }
+		//Averages and merges the changed parents of the level followed by a barrier for the image atlas
+		//After the last level the value ranges are copied into the node infos
+		void Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex, int level);
 	private:
-		enum Passes
+		enum StorageBuffers
+		{
+			BUFFER_CHILD_NODES,
+			BUFFER_PARENT_NODES,
+			BUFFER_DIRTY_PARENTS,
+			BUFFER_VALUE_RANGES,
+			BUFFER_DIRTY_CHILDREN,
+			BUFFER_CHILD_AVERAGES,
+			BUFFER_MAX
+		};
+		//Has to match the shader
+		enum Pass
 		{
-			MIPMAP_AVERAGING,		//Go through the child levels, average these and store them in an additional texture
-			MIPMAP_MERGING,			//Merge with original data on this level by sampling both textures and adding the values
-			MIPMAP_MAX
+			PASS_MERGE,
+			PASS_VALUE_RANGES,
+			PASS_REDUCE_CHILDREN
 		};
 
 		struct ChildNodeData
 		{
 			uint32_t imageOffset;
 			uint32_t parentTexel;		//Texel coordinates packed into this 32bit value
+			uint32_t nodeImageOffset;	//Original image of the child, differs from imageOffset for mip mapped children
+			int nodeIndex;					//Index into the node infos of all levels
+			int valueRangeIndex;		//Atlas index of the original image, indexes the value range buffer
+			glm::ivec3 padding;
 		};
 		struct ParentNodeData
 		{
 			uint32_t imageAtlasOffset;
 			uint32_t imageAtlas_mipmapOffset;
-			uint32_t mipmapOffset;
+			uint32_t childStart;		//Index of the first child in the perChildData array
+			uint32_t childCount;
 		};
 		struct LevelData_New
 		{
-			uint32_t averagingStart;	//Start index into the perChildData array during averaging
+			uint32_t averagingStart;	//Start index into the perChildData or perParentData array
 		};
-		struct CBData
+		struct ValueRange
 		{
-			float atlasSideLength_Reciprocal;
-			float texelSize;
-			float texelSize_Half;
-			float texelSizeMipmap;
+			uint32_t extinctionRange;
+			uint32_t scatteringRange;
+		};
+		struct PushConstants
+		{
+			int startOffset;
+			int count;
+			int pass;
 		};
 
 		//Store the image offset for the child and pack the parent texel
-		ChildNodeData GetChildNodeData(const Renderer::NodeData& data, int childNodeIndex, bool leafLevel);
-		//After mipmaps for each level have been created update the texel positions based on the size of the mipmap atlas
-		void UpdateImageOffsets(ImageManager* imageManager);
-		int CalcStorageBufferSize(Passes pass);
-
-		//Add buffer barrier for the averaged value buffer 
-		//and for writing to the image atlas
-		void AddBarriers(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex);
-		void AddMergingBarrier(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex, bool lastLevel);
-
-		//Data passed to the shader to average each child and store it
+		ChildNodeData GetChildNodeData(const Renderer::NodeData& data, int childNodeIndex, int nodeOffset, bool leafLevel);
+		//Collects the parents of all levels for which isDirty(level, indexNode) returns true
+		template<class IsDirty>
+		void UpdateDirtyParents(IsDirty isDirty);
+		//Removes the node data of the level and all levels below
+		void RemoveLevels(int level);
+		int CalcStorageBufferSize(StorageBuffers buffer);
+
+		//Later levels read the written mip maps, after the last level the image atlas is read only
+		//and the value ranges in the node infos are visible to raymarching
+		void AddBarrier(ImageManager* imageManager, VkCommandBuffer commandBuffer, bool lastLevel);
+
+		//Data passed to the shader to average each child
 		std::vector<ChildNodeData> perChildData_;
-		//Data for each child with the total mipmapIndex
-		std::vector<int> mipmapIndices_;
 		std::vector<LevelData_New> perLevelDataChild_;
-		std::vector<int> perLevelChildCount_;
-		int mipmapCount_ = 0;
-		//Data for each parent node for merging of the image atlas and the mipmap atlas
+		//Data for each parent node for merging of the image atlas and the averaged children
 		std::vector<ParentNodeData> perParentData_;
 		std::vector<LevelData_New> perLevelDataParent_;
 		std::vector<int> perLevelParentCount_;
+		//Node index inside its level for each entry of perParentData_
+		std::vector<int> perParentNodeIndex_;
+
+		//Indices into perParentData_ of the changed parents, start and count per level
+		std::vector<int> dirtyParents_;
+		std::vector<int> perLevelDirtyStart_;
+		std::vector<int> perLevelDirtyCount_;
+		//Indices into perChildData_ of the children of the changed parents, start and count per level
+		std::vector<int> dirtyChildren_;
+		std::vector<int> perLevelDirtyChildStart_;
+		std::vector<int> perLevelDirtyChildCount_;
+		//State of the node using each atlas image as original image in the last frame
+		std::vector<uint64_t> imageStates_;
+		//Atlas image count, size of the value range buffer
+		int valueRangeCount_ = 0;
+
+		//Versions of the parent and child level the node data of each level was built from
+		std::vector<std::pair<int, int>> levelVersions_;
+		//Level of the next UpdateMipMapNodes call during the current frame
+		int currentLevel_ = 0;
+		//Incremented if the node data changed, each buffered storage buffer stores its uploaded version
+		int dataVersion_ = 0;
+		bool dataChanged_ = false;
+		std::vector<int> uploadedVersions_;
 
-		//Store the averaged values at the centers of nodes at each texel
-		ImageAtlas mipMapImageAtlas_;
-		CBData cbData_;
-
-		int cbIndex_ = -1;
 		int perLevelPushConstantIndex_ = -1;
 		int atlasImageIndex_ = -1;
-		int perLevelMergingPushConstantIndex_ = -1;
-		std::array<ResourceResize, MIPMAP_MAX> storageBuffers_;
+		int nodeInfoBufferIndex_ = -1;
+		std::array<ResourceResize, BUFFER_MAX> storageBuffers_;
 
 		//TODO: Should be removed, currently only used to get pipeline layout for push constants
 		ShaderBindingManager* bindingManager_ = nullptr;
 	};
-}
\ No newline at end of file
+}
@@ -24,6 +24,9 @@ SOFTWARE.
 
 #include "Node.h"
 
+#include <limits>
+#include <glm\gtc\packing.hpp>
+
 #include "AdaptiveGridConstants.h"
 #include "..\..\..\utility\Math.h"
 
@@ -90,6 +93,9 @@ namespace Renderer
 		info.mipMapImageIndex = -1;
 		imageInfos_.push_back(info);
 		nodeInfos_.push_back({});
+		//Infinite maximum values prevent skipping until the range is known
+		const float unknown = std::numeric_limits<float>::infinity();
+		SetValueRange(index, 0.0f, unknown, unknown);
 
 		gridPos_.push_back(nodePos);
 		childCount_.push_back({ 0 });
@@ -128,6 +134,12 @@ namespace Renderer
 		nodeInfos_[nodeIndex].childOffset = offset;
 	}
 
+	void NodeData::SetValueRange(int nodeIndex, float minExtinction, float maxExtinction, float maxScattering)
+	{
+		nodeInfos_[nodeIndex].extinctionRange = glm::packHalf2x16({ minExtinction, maxExtinction });
+		nodeInfos_[nodeIndex].scatteringRange = glm::packHalf2x16({ maxScattering, 0.0f });
+	}
+
 	uint32_t NodeData::PackTextureOffset(const glm::ivec3& textureOffset)
 	{
 		const glm::uvec3 offset = static_cast<glm::uvec3>(textureOffset);
@@ -34,6 +34,8 @@ namespace Renderer
     uint32_t textureOffset;				//x,y,z 10 bit leafNodeBit, mipmapBit
 		uint32_t textureOffsetMipMap;
 		int childOffset;
+		uint32_t extinctionRange;			//min, max extinction of the node image as half floats
+		uint32_t scatteringRange;			//max scattering as half float, upper 16 bit unused
   };
 
 	struct ImageInfo
@@ -56,6 +58,8 @@ namespace Renderer
 		void UpdateImageOffsets(const int parentImageOffset);
 		void UpdateMipMap(int imageIndex, int indexNode);
 		void SetChildOffset(int offset, int nodeIndex);
+		//Conservative bounds of the values inside the node image, nodes are added with unknown bounds
+		void SetValueRange(int nodeIndex, float minExtinction, float maxExtinction, float maxScattering);
 
 		std::vector<ImageInfo> imageInfos_;
 
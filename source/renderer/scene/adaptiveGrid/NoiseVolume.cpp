@@ -0,0 +1,222 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "NoiseVolume.h"
+
+#include <fstream>
+#include <glm\gtc\packing.hpp>
+
+#include "..\..\resources\BufferManager.h"
+#include "..\..\resources\ImageManager.h"
+#include "..\..\wrapper\Barrier.h"
+#include "..\..\..\utility\Noise.h"
+
+namespace
+{
+	constexpr int resolution = 128;
+	//Size of the volume in noise space, the shader noise has features of roughly one unit
+	//A multiple of 3 so that the simplex lattice repeats
+	constexpr int period = 18;
+
+	const char* cacheFile = "..\\data\\noise\\SimplexVolume.bin";
+	constexpr uint32_t cacheMagic = 0x4C4F564E;		//NVOL
+	constexpr uint32_t cacheVersion = 2;
+	//Half floats of noise in [-1,1] have an error below 1e-3
+	constexpr float cacheTolerance = 2e-3f;
+
+	struct CacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		int resolution;
+		int period;
+	};
+
+	size_t TexelCount()
+	{
+		return static_cast<size_t>(resolution) * resolution * resolution;
+	}
+}
+
+namespace Renderer
+{
+	void NoiseVolume::RequestResources(ImageManager* imageManager, BufferManager* bufferManager)
+	{
+		if (!LoadCache())
+		{
+			printf("Generating noise volume\n");
+			Noise::GenerateVolume(data_, resolution, period);
+			SaveCache();
+		}
+
+		ImageManager::Ref_ImageInfo imageInfo{};
+		imageInfo.arrayCount = 1;
+		imageInfo.extent = { resolution, resolution, resolution };
+		imageInfo.format = VK_FORMAT_R16_SFLOAT;
+		imageInfo.imageType = ImageManager::IMAGE_NO_POOL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_GENERAL;
+		imageInfo.layout = VK_IMAGE_LAYOUT_GENERAL;
+		imageInfo.pool = ImageManager::MEMORY_POOL_INDIVIDUAL;
+		imageInfo.sampler = ImageManager::SAMPLER_REPEAT;
+		imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		imageInfo.viewPerLayer = false;
+		imageIndex_ = imageManager->Ref_RequestImage(imageInfo);
+
+		BufferManager::BufferInfo bufferInfo;
+		bufferInfo.typeBits = BufferManager::BUFFER_GRID_BIT;
+		bufferInfo.pool = BufferManager::MEMORY_GRID;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.bufferingCount = 1;
+		bufferInfo.size = TexelCount() * sizeof(uint16_t);
+		stagingBuffer_ = { bufferInfo.size, bufferManager->Ref_RequestBuffer(bufferInfo) };
+	}
+
+	void NoiseVolume::ResizeGpuResources(std::vector<ResourceResize>& resourceResizes)
+	{
+		resourceResizes.push_back(stagingBuffer_);
+	}
+
+	void NoiseVolume::UpdateGpuResources(BufferManager* bufferManager)
+	{
+		if (!uploaded_ && !staged_)
+		{
+			auto dataPtr = bufferManager->Ref_Map(stagingBuffer_.index, 0, BufferManager::BUFFER_GRID_BIT);
+			memcpy(dataPtr, data_.data(), data_.size() * sizeof(uint16_t));
+			bufferManager->Ref_Unmap(stagingBuffer_.index, 0, BufferManager::BUFFER_GRID_BIT);
+			staged_ = true;
+		}
+	}
+
+	void NoiseVolume::Upload(ImageManager* imageManager, BufferManager* bufferManager, VkCommandBuffer commandBuffer)
+	{
+		if (uploaded_ || !staged_)
+		{
+			return;
+		}
+
+		std::vector<VkImageMemoryBarrier> imageBarriers(1, { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER });
+		auto& barrier = imageBarriers[0];
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = imageManager->Ref_GetImage(imageIndex_);
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		{
+			Wrapper::PipelineBarrierInfo pipelineBarrierInfo{};
+			pipelineBarrierInfo.src = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			pipelineBarrierInfo.dst = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			pipelineBarrierInfo.AddImageBarriers(imageBarriers);
+			Wrapper::AddPipelineBarrier(commandBuffer, pipelineBarrierInfo);
+		}
+
+		VkBufferImageCopy region = {};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { resolution, resolution, resolution };
+		vkCmdCopyBufferToImage(commandBuffer, 
+			bufferManager->Ref_GetBuffer(stagingBuffer_.index, BufferManager::BUFFER_GRID_BIT, 0),
+			barrier.image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		{
+			Wrapper::PipelineBarrierInfo pipelineBarrierInfo{};
+			pipelineBarrierInfo.src = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			pipelineBarrierInfo.dst = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			pipelineBarrierInfo.AddImageBarriers(imageBarriers);
+			Wrapper::AddPipelineBarrier(commandBuffer, pipelineBarrierInfo);
+		}
+
+		//The staging buffer stays alive, the copy of the CPU values is not needed anymore
+		uploaded_ = true;
+		data_.clear();
+		data_.shrink_to_fit();
+	}
+
+	float NoiseVolume::GetTextureScale() const
+	{
+		return 1.0f / static_cast<float>(period);
+	}
+
+	bool NoiseVolume::LoadCache()
+	{
+		std::ifstream file(cacheFile, std::ios::in | std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+
+		CacheHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader));
+		if (!file || header.magic != cacheMagic || header.version != cacheVersion ||
+			header.resolution != resolution || header.period != period)
+		{
+			printf("Noise volume cache is outdated\n");
+			return false;
+		}
+
+		data_.resize(TexelCount());
+		file.read(reinterpret_cast<char*>(data_.data()), data_.size() * sizeof(uint16_t));
+		if (!file)
+		{
+			printf("Noise volume cache is incomplete\n");
+			return false;
+		}
+
+		//Compare a few texels against the generator to detect a cache of a different noise function
+		const float texelSize = static_cast<float>(period) / static_cast<float>(resolution);
+		for (size_t i = 0; i < data_.size(); i += data_.size() / 7 + 1)
+		{
+			const int x = static_cast<int>(i % resolution);
+			const int y = static_cast<int>((i / resolution) % resolution);
+			const int z = static_cast<int>(i / (resolution * resolution));
+			const glm::vec3 position = (glm::vec3(x, y, z) + 0.5f) * texelSize;
+			const float expected = Noise::TileableSimplex(position, period);
+			if (glm::abs(glm::unpackHalf1x16(data_[i]) - expected) > cacheTolerance)
+			{
+				printf("Noise volume cache does not match the generator\n");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void NoiseVolume::SaveCache() const
+	{
+		std::ofstream file(cacheFile, std::ios::out | std::ios::binary);
+		if (!file)
+		{
+			printf("Unable to write noise volume cache %s\n", cacheFile);
+			return;
+		}
+
+		const CacheHeader header = { cacheMagic, cacheVersion, resolution, period };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+		file.write(reinterpret_cast<const char*>(data_.data()), data_.size() * sizeof(uint16_t));
+	}
+}
@@ -0,0 +1,68 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <vulkan\vulkan.h>
+
+#include "AdaptiveGridData.h"
+
+namespace Renderer
+{
+	class BufferManager;
+	class ImageManager;
+
+	//Tileable 3D simplex noise which is sampled instead of evaluating the noise per texel
+	//The volume is generated once on the CPU and cached on disk
+	class NoiseVolume
+	{
+	public:
+		//Loads the noise from the cache file or generates and stores it
+		//Resources:
+		//	- R16_SFLOAT 3D image with a repeating sampler
+		//	- Staging buffer for the upload of the noise values
+		void RequestResources(ImageManager* imageManager, BufferManager* bufferManager);
+		void ResizeGpuResources(std::vector<ResourceResize>& resourceResizes);
+		//Copies the noise values into the staging buffer until the image was uploaded
+		void UpdateGpuResources(BufferManager* bufferManager);
+		//The staging buffer lost its content because the memory pool was recreated
+		void InvalidateGpuResources() { staged_ = false; }
+		//Records the copy from the staging buffer into the image once
+		void Upload(ImageManager* imageManager, BufferManager* bufferManager, VkCommandBuffer commandBuffer);
+
+		int GetImageIndex() const { return imageIndex_; }
+		//Scale from noise space to texture coordinates
+		float GetTextureScale() const;
+	private:
+		bool LoadCache();
+		void SaveCache() const;
+
+		std::vector<uint16_t> data_;
+		ResourceResize stagingBuffer_ = { 0, -1 };
+		int imageIndex_ = -1;
+		bool staged_ = false;
+		bool uploaded_ = false;
+	};
+}
@@ -0,0 +1,202 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "TileClassification.h"
+
+#include "GridLevel.h"
+#include "..\..\resources\BufferManager.h"
+#include "..\..\resources\ImageManager.h"
+#include "..\..\wrapper\Barrier.h"
+
+#include <algorithm>
+
+namespace Renderer
+{
+	namespace
+	{
+		constexpr int dispatchArgumentCount = 4;
+		constexpr uint32_t tilePositionBits = 15;
+		constexpr uint32_t tileTypeShift = 30;
+	}
+
+	void TileClassification::RequestResources(BufferManager* bufferManager, int frameCount)
+	{
+		BufferManager::BufferInfo bufferInfo;
+		bufferInfo.pool = BufferManager::MEMORY_GRID;
+		bufferInfo.size = tileBuffer_.size;
+		bufferInfo.typeBits = BufferManager::BUFFER_GRID_BIT;
+		bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+		bufferInfo.bufferingCount = frameCount;
+		tileBuffer_.index = bufferManager->Ref_RequestBuffer(bufferInfo);
+	}
+
+	void TileClassification::Update(const glm::mat4& viewProj, const glm::vec2& screenSize, const GridLevel* gridLevel,
+		const std::vector<AxisAlignedBoundingBox>& mediaBounds, const glm::vec3& gridMinPosition, 
+		bool globalMedium, bool enabled)
+	{
+		screenSize_ = screenSize;
+		tileCount_ = (glm::ivec2(screenSize) + tileSize - 1) / tileSize;
+		const TileType defaultType = !enabled ? TILE_FULL : (globalMedium ? TILE_GLOBAL : TILE_EMPTY);
+		tileTypes_.assign(tileCount_.x * tileCount_.y, defaultType);
+		//Without classification no node depth is known, the traversal is never skipped
+		tileNodeDepths_.assign(tileTypes_.size(), enabled ? 1.0f : 0.0f);
+
+		if (enabled)
+		{
+			//Ground fog and particle nodes are all children of nodes in this level
+			const float cellSize = gridLevel->GetGridCellSize();
+			for (const auto& gridPos : gridLevel->GetNodeData().gridPos_)
+			{
+				const glm::vec3 min = gridMinPosition + gridPos * cellSize;
+				MarkTiles(viewProj, min, min + glm::vec3(cellSize));
+			}
+			//Media stored in the coarsest level without nodes
+			for (const auto& bounds : mediaBounds)
+			{
+				MarkTiles(viewProj, gridMinPosition + bounds.min, gridMinPosition + bounds.max);
+			}
+		}
+
+		std::fill(std::begin(tileCounts_), std::end(tileCounts_), 0);
+		tileBufferData_.assign(dispatchArgumentCount, 1);
+		for (int y = 0; y < tileCount_.y; ++y)
+		{
+			for (int x = 0; x < tileCount_.x; ++x)
+			{
+				const int tileIndex = y * tileCount_.x + x;
+				const TileType type = tileTypes_[tileIndex];
+				tileCounts_[type]++;
+				if (type != TILE_EMPTY)
+				{
+					tileBufferData_.push_back(PackTile(x, y, type));
+					uint32_t nodeDepth;
+					memcpy(&nodeDepth, &tileNodeDepths_[tileIndex], sizeof(uint32_t));
+					tileBufferData_.push_back(nodeDepth);
+				}
+			}
+		}
+		tileBufferData_[0] = static_cast<uint32_t>((tileBufferData_.size() - dispatchArgumentCount) / 2);
+	}
+
+	bool TileClassification::ResizeGpuResources(std::vector<ResourceResize>& resourceResizes)
+	{
+		bool resize = false;
+		const VkDeviceSize newSize = tileBufferData_.size() * sizeof(uint32_t);
+		if (tileBuffer_.size < newSize)
+		{
+			resize = true;
+			tileBuffer_.size = newSize;
+		}
+		resourceResizes.push_back(tileBuffer_);
+		return resize;
+	}
+
+	void TileClassification::UpdateGpuResources(BufferManager* bufferManager, int frameIndex)
+	{
+		auto dataPtr = bufferManager->Ref_Map(tileBuffer_.index, frameIndex, BufferManager::BUFFER_GRID_BIT);
+		memcpy(dataPtr, tileBufferData_.data(), tileBufferData_.size() * sizeof(uint32_t));
+		bufferManager->Ref_Unmap(tileBuffer_.index, frameIndex, BufferManager::BUFFER_GRID_BIT);
+	}
+
+	void TileClassification::ClearEmptyTiles(ImageManager* imageManager, VkCommandBuffer commandBuffer, int raymarchingImage)
+	{
+		if (tileCounts_[TILE_EMPTY] == 0)
+		{
+			return;
+		}
+
+		//No in scattering and full transmittance
+		const VkClearColorValue clearValue = { 0.0f, 0.0f, 0.0f, 1.0f };
+		VkImageSubresourceRange range = {};
+		range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		range.levelCount = 1;
+		range.layerCount = 1;
+		vkCmdClearColorImage(commandBuffer, imageManager->GetImage(raymarchingImage), VK_IMAGE_LAYOUT_GENERAL,
+			&clearValue, 1, &range);
+
+		std::vector<VkMemoryBarrier> barriers(1, { VK_STRUCTURE_TYPE_MEMORY_BARRIER });
+		barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barriers[0].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		Wrapper::PipelineBarrierInfo pipelineBarrierInfo{};
+		pipelineBarrierInfo.src = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		pipelineBarrierInfo.dst = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		pipelineBarrierInfo.AddMemoryBarriers(barriers);
+		Wrapper::AddPipelineBarrier(commandBuffer, pipelineBarrierInfo);
+	}
+
+	void TileClassification::Dispatch(BufferManager* bufferManager, VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		const auto buffer = bufferManager->Ref_GetBuffer(tileBuffer_.index, BufferManager::BUFFER_GRID_BIT, frameIndex);
+		vkCmdDispatchIndirect(commandBuffer, buffer, 0);
+	}
+
+	void TileClassification::MarkTiles(const glm::mat4& viewProj, const glm::vec3& min, const glm::vec3& max)
+	{
+		glm::vec2 screenMin = glm::vec2(1.0f);
+		glm::vec2 screenMax = glm::vec2(0.0f);
+		float minDepth = 1.0f;
+		for (int i = 0; i < 8; ++i)
+		{
+			const glm::vec3 corner = { i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z };
+			const glm::vec4 clipPos = viewProj * glm::vec4(corner, 1.0f);
+			//Boxes intersecting the camera plane can cover the whole screen
+			if (clipPos.w <= 0.0f)
+			{
+				screenMin = glm::vec2(0.0f);
+				screenMax = glm::vec2(1.0f);
+				minDepth = 0.0f;
+				break;
+			}
+			//Same mapping from texture coordinates to the viewport as used for the ray creation
+			const glm::vec2 texCoord = glm::vec2(clipPos) / clipPos.w * 0.5f + 0.5f;
+			screenMin = glm::min(screenMin, texCoord);
+			screenMax = glm::max(screenMax, texCoord);
+			minDepth = std::min(minDepth, clipPos.z / clipPos.w);
+		}
+
+		if (screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x > 1.0f || screenMin.y > 1.0f)
+		{
+			return;
+		}
+
+		const glm::vec2 tileScale = screenSize_ / static_cast<float>(tileSize);
+		const glm::ivec2 tileMin = glm::clamp(glm::ivec2(glm::floor(screenMin * tileScale)), glm::ivec2(0), tileCount_ - 1);
+		const glm::ivec2 tileMax = glm::clamp(glm::ivec2(glm::floor(screenMax * tileScale)), glm::ivec2(0), tileCount_ - 1);
+		for (int y = tileMin.y; y <= tileMax.y; ++y)
+		{
+			for (int x = tileMin.x; x <= tileMax.x; ++x)
+			{
+				const int tileIndex = y * tileCount_.x + x;
+				tileTypes_[tileIndex] = TILE_FULL;
+				tileNodeDepths_[tileIndex] = std::min(tileNodeDepths_[tileIndex], minDepth);
+			}
+		}
+	}
+
+	uint32_t TileClassification::PackTile(int x, int y, TileType type)
+	{
+		return static_cast<uint32_t>(x) | (static_cast<uint32_t>(y) << tilePositionBits) | 
+			(static_cast<uint32_t>(type) << tileTypeShift);
+	}
+}
@@ -0,0 +1,95 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+#include <vulkan\vulkan.h>
+
+#include "AdaptiveGridData.h"
+#include "..\..\..\scene\components\AABoundingBox.h"
+
+namespace Renderer
+{
+	class GridLevel;
+	class BufferManager;
+	class ImageManager;
+
+	//Classifies the raymarching image in screen tiles of the raymarching work group size
+	//Only tiles which are covered by the projected bounding box of a grid node run the full
+	//grid traversal, tiles which only contain the global medium skip the traversal and
+	//empty tiles are not dispatched at all
+	//For full tiles the depth of the closest node is stored, the raymarching skips the traversal
+	//if the geometry of the whole tile is in front of it
+	class TileClassification
+	{
+	public:
+		enum TileType
+		{
+			TILE_EMPTY,
+			TILE_GLOBAL,
+			TILE_FULL
+		};
+
+		static constexpr int tileSize = 16;
+
+		//Resources:
+		//	- Storage buffer with indirect dispatch arguments followed by the tile list
+		void RequestResources(BufferManager* bufferManager, int frameCount);
+
+		//Marks all tiles which are covered by nodes of the grid level or by the media bounds as full,
+		//if disabled all tiles are full. The media bounds are relative to the grid min position
+		void Update(const glm::mat4& viewProj, const glm::vec2& screenSize, const GridLevel* gridLevel,
+			const std::vector<AxisAlignedBoundingBox>& mediaBounds, const glm::vec3& gridMinPosition, 
+			bool globalMedium, bool enabled);
+		bool ResizeGpuResources(std::vector<ResourceResize>& resourceResizes);
+		void UpdateGpuResources(BufferManager* bufferManager, int frameIndex);
+
+		//Clears the raymarching image if empty tiles exist, has to be called before Dispatch
+		void ClearEmptyTiles(ImageManager* imageManager, VkCommandBuffer commandBuffer, int raymarchingImage);
+		//Indirect dispatch of one work group per non empty tile
+		void Dispatch(BufferManager* bufferManager, VkCommandBuffer commandBuffer, int frameIndex);
+
+		int GetBufferIndex() const { return tileBuffer_.index; }
+		int GetTileCount(TileType type) const { return tileCounts_[type]; }
+	private:
+		//Marks the tiles covered by the screen space projection of the bounding box and keeps
+		//the closest viewport depth of it
+		void MarkTiles(const glm::mat4& viewProj, const glm::vec3& min, const glm::vec3& max);
+
+		//Tile position x, y with 15 bit each followed by the tile type
+		static uint32_t PackTile(int x, int y, TileType type);
+
+		glm::vec2 screenSize_ = glm::vec2(0.0f);
+		glm::ivec2 tileCount_ = glm::ivec2(0);
+		std::vector<TileType> tileTypes_;
+		std::vector<float> tileNodeDepths_;
+		//Indirect dispatch arguments padded to 4 values followed by the packed tiles and node depths
+		std::vector<uint32_t> tileBufferData_;
+		int tileCounts_[TILE_FULL + 1] = {};
+		
+		ResourceResize tileBuffer_ = { sizeof(uint32_t) * 4, -1 };
+	};
+}
@@ -24,6 +24,13 @@ SOFTWARE.
 
 #include "DebugData.h"
 
+#include <glm\gtc\packing.hpp>
+#include <cstring>
+#include <utility>
+
+#include "..\AdaptiveGridConstants.h"
+#include "..\..\..\..\fileIO\GridSnapshot.h"
+
 namespace DebugData
 {
 	Renderer::RaymarchingData raymarchData_;
@@ -33,14 +40,138 @@ namespace DebugData
 	BitCountsContainer bitCounts_;
 	ChildIndexContainer childIndices_;
 
-	int textureAtlas_;
+	//Identifiers of the images sampled by the shader code
+	int textureAtlas_ = 0;
+	int noiseTextureArray_ = 1;
+	int depthImage_ = 2;
 
 	glm::vec4 raymarchingResults_;
 
+	namespace
+	{
+		FileIO::MappedGridSnapshot snapshot_;
+		//Packed R16G16B16A16_SFLOAT texels inside the mapping
+		const uint64_t* atlasTexels_ = nullptr;
+		int atlasResolution_ = 0;
+
+		glm::ivec2 depthOrigin_ = glm::ivec2(0);
+		glm::ivec2 depthSize_ = glm::ivec2(0);
+		std::vector<float> depthPixels_;
+
+		template<typename Container, typename T>
+		void CopySection(FileIO::SnapshotSection section, Container& container)
+		{
+			size_t count = 0;
+			const T* elements = snapshot_.GetElements<T>(section, count);
+			container.assign(elements, elements + count);
+		}
+
+		glm::vec4 AtlasTexel(const glm::ivec3& texel)
+		{
+			const glm::ivec3 clamped = glm::clamp(texel, glm::ivec3(0), glm::ivec3(atlasResolution_ - 1));
+			const size_t index = (static_cast<size_t>(clamped.z) * atlasResolution_ + clamped.y) * atlasResolution_ + clamped.x;
+			return glm::unpackHalf4x16(atlasTexels_[index]);
+		}
+	}
+
+	bool MatchesGridLayout(const FileIO::MappedGridSnapshot& snapshot, uint32_t levelCount, const std::string& path)
+	{
+		const auto& header = snapshot.GetHeader();
+		const uint64_t atlasTexelCount = static_cast<uint64_t>(header.atlasResolution) * header.atlasResolution * header.atlasResolution;
+		const uint64_t nodeInfoSize = snapshot.GetSectionSize(FileIO::SNAPSHOT_NODE_INFOS);
+		const uint64_t childSize = snapshot.GetSectionSize(FileIO::SNAPSHOT_CHILDS);
+		bool valid = header.levelCount == levelCount &&
+			snapshot.GetSectionSize(FileIO::SNAPSHOT_RAYMARCHING) == sizeof(Renderer::RaymarchingData) &&
+			snapshot.GetSectionSize(FileIO::SNAPSHOT_LEVELS) == levelCount * sizeof(Renderer::LevelData) &&
+			nodeInfoSize % sizeof(NodeInfo) == 0 &&
+			snapshot.GetSectionSize(FileIO::SNAPSHOT_ACTIVE_BITS) % sizeof(uint32_t) == 0 &&
+			snapshot.GetSectionSize(FileIO::SNAPSHOT_BIT_COUNTS) % sizeof(int) == 0 &&
+			childSize % sizeof(int) == 0 &&
+			header.atlasSideLength > 0 &&
+			header.atlasResolution >= header.atlasSideLength * GridConstants::imageResolution &&
+			snapshot.GetSectionSize(FileIO::SNAPSHOT_ATLAS) >= atlasTexelCount * sizeof(uint64_t);
+
+		//The byte offsets of each level have to point into the node info and child sections
+		size_t count = 0;
+		const auto levels = valid ? snapshot.GetElements<Renderer::LevelData>(FileIO::SNAPSHOT_LEVELS, count) : nullptr;
+		for (size_t i = 0; valid && i < count; ++i)
+		{
+			const auto& level = levels[i];
+			valid = level.nodeArrayOffset >= 0 && static_cast<uint64_t>(level.nodeArrayOffset) <= nodeInfoSize &&
+				level.nodeOffset * sizeof(NodeInfo) == static_cast<size_t>(level.nodeArrayOffset) &&
+				level.childArrayOffset >= 0 && static_cast<uint64_t>(level.childArrayOffset) <= childSize &&
+				level.childOffset * sizeof(int) == static_cast<size_t>(level.childArrayOffset);
+		}
+		if (!valid)
+		{
+			printf("Grid snapshot %s does not match the current grid layout\n", path.c_str());
+		}
+		return valid;
+	}
+
+	bool LoadSnapshot(const std::string& path, uint32_t levelCount)
+	{
+		snapshot_.Close();
+		atlasTexels_ = nullptr;
+		if (path.empty() || !snapshot_.Open(path))
+		{
+			return false;
+		}
+
+		const auto& header = snapshot_.GetHeader();
+		if (!MatchesGridLayout(snapshot_, levelCount, path))
+		{
+			snapshot_.Close();
+			return false;
+		}
+
+		memcpy(&raymarchData_, snapshot_.GetSection(FileIO::SNAPSHOT_RAYMARCHING), sizeof(Renderer::RaymarchingData));
+		CopySection<std::vector<Renderer::LevelData>, Renderer::LevelData>(FileIO::SNAPSHOT_LEVELS, levelData_.data);
+		CopySection<std::vector<NodeInfo>, NodeInfo>(FileIO::SNAPSHOT_NODE_INFOS, nodeInfos_.data);
+		CopySection<std::vector<uint32_t>, uint32_t>(FileIO::SNAPSHOT_ACTIVE_BITS, activeBits_.data);
+		CopySection<std::vector<int>, int>(FileIO::SNAPSHOT_BIT_COUNTS, bitCounts_.data);
+		CopySection<std::vector<int>, int>(FileIO::SNAPSHOT_CHILDS, childIndices_.indices);
+		atlasTexels_ = reinterpret_cast<const uint64_t*>(snapshot_.GetSection(FileIO::SNAPSHOT_ATLAS));
+		atlasResolution_ = static_cast<int>(header.atlasResolution);
+
+		printf("Loaded grid snapshot %s with %d nodes\n", path.c_str(), static_cast<int>(nodeInfos_.data.size()));
+		return true;
+	}
+
+	bool HasSnapshot()
+	{
+		return snapshot_.IsOpen();
+	}
+
+	void SetDepthPixels(const glm::ivec2& origin, const glm::ivec2& size, std::vector<float> depths)
+	{
+		depthOrigin_ = origin;
+		depthSize_ = size;
+		depthPixels_ = std::move(depths);
+	}
+
 	glm::vec4 texture(int imageIndex, const glm::vec3& texCoord)
 	{
-		printf("WARNING: debug texture sampling not implemented yet\n");
-		return glm::vec4(0);
+		if (imageIndex != textureAtlas_ || atlasTexels_ == nullptr)
+		{
+			printf("WARNING: debug texture sampling is only implemented for the atlas of a snapshot\n");
+			return glm::vec4(0);
+		}
+
+		//Linear filtering with clamping to the atlas border
+		const glm::vec3 position = texCoord * static_cast<float>(atlasResolution_) - 0.5f;
+		const glm::vec3 base = glm::floor(position);
+		const glm::vec3 t = position - base;
+		const glm::ivec3 start = glm::ivec3(base);
+
+		glm::vec4 value = glm::vec4(0);
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const glm::ivec3 c = glm::ivec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+			const glm::vec3 w = glm::mix(1.0f - t, t, glm::vec3(c));
+			value += w.x * w.y * w.z * AtlasTexel(start + c);
+		}
+		return value;
 	}
 
 	glm::vec4 texelFetch(int imageIndex, const glm::vec3& texelCoordinate, int lod)
@@ -49,6 +180,17 @@ namespace DebugData
 		return glm::vec4(0);
 	}
 
+	glm::vec4 texelFetch(int imageIndex, const glm::ivec2& texelCoordinate, int lod)
+	{
+		//Without read back depth the rays end at the far plane
+		if (imageIndex != depthImage_ || depthPixels_.empty())
+		{
+			return glm::vec4(1.0f);
+		}
+		const glm::ivec2 pixel = glm::clamp(texelCoordinate - depthOrigin_, glm::ivec2(0), depthSize_ - 1);
+		return glm::vec4(depthPixels_[pixel.y * depthSize_.x + pixel.x]);
+	}
+
 	glm::vec3 clamp(const glm::vec3& value, float min, float max)
 	{
 		return glm::clamp(value, glm::vec3(min), glm::vec3(max));
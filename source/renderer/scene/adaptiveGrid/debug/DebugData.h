@@ -24,8 +24,14 @@ SOFTWARE.
 
 #pragma once
 
+#include <string>
 #include "..\AdaptiveGridData.h"
 
+namespace FileIO
+{
+	class MappedGridSnapshot;
+}
+
 namespace DebugData
 {
 	//Node data
@@ -34,6 +40,8 @@ namespace DebugData
 		uint32_t imageOffset;
 		uint32_t imageOffsetMipMap;
 		int childOffset;
+		uint32_t extinctionRange;
+		uint32_t scatteringRange;
 	};
 	struct NodeInfoContainer
 	{
@@ -64,10 +72,24 @@ namespace DebugData
 	extern ChildIndexContainer childIndices_;
 
 	extern int textureAtlas_;
+	extern int noiseTextureArray_;
+	extern int depthImage_;
 
 	extern glm::vec4 raymarchingResults_;
 
+	//Checks the level count, the section sizes and the level offsets against the LevelData and NodeInfo layout
+	bool MatchesGridLayout(const FileIO::MappedGridSnapshot& snapshot, uint32_t levelCount, const std::string& path);
+	//Replaces the grid data with a snapshot file, the atlas is sampled directly from the file mapping
+	//An empty path releases the snapshot and the data of the current grid is used again
+	bool LoadSnapshot(const std::string& path, uint32_t levelCount);
+	bool HasSnapshot();
+	//Depth values of the screen pixels starting at origin, read back from the depth image before a traversal
+	void SetDepthPixels(const glm::ivec2& origin, const glm::ivec2& size, std::vector<float> depths);
+
+	//Only the image atlas of a loaded snapshot can be sampled
 	glm::vec4 texture(int imageIndex, const glm::vec3& texCoord);
 	glm::vec4 texelFetch(int imageIndex, const glm::vec3& texelCoordinate, int lod);
+	//Only the depth pixels covered by the traced raymarching texel are available, see SetDepthPixels
+	glm::vec4 texelFetch(int imageIndex, const glm::ivec2& texelCoordinate, int lod);
 	glm::vec3 clamp(const glm::vec3& value, float min, float max);
 }
\ No newline at end of file
@@ -24,6 +24,7 @@ SOFTWARE.
 
 #include "DebugTraversal.h"
 #include <glm\glm.hpp>
+#include <glm\gtc\packing.hpp>
 
 #include "..\..\..\resources\ImageManager.h"
 #include "..\..\..\resources\QueueManager.h"
@@ -42,11 +43,55 @@ namespace Renderer
 	{
 		printf("Debug traversal at %d %d\n", x, y);
 
-		Raymarching(uvec3(x, y, 0));
+		ReadDepthPixels(queueManager, bufferManager, imageManager, x, y);
+		const int stepCount = Raymarching(uvec3(x, y, 0), false);
+		printf("Raymarching steps %d\n", stepCount);
 		//GetImageData(queueManager, bufferManager, imageManager);
 		//ReleaseImageData(bufferManager);
 	}
 
+	void DebugTraversal::ReadDepthPixels(QueueManager* queueManager, BufferManager* bufferManager, ImageManager* imageManager, int x, int y)
+	{
+		//The depth image is read by the raymarching of the submitted frame
+		vkQueueWaitIdle(queueManager->GetQueue(QueueManager::QUEUE_COMPUTE));
+
+		const int imageIndex = imageIndices_[IMAGE_DEPTH].index;
+		const auto extent = imageManager->GetImageInfo(imageIndex).extent;
+		const ivec2 imageSize = ivec2(extent.width, extent.height);
+		const int division = DebugData::raymarchData_.resolutionDivision;
+		const ivec2 origin = min(ivec2(x, y) * division, imageSize - 1);
+		const ivec2 size = min(ivec2(division), imageSize - origin);
+
+		BufferManager::BufferInfo bufferInfo;
+		bufferInfo.bufferingCount = 1;
+		bufferInfo.pool = BufferManager::MEMORY_TEMP;
+		bufferInfo.size = size.x * size.y * sizeof(uint16_t);
+		bufferInfo.typeBits = BufferManager::BUFFER_TEMP_BIT;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		const int tempBufferIndex = bufferManager->RequestBuffer(bufferInfo);
+
+		VkBufferImageCopy copyRegion = {};
+		copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		copyRegion.imageSubresource.layerCount = 1;
+		copyRegion.imageOffset = { origin.x, origin.y, 0 };
+		copyRegion.imageExtent = { static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y), 1 };
+		imageManager->CopyImageToBuffer(queueManager,
+			bufferManager->GetBuffer(tempBufferIndex, BufferManager::BUFFER_TEMP_BIT),
+			{ copyRegion }, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, imageIndex, false);
+
+		//D16_UNORM depth
+		const auto depthTexels = static_cast<const uint16_t*>(bufferManager->Map(tempBufferIndex, BufferManager::BUFFER_TEMP_BIT));
+		std::vector<float> depths(size.x * size.y);
+		for (size_t i = 0; i < depths.size(); ++i)
+		{
+			depths[i] = depthTexels[i] / 65535.0f;
+		}
+		bufferManager->Unmap(tempBufferIndex, BufferManager::BUFFER_TEMP_BIT);
+		bufferManager->ReleaseTempBuffer(tempBufferIndex);
+
+		DebugData::SetDepthPixels(origin, size, std::move(depths));
+	}
+
 	void DebugTraversal::SetImageIndices(int imageAtlas, int depth, int shadowMap, int noiseTexture)
 	{
 		imageIndices_[IMAGE_ATLAS] = { imageAtlas, true };
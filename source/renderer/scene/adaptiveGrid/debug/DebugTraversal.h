@@ -60,6 +60,9 @@ namespace Renderer
 		void SetImageIndices(int imageAtlas, int depth, int shadowMap, int noiseTexture);
 
 	private:
+		//Copies the depth of the screen pixels covered by the raymarching texel into the debug data
+		void ReadDepthPixels(QueueManager* queueManager, BufferManager* bufferManager, ImageManager* imageManager, int x, int y);
+
 		enum Images
 		{
 			IMAGE_ATLAS,
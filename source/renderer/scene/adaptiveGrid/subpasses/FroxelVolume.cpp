@@ -0,0 +1,54 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "FroxelVolume.h"
+
+#include "..\..\..\resources\ImageManager.h"
+#include "..\..\..\wrapper\QueryPool.h"
+
+namespace Renderer
+{
+	void FroxelVolume::RequestResources(ImageManager* imageManager)
+	{
+		ImageManager::Ref_ImageInfo imageInfo;
+		imageInfo.extent = { width, height, depth };
+		imageInfo.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+		imageInfo.imageType = ImageManager::IMAGE_GRID;
+		imageInfo.layout = VK_IMAGE_LAYOUT_GENERAL;
+		imageInfo.pool = ImageManager::MEMORY_POOL_CONSTANT;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sampler = ImageManager::SAMPLER_LINEAR;
+		imageIndex_ = imageManager->Ref_RequestImage(imageInfo);
+	}
+
+	void FroxelVolume::Dispatch(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		auto& queryPool = Wrapper::QueryPool::GetInstance();
+		queryPool.TimestampStart(commandBuffer, Wrapper::TIMESTAMP_GRID_FROXEL, frameIndex);
+
+		vkCmdDispatch(commandBuffer, (width + 7) / 8, (height + 7) / 8, 1);
+
+		queryPool.TimestampEnd(commandBuffer, Wrapper::TIMESTAMP_GRID_FROXEL, frameIndex);
+	}
+}
@@ -0,0 +1,54 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <vulkan\vulkan.h>
+
+namespace Renderer
+{
+	class ImageManager;
+
+	//Camera aligned volume with exponentially distributed depth slices, filled by sampling the
+	//grid once per froxel. Scattering and transmittance are accumulated front to back and applied
+	//in the post process with a single lookup per pixel
+	class FroxelVolume
+	{
+	public:
+		//Matches the resolution of GridFroxels.comp
+		static constexpr uint32_t width = 160;
+		static constexpr uint32_t height = 90;
+		static constexpr uint32_t depth = 64;
+
+		//Resources:
+		//	- 3D image with accumulated in scattering and transmittance
+		void RequestResources(ImageManager* imageManager);
+		//One invocation per froxel column
+		void Dispatch(VkCommandBuffer commandBuffer, int frameIndex);
+
+		int GetImageIndex() const { return imageIndex_; }
+	private:
+		int imageIndex_ = -1;
+	};
+}
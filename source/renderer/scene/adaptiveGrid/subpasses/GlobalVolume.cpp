@@ -27,10 +27,14 @@ SOFTWARE.
 #include "..\..\..\resources\ImageManager.h"
 #include "..\..\..\passResources\ShaderBindingManager.h"
 #include "..\..\..\resources\BufferManager.h"
-#include "..\..\..\passes\GuiPass.h"
 #include "..\GroundFog.h"
+#include "..\GridLevel.h"
 #include "..\AdaptiveGridConstants.h"
 #include "..\..\..\wrapper\QueryPool.h"
+#include "..\..\..\wrapper\Barrier.h"
+#include "..\..\..\..\utility\Math.h"
+
+#include <algorithm>
 
 namespace Renderer
 {
@@ -46,6 +50,17 @@ namespace Renderer
 		cbInfo.data = &cbData_;
 		cbInfo.size = sizeof(CBData);
 		cbIndex_ = bufferManager->Ref_RequestBuffer(cbInfo);
+
+		const VkDeviceSize texelCount = GridConstants::imageResolution * GridConstants::imageResolution * 
+			GridConstants::imageResolution;
+		BufferManager::BufferInfo zeroBufferInfo;
+		zeroBufferInfo.typeBits = BufferManager::BUFFER_GRID_BIT;
+		zeroBufferInfo.pool = BufferManager::MEMORY_GRID;
+		zeroBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		zeroBufferInfo.bufferingCount = 1;
+		//R16G16B16A16_SFLOAT texels
+		zeroBufferInfo.size = texelCount * 4 * sizeof(uint16_t);
+		zeroBuffer_ = { zeroBufferInfo.size, bufferManager->Ref_RequestBuffer(zeroBufferInfo) };
 	}
 
 	int GlobalVolume::GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount)
@@ -64,54 +79,102 @@ namespace Renderer
 
 	void GlobalVolume::UpdateCB(GroundFog* groundFog)
 	{
-		const auto& globalValue = GuiPass::GetVolumeState().globalValue;
-		cbData_.globalValue = glm::vec4(0);
+		//The global medium is added during the traversal, only the covered ground fog is stored in the image
 		cbData_.groundFogValue = glm::vec4(0);
-		cbData_.groundFogTexelStart = GridConstants::imageResolution;
 		updated_ = false;
 
-		//Fill volume with global values at each texel
-		const float scattering = globalValue.scattering;
-		const float extinction = scattering + globalValue.absorption;
-		const float phaseG = globalValue.phaseG;
-		//No dispatch if volume is not filled with anything
-		if (scattering != 0.0f || extinction != 0.0f)
+		//Cells fully covered by the ground fog have no image, their values are stored in this level
+		const auto& texelStarts = groundFog->GetCoarseTexelStarts();
+		const int* texelStartsEnd = &cbData_.groundFogTexelStarts[0].x + texelStartVectors * 4;
+		std::fill(&cbData_.groundFogTexelStarts[0].x, texelStartsEnd, GridConstants::imageResolution);
+		std::copy(texelStarts.begin(), texelStarts.end(), &cbData_.groundFogTexelStarts[0].x);
+
+		const glm::vec4 fogValue = groundFog->GetCoveredValue();
+		const bool fogCovered = std::any_of(texelStarts.begin(), texelStarts.end(), 
+			[](int texelStart) { return texelStart < GridConstants::imageResolution; });
+		//No dispatch if the image stays cleared
+		if (fogCovered && (fogValue.x != 0.0f || fogValue.y != 0.0f))
 		{
-			cbData_.globalValue = glm::vec4(
-				scattering, extinction, phaseG, 0.0f);
+			cbData_.groundFogValue = fogValue;
 			updated_ = true;
 		}
+	}
 
-		/*const int texelStart = groundFog->GetCoarseGridTexel();
-		if (texelStart != GridConstants::imageResolution - 1 &&
-			(volumeState.scatteringVolumes != 0.0f || volumeState.absorptionVolumes != 0.0f))
+	uint64_t GlobalVolume::GetContentSignature() const
+	{
+		uint64_t signature = Math::hashSeed;
+		Math::HashCombine(signature, updated_);
+		if (updated_)
 		{
-			const float scatFog = volumeState.scatteringVolumes + scattering;
-			const float extFog = volumeState.scatteringVolumes + volumeState.absorptionVolumes + extinction;
-			float phaseFog = volumeState.phaseVolumes;
-			//average the phase function
-			if (scatFog != 0.0f && scattering != 0.0f)
-			{
-				phaseFog = (phaseFog + phaseG) * 0.5f;
-			}
-			//else only use the active one
-			else
+			Math::HashCombine(signature, cbData_);
+		}
+		return signature;
+	}
+
+	void GlobalVolume::UpdateClearRegions(const std::vector<GridLevel>& gridLevels, const std::vector<int>& keptImages)
+	{
+		VkBufferImageCopy region = {};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { GridConstants::imageResolution, GridConstants::imageResolution, 
+			GridConstants::imageResolution };
+
+		const auto AddRegion = [&](const glm::ivec3& imageOffset)
+		{
+			const glm::ivec3 texelOffset = imageOffset * GridConstants::imageResolution;
+			region.imageOffset = { texelOffset.x, texelOffset.y, texelOffset.z };
+			clearRegions_.push_back(region);
+		};
+
+		clearRegions_.clear();
+		for (const auto& gridLevel : gridLevels)
+		{
+			for (const auto& imageInfo : gridLevel.GetNodeData().imageInfos_)
 			{
-				phaseFog = scatFog != 0 ? phaseFog : phaseG;
+				//Mip maps are completely written by the mip mapping or kept if the children did not change
+				if (!std::binary_search(keptImages.begin(), keptImages.end(), imageInfo.imageIndex))
+				{
+					AddRegion(imageInfo.image);
+				}
 			}
+		}
+	}
 
-			cbData_.groundFogValue = glm::vec3(scatFog, extFog, phaseFog);
-			cbData_.groundFogTexelStart = texelStart;
-			updated_ = true;
+	void GlobalVolume::UpdateGpuResources(BufferManager* bufferManager)
+	{
+		if (!zeroBufferFilled_)
+		{
+			auto dataPtr = bufferManager->Ref_Map(zeroBuffer_.index, 0, BufferManager::BUFFER_GRID_BIT);
+			memset(dataPtr, 0, zeroBuffer_.size);
+			bufferManager->Ref_Unmap(zeroBuffer_.index, 0, BufferManager::BUFFER_GRID_BIT);
+			zeroBufferFilled_ = true;
 		}
-		*/
 	}
 
-	void GlobalVolume::Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex)
+	void GlobalVolume::ResizeGpuResources(std::vector<ResourceResize>& resourceResizes)
+	{
+		//The size of the zero buffer does not change but it is recreated with the memory pool
+		resourceResizes.push_back(zeroBuffer_);
+	}
+
+	void GlobalVolume::Dispatch(ImageManager* imageManager, BufferManager* bufferManager, VkCommandBuffer commandBuffer, int frameIndex)
 	{
-		//TODO replace the clear image command with individual clears
-		VkClearColorValue clearValue = { 0.0f, 0.0f, 0.0f, 0.0f};
-		imageManager->Ref_ClearImage(commandBuffer, imageAtlasIndex_, clearValue);
+		if (!clearRegions_.empty())
+		{
+			const auto zeroBuffer = bufferManager->Ref_GetBuffer(zeroBuffer_.index, BufferManager::BUFFER_GRID_BIT, 0);
+			vkCmdCopyBufferToImage(commandBuffer, zeroBuffer, imageManager->Ref_GetImage(imageAtlasIndex_), 
+				VK_IMAGE_LAYOUT_GENERAL, static_cast<uint32_t>(clearRegions_.size()), clearRegions_.data());
+
+			//The cleared images are written by the following filling passes
+			std::vector<VkMemoryBarrier> memoryBarriers(1, { VK_STRUCTURE_TYPE_MEMORY_BARRIER });
+			memoryBarriers[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memoryBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			Wrapper::PipelineBarrierInfo pipelineBarrierInfo{};
+			pipelineBarrierInfo.src = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			pipelineBarrierInfo.dst = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			pipelineBarrierInfo.AddMemoryBarriers(memoryBarriers);
+			Wrapper::AddPipelineBarrier(commandBuffer, pipelineBarrierInfo);
+		}
 
 		if(updated_)
 		{
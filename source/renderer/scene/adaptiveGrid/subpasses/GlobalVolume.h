@@ -26,6 +26,10 @@ SOFTWARE.
 
 #include <glm\glm.hpp>
 #include <vulkan\vulkan.h>
+#include <vector>
+
+#include "..\AdaptiveGridData.h"
+#include "..\AdaptiveGridConstants.h"
 
 namespace Renderer
 {
@@ -33,32 +37,52 @@ namespace Renderer
 	class ImageManager;
 	class GroundFog;
 	class BufferManager;
+	class GridLevel;
 
-	//Fills the coarsest level of the volumetric grid with uniform values
+	//Fills the cells of the coarsest level which are fully covered by the ground fog
+	//The homogeneous global medium is not stored in the grid, it is added analytically during the traversal
+	//Before filling the images of all nodes are cleared except the ones kept by other passes
 	class GlobalVolume
 	{
 	public:
 		//Request the constant buffer with the volumetric values
+		//and a zero filled buffer with the size of one image which is copied into the cleared images
 		void RequestResources(BufferManager* bufferManager, int frameCount, int atlasImageIndex);
 		//Bindings:
 		//	- In: Volumetric data constant buffer
 		//	- Out: Image Atlas as storage image
 		int GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount);
 
-		//Update the volumetric values for the whole scene
+		//Update the values of the covered ground fog cells
 		void UpdateCB(GroundFog* groundFog);
-		//TODO: remove clearing of image atlas
+		//The root image contains data and has to be sampled during the traversal
+		bool IsRootFilled() const { return updated_; }
+		//Hash of the values written into the root image
+		uint64_t GetContentSignature() const;
+		//Collects the original images of all nodes, keptImages are sorted atlas image indices which are not cleared
+		void UpdateClearRegions(const std::vector<GridLevel>& gridLevels, const std::vector<int>& keptImages);
+		//Fills the zero buffer after it was created
+		void UpdateGpuResources(BufferManager* bufferManager);
+		//The zero buffer lost its content because the memory pool was recreated
+		void InvalidateGpuResources() { zeroBufferFilled_ = false; }
+		void ResizeGpuResources(std::vector<ResourceResize>& resourceResizes);
 		//TODO: only dispatch if values have changed
-		void Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex);
+		void Dispatch(ImageManager* imageManager, BufferManager* bufferManager, VkCommandBuffer commandBuffer, int frameIndex);
 	private:
+		//Texel columns of the image packed into ivec4 for the std140 layout
+		static constexpr int texelStartVectors = (GridConstants::imageResolution * GridConstants::imageResolution + 3) / 4;
 		struct CBData
 		{
-			glm::vec4 globalValue;		//Uniform data for the whole scene
-			glm::vec3 groundFogValue; //Uniform data below the interface of the ground fog
-			int groundFogTexelStart;	
+			glm::vec4 groundFogValue; //Uniform data below the interface of the ground fog
+			glm::ivec4 groundFogTexelStarts[texelStartVectors];	//first texel row with fog of each texel column
 		};
 		CBData cbData_;
 
+		//One region per cleared image, all read from the start of the zero buffer
+		std::vector<VkBufferImageCopy> clearRegions_;
+		ResourceResize zeroBuffer_;
+		bool zeroBufferFilled_ = false;
+
 		bool updated_ = true;
 		int imageAtlasIndex_ = -1;
 		int cbIndex_ = -1;
@@ -0,0 +1,196 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "LightTransmittance.h"
+
+#include "..\GridLevel.h"
+#include "..\AdaptiveGridConstants.h"
+#include "..\..\..\resources\BufferManager.h"
+#include "..\..\..\resources\ImageManager.h"
+#include "..\..\..\passes\GuiPass.h"
+#include "..\..\..\wrapper\Barrier.h"
+#include "..\..\..\wrapper\QueryPool.h"
+#include "..\..\..\..\utility\Math.h"
+
+namespace Renderer
+{
+	LightTransmittance::LightTransmittance() :
+		lightAtlas_{GridConstants::imageResolution}
+	{}
+
+	void LightTransmittance::RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount)
+	{
+		lightAtlas_.RequestResources(imageManager, bufferManager, ImageManager::MEMORY_POOL_GRID_LIGHT,
+			frameCount, VK_FORMAT_R16_SFLOAT);
+
+		BufferManager::BufferInfo bufferInfo;
+		bufferInfo.pool = BufferManager::MEMORY_GRID;
+		bufferInfo.size = nodeBuffer_.size;
+		bufferInfo.typeBits = BufferManager::BUFFER_GRID_BIT;
+		bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		bufferInfo.bufferingCount = frameCount;
+		nodeBuffer_.index = bufferManager->Ref_RequestBuffer(bufferInfo);
+	}
+
+	void LightTransmittance::Update(const std::vector<GridLevel>& gridLevels, const glm::vec3& lightDirection, uint64_t contentSignature)
+	{
+		nodeData_.clear();
+		lightAtlas_.UpdateSize(gridLevels.back().GetImageOffset());
+
+		//Node positions are relative to the parent node, the root node is at the origin
+		std::vector<glm::vec3> parentOffsets(1, glm::vec3(0.0f));
+		std::vector<glm::vec3> levelOffsets;
+		for (size_t level = 0; level < gridLevels.size(); ++level)
+		{
+			const auto& nodeData = gridLevels[level].GetNodeData();
+			const float cellSize = gridLevels[level].GetGridCellSize();
+			
+			levelOffsets.clear();
+			for (int i = 0; i < nodeData.GetNodeCount(); ++i)
+			{
+				levelOffsets.push_back(nodeData.gridPos_[i] * cellSize + parentOffsets[nodeData.parentIndices_[i]]);
+
+				NodeData node = {};
+				node.gridOffset = levelOffsets.back();
+				node.texelSize = cellSize / GridConstants::nodeResolution;
+				node.imageOffset = nodeData.GetNodeInfos()[i].textureOffset;
+				nodeData_.push_back(node);
+			}
+			std::swap(parentOffsets, levelOffsets);
+		}
+
+		const auto& volumeState = GuiPass::GetVolumeState();
+		uint64_t signature = Math::hashSeed;
+		Math::HashCombine(signature, lightDirection);
+		Math::HashCombine(signature, contentSignature);
+		Math::HashCombine(signature, GuiPass::GetParticleState());
+		Math::HashCombine(signature, volumeState.globalValue);
+		Math::HashCombine(signature, volumeState.groundFogValue);
+		Math::HashCombine(signature, volumeState.groundFogHeight);
+		Math::HashCombine(signature, volumeState.groundFogBand);
+		Math::HashCombine(signature, volumeState.groundFogHeightfieldAmplitude);
+		Math::HashCombine(signature, volumeState.groundFogHeightfieldScale);
+		Math::HashCombine(signature, volumeState.groundFogNoiseScale);
+		Math::HashCombine(signature, volumeState.groundFogNoiseVolume);
+		Math::HashCombine(signature, volumeState.smokeValue);
+		Math::HashCombine(signature, volumeState.particleValue);
+		Math::HashCombine(signature, volumeState.shadowRayPerLevel);
+		Math::HashCombine(signature, GuiPass::GetDebugVisState().debugFillingType);
+		Math::HashCombine(signature, lightAtlas_.GetSideLength());
+		for (const auto& node : nodeData_)
+		{
+			Math::HashCombine(signature, node.gridOffset);
+			Math::HashCombine(signature, node.imageOffset);
+		}
+
+		//Disabling only requires a single clear
+		const bool enabledChanged = enabled_ != volumeState.lightTransmittance;
+		enabled_ = volumeState.lightTransmittance;
+		update_ = update_ || enabledChanged || (enabled_ && signature != signature_);
+		signature_ = signature;
+	}
+
+	void LightTransmittance::Freeze(int atlasSideLength)
+	{
+		nodeData_.clear();
+		lightAtlas_.SetSideLength(atlasSideLength);
+		update_ = update_ || enabled_;
+		enabled_ = false;
+		signature_ = 0;
+	}
+
+	bool LightTransmittance::ResizeGpuResources(ImageManager* imageManager, std::vector<ResourceResize>& resourceResizes)
+	{
+		bool resize = false;
+		if (lightAtlas_.ResizeImage(imageManager))
+		{
+			resize = true;
+			update_ = true;
+		}
+
+		const VkDeviceSize newSize = nodeData_.size() * sizeof(NodeData);
+		if (nodeBuffer_.size < newSize)
+		{
+			resize = true;
+			nodeBuffer_.size = newSize;
+		}
+		resourceResizes.push_back(nodeBuffer_);
+		return resize;
+	}
+
+	void LightTransmittance::UpdateGpuResources(BufferManager* bufferManager, int frameIndex)
+	{
+		if (!update_ || !enabled_)
+		{
+			return;
+		}
+		auto dataPtr = bufferManager->Ref_Map(nodeBuffer_.index, frameIndex, BufferManager::BUFFER_GRID_BIT);
+		memcpy(dataPtr, nodeData_.data(), nodeData_.size() * sizeof(NodeData));
+		bufferManager->Ref_Unmap(nodeBuffer_.index, frameIndex, BufferManager::BUFFER_GRID_BIT);
+	}
+
+	void LightTransmittance::Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		if (!update_)
+		{
+			return;
+		}
+		update_ = false;
+
+		//Previous frames might still sample the atlas
+		std::vector<VkMemoryBarrier> barriers(1, { VK_STRUCTURE_TYPE_MEMORY_BARRIER });
+		barriers[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barriers[0].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		Wrapper::PipelineBarrierInfo pipelineBarrierInfo{};
+		pipelineBarrierInfo.src = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		pipelineBarrierInfo.dst = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		pipelineBarrierInfo.AddMemoryBarriers(barriers);
+		Wrapper::AddPipelineBarrier(commandBuffer, pipelineBarrierInfo);
+
+		if (enabled_)
+		{
+			auto& queryPool = Wrapper::QueryPool::GetInstance();
+			queryPool.TimestampStart(commandBuffer, Wrapper::TIMESTAMP_GRID_LIGHT_TRANSMITTANCE, frameIndex);
+
+			vkCmdDispatch(commandBuffer, static_cast<uint32_t>(nodeData_.size()), 1, 1);
+
+			queryPool.TimestampEnd(commandBuffer, Wrapper::TIMESTAMP_GRID_LIGHT_TRANSMITTANCE, frameIndex);
+		}
+		else
+		{
+			//No shadowing inside the medium
+			const VkClearColorValue clearValue = { 1.0f, 1.0f, 1.0f, 1.0f };
+			imageManager->Ref_ClearImage(commandBuffer, lightAtlas_.GetImageIndex(), clearValue);
+		}
+
+		//Raymarching and froxel integration sample the atlas
+		barriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		Wrapper::PipelineBarrierInfo readBarrierInfo{};
+		readBarrierInfo.src = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		readBarrierInfo.dst = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		readBarrierInfo.AddMemoryBarriers(barriers);
+		Wrapper::AddPipelineBarrier(commandBuffer, readBarrierInfo);
+	}
+}
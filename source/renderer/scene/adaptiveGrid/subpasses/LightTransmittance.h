@@ -0,0 +1,85 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+#include <vulkan\vulkan.h>
+
+#include "..\AdaptiveGridData.h"
+#include "..\ImageAtlas.h"
+
+namespace Renderer
+{
+	class GridLevel;
+	class BufferManager;
+	class ImageManager;
+
+	//Transmittance from each texel of the image atlas towards the light, stored in a second atlas
+	//with the same layout. The image atlas is refilled every frame, the light atlas is only
+	//recalculated if the light direction, the media values, the filled content or the grid nodes change
+	class LightTransmittance
+	{
+	public:
+		LightTransmittance();
+		//Resources:
+		//	- R16_SFLOAT 3D image with the same layout as the image atlas
+		//	- Storage buffer with the grid offset and image offset of each node
+		void RequestResources(ImageManager* imageManager, BufferManager* bufferManager, int frameCount);
+		//Collects the nodes of all levels, an update is only required if the signature changed
+		//The content signature changes whenever a producer writes different data into the image atlas
+		void Update(const std::vector<GridLevel>& gridLevels, const glm::vec3& lightDirection, uint64_t contentSignature);
+		//The nodes of a frozen grid are unknown, the atlas keeps its layout and is cleared to one
+		//The transmittance is calculated again with the next Update
+		void Freeze(int atlasSideLength);
+		bool ResizeGpuResources(ImageManager* imageManager, std::vector<ResourceResize>& resourceResizes);
+		void UpdateGpuResources(BufferManager* bufferManager, int frameIndex);
+		//One work group per node if an update is required, if disabled the atlas is cleared to one
+		//The node is swept in slices along the light, only the first slice and the borders march to the grid exit
+		void Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex);
+
+		int GetImageIndex() const { return lightAtlas_.GetImageIndex(); }
+		int GetBufferIndex() const { return nodeBuffer_.index; }
+	private:
+		struct NodeData
+		{
+			glm::vec3 gridOffset;
+			float texelSize;
+			uint32_t imageOffset;
+			int padding1;
+			glm::vec2 padding2;
+		};
+
+		ImageAtlas lightAtlas_;
+		std::vector<NodeData> nodeData_;
+		ResourceResize nodeBuffer_ = { sizeof(NodeData), -1 };
+
+		//Hash of all values the transmittance depends on
+		uint64_t signature_ = 0;
+		bool enabled_ = true;
+		//The content of the atlas is undefined after it has been created
+		bool update_ = true;
+	};
+}
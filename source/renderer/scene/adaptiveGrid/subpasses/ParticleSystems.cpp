@@ -37,6 +37,7 @@ SOFTWARE.
 #include "..\..\..\passResources\ShaderBindingManager.h"
 
 #include "..\..\..\..\scene\Scene.h"
+#include "..\..\..\..\utility\Math.h"
 #include "..\Node.h"
 #include "..\..\..\wrapper\QueryPool.h"
 #include "..\..\..\wrapper\Barrier.h"
@@ -187,6 +188,31 @@ namespace Renderer
 		//}
 	}
 
+	uint64_t ParticleSystems::GetContentSignature() const
+	{
+		uint64_t signature = Math::hashSeed;
+		for (const auto& particle : particles_)
+		{
+			Math::HashCombine(signature, particle);
+		}
+		return signature;
+	}
+
+	void ParticleSystems::AddContentStamps(std::vector<uint64_t>& leafStamps) const
+	{
+		for (const auto& nodeParticles : nodeParticleMapping)
+		{
+			auto& stamp = leafStamps[nodeParticles.first];
+			Math::HashCombine(stamp, cbData_.textureValue);
+			Math::HashCombine(stamp, cbData_.texelSize);
+			for (const auto indexParticle : nodeParticles.second)
+			{
+				Math::HashCombine(stamp, particles_[indexParticle]);
+				Math::HashCombine(stamp, radi_[indexParticle]);
+			}
+		}
+	}
+
 	void ParticleSystems::GridInsertParticleNodes(const glm::vec3& worldOffset, GridLevel* childLevel)
 	{
 		nodeParticleMapping.clear();
@@ -84,10 +84,16 @@ namespace Renderer
 
 		void Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex);
 
+		//Hash of the positions and radii of all particles
+		uint64_t GetContentSignature() const;
+		//Combines the particles overlapping each node and the particle values into the content stamps of the nodes
+		void AddContentStamps(std::vector<uint64_t>& leafStamps) const;
+
 		//Used to expose the scene data when exporting the scene to pbrt
 		const auto& GetParticles() const { return particles_; }
 		const auto& GetRadi() const { return radi_; }
 		const auto& GetWorldOffset() const { return gridOffset_; }
+		const auto& GetNodeParticleMapping() const { return nodeParticleMapping; }
 	private:
 		enum GpuBufferType
 		{
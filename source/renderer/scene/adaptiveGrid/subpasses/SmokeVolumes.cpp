@@ -0,0 +1,497 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SmokeVolumes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <cstring>
+
+#include "..\GridLevel.h"
+#include "..\AdaptiveGridConstants.h"
+
+#include "..\..\..\resources\BufferManager.h"
+#include "..\..\..\resources\ImageManager.h"
+#include "..\..\..\passResources\ShaderBindingManager.h"
+
+#include "..\..\..\..\scene\Scene.h"
+#include "..\..\..\wrapper\QueryPool.h"
+#include "..\..\..\wrapper\Barrier.h"
+#include "..\..\..\..\utility\Math.h"
+
+namespace Renderer
+{
+	namespace
+	{
+		//Atlas memory reserved for the leaf nodes filled with smoke, each one is a complete image in the atlas
+		constexpr size_t leafAtlasBudget = 80 * 1024 * 1024;
+		constexpr int maxLeafNodeCount = static_cast<int>(leafAtlasBudget / GridConstants::imageByteSize);
+
+		//Morton code with reversed bit order, any prefix of cells sorted by it is spread evenly over the grid
+		uint64_t CalcSpreadOrder(const glm::ivec3& cell)
+		{
+			uint64_t order = 0;
+			for (int bit = 0; bit < 21; ++bit)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					order = (order << 1) | ((cell[axis] >> bit) & 1);
+				}
+			}
+			return order;
+		}
+
+		//Every corner of the cell is surrounded by cells completely inside the volume
+		bool IsConstantCell(const glm::ivec3& cell, const glm::ivec3& cornerMin, const glm::ivec3& cornerMax)
+		{
+			return glm::all(glm::greaterThanEqual(cell, cornerMin)) && glm::all(glm::lessThan(cell + 1, cornerMax));
+		}
+	}
+
+	void SmokeVolumes::RequestResources(BufferManager* bufferManager, int frameCount, int atlasImageIndex)
+	{
+		{
+			BufferManager::BufferInfo cbInfo;
+			cbInfo.typeBits = BufferManager::BUFFER_CONSTANT_BIT | BufferManager::BUFFER_SCENE_BIT;
+			cbInfo.pool = BufferManager::MEMORY_CONSTANT;
+			cbInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+			cbInfo.bufferingCount = frameCount;
+			cbInfo.data = &cbData_;
+			cbInfo.size = sizeof(CBData);
+			cbIndex_ = bufferManager->Ref_RequestBuffer(cbInfo);
+		}
+
+		{
+			BufferManager::BufferInfo storageBufferInfo;
+			storageBufferInfo.typeBits = BufferManager::BUFFER_GRID_BIT;
+			storageBufferInfo.pool = BufferManager::MEMORY_GRID;
+			storageBufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			storageBufferInfo.bufferingCount = frameCount;
+			for (int i = 0; i < GPU_MAX; ++i)
+			{
+				//fill with one element, will later be resized properly
+				storageBufferInfo.size = CalcStorageBufferSize(static_cast<GpuBufferType>(i));
+				storageBuffers_[i].index = bufferManager->Ref_RequestBuffer(storageBufferInfo);
+				storageBuffers_[i].size = storageBufferInfo.size;
+			}
+		}
+
+		atlasImageIndex_ = atlasImageIndex;
+	}
+
+	int SmokeVolumes::GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount)
+	{
+		ShaderBindingManager::BindingInfo bindingInfo = {};
+		bindingInfo.pass = SUBPASS_VOLUME_ADAPTIVE_SMOKE;
+		bindingInfo.resourceIndex = { atlasImageIndex_, cbIndex_ };
+		bindingInfo.stages = { VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT };
+		bindingInfo.types = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER };
+		bindingInfo.Ref_image = true;
+		bindingInfo.refactoring_ = { true, true };
+		for (const auto& storageBuffer : storageBuffers_)
+		{
+			bindingInfo.resourceIndex.push_back(storageBuffer.index);
+			bindingInfo.stages.push_back(VK_SHADER_STAGE_COMPUTE_BIT);
+			bindingInfo.types.push_back(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+			bindingInfo.refactoring_.push_back(true);
+		}
+		bindingInfo.setCount = frameCount;
+
+		return bindingManager->RequestShaderBinding(bindingInfo);
+	}
+
+	void SmokeVolumes::OnLoadScene(const Scene* scene, const AxisAlignedBoundingBox& gridBounds, float cellSize)
+	{
+		volumes_.clear();
+		coveredCells_.clear();
+		coarseNodes_.clear();
+		cellVolumeIndices_.clear();
+		++contentVersion_;
+
+		const auto& boundingBoxes = scene->GetBoundingBoxes();
+		const auto& smokeVolumes = scene->GetSmokeVolumes();
+		for (auto it = smokeVolumes.begin(); it != smokeVolumes.end(); ++it)
+		{
+			const int guid = it->first;
+			if (guid >= static_cast<int>(boundingBoxes.size()))
+			{
+				printf("Smoke volume %d has no bounding box\n", guid);
+				continue;
+			}
+			const auto gridBox = Clamp(boundingBoxes[guid], gridBounds.min, gridBounds.max) - gridBounds.min;
+			if (glm::any(glm::greaterThanEqual(gridBox.min, gridBox.max)))
+			{
+				continue;
+			}
+			Volume volume = {};
+			volume.min = gridBox.min;
+			volume.density = smokeVolumes.data()[it->second].density;
+			volume.max = gridBox.max;
+			//Corners inside the range of cells completely covered by the volume, excluding the outer corners
+			volume.cornerMin = glm::ivec3(ceil(gridBox.min / cellSize)) + 1;
+			volume.cornerMax = glm::ivec3(floor(gridBox.max / cellSize));
+			volumes_.push_back(volume);
+		}
+
+		//Each thread collects the cells of a subset of the volumes as pairs of linear cell index and volume index
+		//Cells which are constant for a volume are represented by the parent level and skipped
+		const int cellsPerAxis = static_cast<int>(round((gridBounds.max.x - gridBounds.min.x) / cellSize));
+		const int volumeCount = static_cast<int>(volumes_.size());
+		const int threadCount = std::max(1, std::min(volumeCount, static_cast<int>(std::thread::hardware_concurrency())));
+		std::vector<std::vector<std::pair<int64_t, int>>> threadCells(threadCount);
+
+		std::atomic<int> nextVolume{ 0 };
+		const auto CollectCells = [&](std::vector<std::pair<int64_t, int>>& cells)
+		{
+			for (int i = nextVolume++; i < volumeCount; i = nextVolume++)
+			{
+				const glm::ivec3 minCell = glm::clamp(glm::ivec3(floor(volumes_[i].min / cellSize)), 0, cellsPerAxis - 1);
+				const glm::ivec3 maxCell = glm::clamp(glm::ivec3(ceil(volumes_[i].max / cellSize)), minCell + 1, glm::ivec3(cellsPerAxis));
+				for (int z = minCell.z; z < maxCell.z; ++z)
+				{
+					for (int y = minCell.y; y < maxCell.y; ++y)
+					{
+						for (int x = minCell.x; x < maxCell.x; ++x)
+						{
+							if (IsConstantCell({ x, y, z }, volumes_[i].cornerMin, volumes_[i].cornerMax))
+							{
+								continue;
+							}
+							const int64_t cellIndex = (static_cast<int64_t>(z) * cellsPerAxis + y) * cellsPerAxis + x;
+							cells.push_back({ cellIndex, i });
+						}
+					}
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < threadCount; ++i)
+		{
+			threads.push_back(std::thread(CollectCells, std::ref(threadCells[i])));
+		}
+		CollectCells(threadCells[0]);
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		std::vector<std::pair<int64_t, int>> cells;
+		for (auto& collected : threadCells)
+		{
+			cells.insert(cells.end(), collected.begin(), collected.end());
+		}
+		std::sort(cells.begin(), cells.end());
+
+		const auto ToCell = [cellsPerAxis](int64_t cellIndex)
+		{
+			return glm::ivec3(
+				static_cast<int>(cellIndex % cellsPerAxis),
+				static_cast<int>((cellIndex / cellsPerAxis) % cellsPerAxis),
+				static_cast<int>(cellIndex / (static_cast<int64_t>(cellsPerAxis) * cellsPerAxis)));
+		};
+
+		//Cells exceeding the atlas budget are dropped evenly over the grid instead of cutting off the last rows
+		std::vector<int64_t> keptCells;
+		for (const auto& cell : cells)
+		{
+			if (keptCells.empty() || keptCells.back() != cell.first)
+			{
+				keptCells.push_back(cell.first);
+			}
+		}
+		const int cellCount = static_cast<int>(keptCells.size());
+		if (cellCount > maxLeafNodeCount)
+		{
+			std::vector<std::pair<uint64_t, int64_t>> spreadCells;
+			for (const auto cellIndex : keptCells)
+			{
+				spreadCells.push_back({ CalcSpreadOrder(ToCell(cellIndex)), cellIndex });
+			}
+			std::nth_element(spreadCells.begin(), spreadCells.begin() + maxLeafNodeCount, spreadCells.end());
+			keptCells.clear();
+			for (int i = 0; i < maxLeafNodeCount; ++i)
+			{
+				keptCells.push_back(spreadCells[i].second);
+			}
+			std::sort(keptCells.begin(), keptCells.end());
+			printf("Smoke volumes cover %d leaf nodes but the atlas budget of %d MB only fits %d, "
+				"%d border cells spread over the grid are skipped\n", cellCount,
+				static_cast<int>(leafAtlasBudget / (1024 * 1024)), maxLeafNodeCount, cellCount - maxLeafNodeCount);
+		}
+
+		//Group the volumes of each cell
+		for (size_t i = 0; i < cells.size();)
+		{
+			const int64_t cellIndex = cells[i].first;
+			if (!std::binary_search(keptCells.begin(), keptCells.end(), cellIndex))
+			{
+				while (i < cells.size() && cells[i].first == cellIndex)
+				{
+					++i;
+				}
+				continue;
+			}
+
+			CoveredCell coveredCell;
+			const glm::ivec3 cell = ToCell(cellIndex);
+			coveredCell.gridPos = glm::vec3(cell) * cellSize;
+			coveredCell.volumeOffset = static_cast<int>(cellVolumeIndices_.size());
+			for (; i < cells.size() && cells[i].first == cellIndex; ++i)
+			{
+				cellVolumeIndices_.push_back(cells[i].second);
+			}
+			coveredCell.volumeCount = static_cast<int>(cellVolumeIndices_.size()) - coveredCell.volumeOffset;
+			coveredCells_.push_back(coveredCell);
+		}
+
+		//Parent nodes whose corner texels intersect the constant corners of a volume
+		const int parentCellsPerAxis = std::max(1, cellsPerAxis / GridConstants::nodeResolution);
+		std::vector<std::pair<int, int>> parentNodes;
+		for (int i = 0; i < volumeCount; ++i)
+		{
+			const auto& volume = volumes_[i];
+			if (glm::any(glm::greaterThanEqual(volume.cornerMin, volume.cornerMax)))
+			{
+				continue;
+			}
+			//Node n contains the corners [n * nodeResolution, (n + 1) * nodeResolution]
+			const glm::ivec3 minNode = glm::max((volume.cornerMin + GridConstants::nodeResolution - 1) / GridConstants::nodeResolution - 1, 0);
+			const glm::ivec3 maxNode = glm::min((volume.cornerMax - 1) / GridConstants::nodeResolution, parentCellsPerAxis - 1);
+			for (int z = minNode.z; z <= maxNode.z; ++z)
+			{
+				for (int y = minNode.y; y <= maxNode.y; ++y)
+				{
+					for (int x = minNode.x; x <= maxNode.x; ++x)
+					{
+						parentNodes.push_back({ (z * parentCellsPerAxis + y) * parentCellsPerAxis + x, i });
+					}
+				}
+			}
+		}
+		std::sort(parentNodes.begin(), parentNodes.end());
+
+		const float parentCellSize = cellSize * GridConstants::nodeResolution;
+		for (size_t i = 0; i < parentNodes.size();)
+		{
+			const int nodeIndex = parentNodes[i].first;
+			const glm::ivec3 node = glm::ivec3(nodeIndex % parentCellsPerAxis, 
+				(nodeIndex / parentCellsPerAxis) % parentCellsPerAxis, nodeIndex / (parentCellsPerAxis * parentCellsPerAxis));
+
+			CoveredCell coarseNode;
+			coarseNode.gridPos = glm::vec3(node) * parentCellSize;
+			coarseNode.volumeOffset = static_cast<int>(cellVolumeIndices_.size());
+			for (; i < parentNodes.size() && parentNodes[i].first == nodeIndex; ++i)
+			{
+				cellVolumeIndices_.push_back(parentNodes[i].second);
+			}
+			coarseNode.volumeCount = static_cast<int>(cellVolumeIndices_.size()) - coarseNode.volumeOffset;
+			coarseNodes_.push_back(coarseNode);
+		}
+
+		cbData_.texelSize = cellSize / GridConstants::nodeResolution;
+		printf("Inserted %d smoke volumes into %d leaf nodes and %d coarse nodes\n", volumeCount, 
+			static_cast<int>(coveredCells_.size()), static_cast<int>(coarseNodes_.size()));
+	}
+
+	void SmokeVolumes::GridInsertNodes(GridLevel* parentLevel, GridLevel* leafLevel)
+	{
+		nodeIndices_.clear();
+		coarseNodeIndices_.clear();
+		//Offset into the cell to avoid rounding to the neighbor cell
+		for (const auto& cell : coveredCells_)
+		{
+			nodeIndices_.push_back(leafLevel->AddNode(cell.gridPos + cbData_.texelSize * 0.5f));
+		}
+		for (const auto& node : coarseNodes_)
+		{
+			coarseNodeIndices_.push_back(parentLevel->AddNode(node.gridPos + cbData_.texelSize * 0.5f));
+		}
+	}
+
+	uint64_t SmokeVolumes::GetContentSignature() const
+	{
+		uint64_t signature = Math::hashSeed;
+		Math::HashCombine(signature, contentVersion_);
+		Math::HashCombine(signature, cbData_.textureValue);
+		return signature;
+	}
+
+	void SmokeVolumes::AddContentStamps(std::vector<uint64_t>& parentStamps, std::vector<uint64_t>& leafStamps) const
+	{
+		const uint64_t signature = GetContentSignature();
+		for (const auto indexNode : nodeIndices_)
+		{
+			Math::HashCombine(leafStamps[indexNode], signature);
+		}
+		for (const auto indexNode : coarseNodeIndices_)
+		{
+			Math::HashCombine(parentStamps[indexNode], signature);
+		}
+	}
+
+	void SmokeVolumes::UpdateGpuData(const GridLevel* parentLevel, const GridLevel* leafLevel)
+	{
+		nodeData_.clear();
+		nodeImageIndices_.clear();
+		const auto AddNodes = [&](const std::vector<CoveredCell>& cells, const std::vector<int>& indices, 
+			const GridLevel* level, int coarse)
+		{
+			const auto& nodeInfos = level->GetNodeData().GetNodeInfos();
+			const auto& imageInfos = level->GetNodeData().imageInfos_;
+			for (size_t i = 0; i < cells.size(); ++i)
+			{
+				const auto& cell = cells[i];
+				Node node = {};
+				node.gridOffset = cell.gridPos;
+				node.imageOffset = nodeInfos[indices[i]].textureOffset;
+				node.volumeOffset = cell.volumeOffset;
+				node.volumeCount = cell.volumeCount;
+				node.coarse = coarse;
+				nodeData_.push_back(node);
+				nodeImageIndices_.push_back(imageInfos[indices[i]].imageIndex);
+			}
+		};
+		AddNodes(coveredCells_, nodeIndices_, leafLevel, 0);
+		AddNodes(coarseNodes_, coarseNodeIndices_, parentLevel, 1);
+	}
+
+	void SmokeVolumes::SkipCoarseImages(const std::vector<int>& imageIndices)
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < nodeData_.size(); ++i)
+		{
+			if (nodeData_[i].coarse && std::binary_search(imageIndices.begin(), imageIndices.end(), nodeImageIndices_[i]))
+			{
+				continue;
+			}
+			nodeData_[count] = nodeData_[i];
+			nodeImageIndices_[count] = nodeImageIndices_[i];
+			++count;
+		}
+		nodeData_.resize(count);
+		nodeImageIndices_.resize(count);
+	}
+
+	void SmokeVolumes::UpdateCBData(float scattering, float absorption, float phaseG)
+	{
+		cbData_.textureValue = glm::vec4(scattering, scattering + absorption, phaseG, 0.0f);
+	}
+
+	bool SmokeVolumes::ResizeGpuResources(std::vector<ResourceResize>& resourceResizes)
+	{
+		bool resize = false;
+		for (int i = 0; i < GPU_MAX; ++i)
+		{
+			const auto newSize = CalcStorageBufferSize(static_cast<GpuBufferType>(i));
+			if (storageBuffers_[i].size < newSize)
+			{
+				resize = true;
+				storageBuffers_[i].size = newSize;
+			}
+			resourceResizes.push_back(storageBuffers_[i]);
+		}
+		return resize;
+	}
+
+	void SmokeVolumes::UpdateGpuResources(BufferManager* bufferManager, int frameIndex)
+	{
+		if (nodeData_.empty())
+		{
+			return;
+		}
+
+		const int bufferTypeBits = BufferManager::BUFFER_GRID_BIT;
+		for (int i = 0; i < GPU_MAX; ++i)
+		{
+			const void* source = nullptr;
+			switch (i)
+			{
+			case GPU_STORAGE_VOLUME:
+				source = volumes_.data();
+				break;
+			case GPU_STORAGE_NODE:
+				source = nodeData_.data();
+				break;
+			case GPU_STORAGE_NODE_VOLUME:
+				source = cellVolumeIndices_.data();
+				break;
+			default:
+				printf("Invalid storage buffer index %d while updating\n", i);
+				continue;
+			}
+
+			const int bufferIndex = storageBuffers_[i].index;
+			auto dataPtr = bufferManager->Ref_Map(bufferIndex, frameIndex, bufferTypeBits);
+			memcpy(dataPtr, source, CalcStorageBufferSize(static_cast<GpuBufferType>(i)));
+			bufferManager->Ref_Unmap(bufferIndex, frameIndex, bufferTypeBits);
+		}
+	}
+
+	void SmokeVolumes::Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		const uint32_t dispatchSize = static_cast<uint32_t>(nodeData_.size());
+		if (dispatchSize == 0)
+		{
+			return;
+		}
+
+		auto& queryPool = Wrapper::QueryPool::GetInstance();
+		queryPool.TimestampStart(commandBuffer, Wrapper::TIMESTAMP_GRID_SMOKE, frameIndex);
+
+		vkCmdDispatch(commandBuffer, dispatchSize, 1, 1);
+
+		queryPool.TimestampEnd(commandBuffer, Wrapper::TIMESTAMP_GRID_SMOKE, frameIndex);
+
+		//Particles are written into the same leaf images afterwards
+		ImageManager::BarrierInfo barrierInfo{};
+		barrierInfo.imageIndex = atlasImageIndex_;
+		barrierInfo.type = ImageManager::BARRIER_WRITE_WRITE;
+		auto barriers = imageManager->Barrier({ barrierInfo });
+
+		Wrapper::PipelineBarrierInfo pipelineBarrierInfo{};
+		pipelineBarrierInfo.src = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		pipelineBarrierInfo.dst = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		pipelineBarrierInfo.AddImageBarriers(barriers);
+		Wrapper::AddPipelineBarrier(commandBuffer, pipelineBarrierInfo);
+	}
+
+	VkDeviceSize SmokeVolumes::CalcStorageBufferSize(GpuBufferType bufferType) const
+	{
+		switch (bufferType)
+		{
+		case GPU_STORAGE_VOLUME:
+			return sizeof(Volume) * std::max(volumes_.size(), size_t(1));
+		case GPU_STORAGE_NODE:
+			return sizeof(Node) * std::max(nodeData_.size(), size_t(1));
+		case GPU_STORAGE_NODE_VOLUME:
+			return sizeof(int) * std::max(cellVolumeIndices_.size(), size_t(1));
+		default:
+			printf("Invalid smoke volumes buffer type %d\n", bufferType);
+			return 0;
+		}
+	}
+}
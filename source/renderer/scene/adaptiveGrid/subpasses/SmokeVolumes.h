@@ -0,0 +1,154 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <glm\glm.hpp>
+#include <vulkan\vulkan.h>
+
+#include "..\AdaptiveGridData.h"
+#include "..\..\..\..\scene\components\AABoundingBox.h"
+
+class Scene;
+
+namespace Renderer
+{
+	class GridLevel;
+	class BufferManager;
+	class ImageManager;
+	class ShaderBindingManager;
+
+	//Smoke volumes of the scene file inserted into the two most detailed grid levels
+	//Cells completely inside a volume are represented by the corner texels of the parent level,
+	//only the cells at the volume borders are inserted as leaf nodes which store the remaining detail
+	//The covered nodes are calculated once on scene load because the volumes are static
+	//All nodes are filled with one dispatch, each node stores the range of volumes overlapping it
+	class SmokeVolumes
+	{
+	public:
+		//Resources:
+		//	- Constant buffer with texel size and volumetric data
+		//	- Storage buffer for each volume
+		//	- Storage buffer for each node containing smoke
+		//	- Storage buffer with all volume indices of the nodes
+		void RequestResources(BufferManager* bufferManager, int frameCount, int atlasImageIndex);
+		//Bindings
+		//	- Out: image atlas
+		//	- In: Constant buffer
+		//	- In: Storage buffer - volumes
+		//	- In: Storage buffer - nodes
+		//	- In: Storage buffer - volume indices
+		int GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount);
+
+		//Transforms the volume bounds into grid space and calculates the covered cells of the leaf level
+		//and the parent nodes containing the corners of the cells completely inside a volume
+		void OnLoadScene(const Scene* scene, const AxisAlignedBoundingBox& gridBounds, float cellSize);
+		//Adds the covered border cells as nodes into the leaf level and the coarse nodes into the parent level
+		void GridInsertNodes(GridLevel* parentLevel, GridLevel* leafLevel);
+		//Needs to be called after the image indices of the grid are computed
+		void UpdateGpuData(const GridLevel* parentLevel, const GridLevel* leafLevel);
+		//Incremented whenever the volumes are loaded
+		int GetContentVersion() const { return contentVersion_; }
+		//Hash of the volumes and the smoke values
+		uint64_t GetContentSignature() const;
+		//Combines the smoke values into the content stamps of the leaf and coarse nodes
+		void AddContentStamps(std::vector<uint64_t>& parentStamps, std::vector<uint64_t>& leafStamps) const;
+		//Node indices in the parent level the smoke is added to in the current frame
+		const std::vector<int>& GetCoarseNodeIndices() const { return coarseNodeIndices_; }
+		//Coarse nodes on the sorted image indices still contain the smoke of the last frame and are not filled again
+		void SkipCoarseImages(const std::vector<int>& imageIndices);
+		void UpdateCBData(float scattering, float absorption, float phaseG);
+
+		bool ResizeGpuResources(std::vector<ResourceResize>& resourceResizes);
+		void UpdateGpuResources(BufferManager* bufferManager, int frameIndex);
+
+		void Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex);
+	private:
+		enum GpuBufferType
+		{
+			GPU_STORAGE_VOLUME,
+			GPU_STORAGE_NODE,
+			GPU_STORAGE_NODE_VOLUME,
+			GPU_MAX
+		};
+		struct CBData
+		{
+			glm::vec4 textureValue;
+			float texelSize;
+			glm::vec3 padding;
+		};
+		//Grid space bounds and the range [cornerMin, cornerMax) of leaf cell corners
+		//whose adjacent cells are all completely inside the volume
+		struct Volume
+		{
+			glm::vec3 min;
+			float density;
+			glm::vec3 max;
+			float padding;
+			glm::ivec3 cornerMin;
+			int padding1;
+			glm::ivec3 cornerMax;
+			int padding2;
+		};
+		struct Node
+		{
+			glm::vec3 gridOffset;
+			uint32_t imageOffset;
+			int volumeOffset;
+			int volumeCount;
+			//Node of the parent level, only the constant corner densities are written
+			int coarse;
+			float padding;
+		};
+		//Leaf cell or parent node covered by at least one volume, the volume range indexes cellVolumeIndices_
+		struct CoveredCell
+		{
+			glm::vec3 gridPos;
+			int volumeOffset;
+			int volumeCount;
+		};
+
+		VkDeviceSize CalcStorageBufferSize(GpuBufferType bufferType) const;
+
+		std::vector<Volume> volumes_;
+		std::vector<CoveredCell> coveredCells_;
+		std::vector<CoveredCell> coarseNodes_;
+		std::vector<int> cellVolumeIndices_;
+		//Node index in the leaf level for each covered cell of the current frame
+		std::vector<int> nodeIndices_;
+		//Node index in the parent level for each coarse node of the current frame
+		std::vector<int> coarseNodeIndices_;
+		std::vector<Node> nodeData_;
+		//Atlas image index of each entry in nodeData_
+		std::vector<int> nodeImageIndices_;
+
+		CBData cbData_;
+		int cbIndex_ = -1;
+		std::array<ResourceResize, GPU_MAX> storageBuffers_;
+		int atlasImageIndex_ = -1;
+		int contentVersion_ = 0;
+	};
+}
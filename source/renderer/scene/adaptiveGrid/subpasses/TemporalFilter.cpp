@@ -0,0 +1,135 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "TemporalFilter.h"
+
+#include "..\..\..\resources\ImageManager.h"
+#include "..\..\..\passResources\ShaderBindingManager.h"
+#include "..\..\..\resources\BufferManager.h"
+#include "..\..\..\passes\GuiPass.h"
+#include "..\..\..\wrapper\QueryPool.h"
+#include "..\..\..\wrapper\Barrier.h"
+
+namespace Renderer
+{
+	void TemporalFilter::RequestResources(BufferManager* bufferManager, int frameCount)
+	{
+		BufferManager::BufferInfo cbInfo;
+		cbInfo.typeBits = BufferManager::BUFFER_CONSTANT_BIT | BufferManager::BUFFER_SCENE_BIT;
+		cbInfo.pool = BufferManager::MEMORY_CONSTANT;
+		cbInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		cbInfo.bufferingCount = frameCount;
+		cbInfo.data = &cbData_;
+		cbInfo.size = sizeof(CBData);
+		cbIndex_ = bufferManager->Ref_RequestBuffer(cbInfo);
+	}
+
+	void TemporalFilter::SetImageIndices(int raymarching, int history, int resolved, int depth)
+	{
+		raymarchingImageIndex_ = raymarching;
+		historyImageIndex_ = history;
+		resolvedImageIndex_ = resolved;
+		depthImageIndex_ = depth;
+	}
+
+	int TemporalFilter::GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount)
+	{
+		ShaderBindingManager::BindingInfo bindingInfo = {};
+		bindingInfo.setCount = frameCount;
+		bindingInfo.pass = SUBPASS_VOLUME_ADAPTIVE_TEMPORAL;
+		bindingInfo.resourceIndex = { raymarchingImageIndex_, historyImageIndex_, resolvedImageIndex_,
+			depthImageIndex_, cbIndex_ };
+		bindingInfo.stages = { VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT,
+			VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT };
+		bindingInfo.types = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 
+			VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER };
+		bindingInfo.refactoring_ = { false, false, false, false, true };
+
+		return bindingManager->RequestShaderBinding(bindingInfo);
+	}
+
+	void TemporalFilter::UpdateCB(const glm::mat4& viewProj, const glm::vec2& screenSize, 
+		const glm::vec2& fullScreenSize, int resolutionDivision)
+	{
+		const auto& volumeState = GuiPass::GetVolumeState();
+		const bool sizeChanged = screenSize != prevScreenSize_ || fullScreenSize != prevFullScreenSize_;
+
+		cbData_.viewPortToWorld = glm::inverse(viewProj);
+		cbData_.prevViewProj = prevViewProj_;
+		cbData_.screenSize = screenSize;
+		cbData_.fullScreenSize = fullScreenSize;
+		cbData_.resolutionDivision = resolutionDivision;
+		cbData_.historyValid = volumeState.temporalFiltering && historyValid_ && !sizeChanged ? 1 : 0;
+		cbData_.blendWeight = glm::clamp(volumeState.temporalBlendWeight, 0.01f, 1.0f);
+
+		//Without filtering the resolved image contains the unfiltered results, which are not 
+		//used as history to avoid blending with a single jittered frame
+		historyValid_ = volumeState.temporalFiltering;
+		prevViewProj_ = viewProj;
+		prevScreenSize_ = screenSize;
+		prevFullScreenSize_ = fullScreenSize;
+	}
+
+	void TemporalFilter::Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		//Raymarching results and the history copy of the last frame have to be finished
+		std::vector<VkMemoryBarrier> readBarriers(1, { VK_STRUCTURE_TYPE_MEMORY_BARRIER });
+		readBarriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		readBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		Wrapper::PipelineBarrierInfo readBarrierInfo{};
+		readBarrierInfo.src = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		readBarrierInfo.dst = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		readBarrierInfo.AddMemoryBarriers(readBarriers);
+		Wrapper::AddPipelineBarrier(commandBuffer, readBarrierInfo);
+
+		const uint32_t width = static_cast<uint32_t>(cbData_.screenSize.x);
+		const uint32_t height = static_cast<uint32_t>(cbData_.screenSize.y);
+
+		auto& queryPool = Wrapper::QueryPool::GetInstance();
+		queryPool.TimestampStart(commandBuffer, Wrapper::TIMESTAMP_GRID_TEMPORAL, frameIndex);
+
+		vkCmdDispatch(commandBuffer, (width + 15) / 16, (height + 15) / 16, 1);
+
+		queryPool.TimestampEnd(commandBuffer, Wrapper::TIMESTAMP_GRID_TEMPORAL, frameIndex);
+
+		std::vector<VkMemoryBarrier> copyBarriers(1, { VK_STRUCTURE_TYPE_MEMORY_BARRIER });
+		copyBarriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		copyBarriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		Wrapper::PipelineBarrierInfo copyBarrierInfo{};
+		copyBarrierInfo.src = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		copyBarrierInfo.dst = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		copyBarrierInfo.AddMemoryBarriers(copyBarriers);
+		Wrapper::AddPipelineBarrier(commandBuffer, copyBarrierInfo);
+
+		//Only the used part of the images is copied for reduced resolutions
+		VkImageCopy region = {};
+		region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.extent = { width, height, 1 };
+		vkCmdCopyImage(commandBuffer, 
+			imageManager->GetImage(resolvedImageIndex_), VK_IMAGE_LAYOUT_GENERAL,
+			imageManager->GetImage(historyImageIndex_), VK_IMAGE_LAYOUT_GENERAL,
+			1, &region);
+	}
+}
@@ -0,0 +1,79 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <glm\glm.hpp>
+#include <vulkan\vulkan.h>
+
+namespace Renderer
+{
+	class ShaderBindingManager;
+	class ImageManager;
+	class BufferManager;
+
+	//Accumulates the jittered raymarching results over multiple frames by reprojecting
+	//the resolved result of the previous frame
+	class TemporalFilter
+	{
+	public:
+		//Request the constant buffer with the reprojection matrices
+		void RequestResources(BufferManager* bufferManager, int frameCount);
+		void SetImageIndices(int raymarching, int history, int resolved, int depth);
+		//Bindings:
+		//	- In: Raymarching image, history image, depth image, constant buffer
+		//	- Out: Resolved raymarching image
+		int GetShaderBinding(ShaderBindingManager* bindingManager, int frameCount);
+
+		//The history is invalidated if the filter was disabled or the resolution changed
+		void UpdateCB(const glm::mat4& viewProj, const glm::vec2& screenSize, const glm::vec2& fullScreenSize,
+			int resolutionDivision);
+		//Resolves the raymarching image and copies the result into the history
+		void Dispatch(ImageManager* imageManager, VkCommandBuffer commandBuffer, int frameIndex);
+	private:
+		struct CBData
+		{
+			glm::mat4 viewPortToWorld;
+			glm::mat4 prevViewProj;
+			glm::vec2 screenSize;			//Raymarching resolution
+			glm::vec2 fullScreenSize;
+			int resolutionDivision;
+			int historyValid;
+			float blendWeight;				//Weight of the current frame
+			float padding;
+		};
+		CBData cbData_;
+
+		glm::mat4 prevViewProj_ = glm::mat4(1.0f);
+		glm::vec2 prevScreenSize_ = glm::vec2(0.0f);
+		glm::vec2 prevFullScreenSize_ = glm::vec2(0.0f);
+		bool historyValid_ = false;
+
+		int raymarchingImageIndex_ = -1;
+		int historyImageIndex_ = -1;
+		int resolvedImageIndex_ = -1;
+		int depthImageIndex_ = -1;
+		int cbIndex_ = -1;
+	};
+}
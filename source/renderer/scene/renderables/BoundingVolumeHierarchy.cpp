@@ -0,0 +1,235 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace Renderer
+{
+	namespace
+	{
+		//Enough for any tree built from 32 bit indices with median splits
+		constexpr int maxStackSize = 64;
+	}
+
+	void BoundingVolumeHierarchy::Build(const std::vector<AxisAlignedBoundingBox>& boxes)
+	{
+		boxes_ = boxes;
+		nodes_.clear();
+		indices_.resize(boxes.size());
+		centers_.resize(boxes.size());
+		depth_ = 0;
+		for (size_t i = 0; i < boxes.size(); ++i)
+		{
+			indices_[i] = static_cast<int>(i);
+			centers_[i] = (boxes[i].max + boxes[i].min) * 0.5f;
+		}
+
+		if (!boxes.empty())
+		{
+			nodes_.reserve(2 * (boxes.size() / maxLeafSize + 1));
+			BuildRecursive(0, static_cast<int>(boxes.size()), 1);
+		}
+	}
+
+	void BoundingVolumeHierarchy::Overlap(const AxisAlignedBoundingBox& box, std::vector<int>& indices) const
+	{
+		if (nodes_.empty())
+		{
+			return;
+		}
+
+		const auto overlaps = [&box](const AxisAlignedBoundingBox& other) {
+			return glm::all(glm::lessThanEqual(other.min, box.max)) &&
+				glm::all(glm::greaterThanEqual(other.max, box.min));
+		};
+
+		std::array<int, maxStackSize> stack;
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const int nodeIndex = stack[--stackSize];
+			const auto& node = nodes_[nodeIndex];
+			if (!overlaps(node.bounds))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				for (int i = node.offset; i < node.offset + node.count; ++i)
+				{
+					if (overlaps(boxes_[indices_[i]]))
+					{
+						indices.push_back(indices_[i]);
+					}
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.offset;
+				stack[stackSize++] = nodeIndex + 1;
+			}
+		}
+	}
+
+	void BoundingVolumeHierarchy::InsidePlanes(const glm::vec4* planes, int planeCount, std::vector<int>& indices) const
+	{
+		if (nodes_.empty())
+		{
+			return;
+		}
+
+		//Each entry stores the planes the node still has to be tested against as bit mask
+		//Once a node is completely inside a plane its children skip that plane
+		std::array<std::pair<int, int>, maxStackSize> stack;
+		int stackSize = 0;
+		stack[stackSize++] = { 0, (1 << planeCount) - 1 };
+		while (stackSize > 0)
+		{
+			const auto entry = stack[--stackSize];
+			const auto& node = nodes_[entry.first];
+			int planeMask = entry.second;
+
+			bool outside = false;
+			for (int p = 0; p < planeCount && !outside; ++p)
+			{
+				if ((planeMask & (1 << p)) == 0)
+				{
+					continue;
+				}
+				const auto result = TestPlane(node.bounds, planes[p]);
+				outside = result == PLANE_OUTSIDE;
+				if (result == PLANE_INSIDE)
+				{
+					planeMask &= ~(1 << p);
+				}
+			}
+
+			if (outside)
+			{
+				continue;
+			}
+			if (planeMask == 0)
+			{
+				AddSubtree(entry.first, indices);
+			}
+			else if (node.IsLeaf())
+			{
+				for (int i = node.offset; i < node.offset + node.count; ++i)
+				{
+					bool boxOutside = false;
+					for (int p = 0; p < planeCount && !boxOutside; ++p)
+					{
+						boxOutside = (planeMask & (1 << p)) != 0 &&
+							TestPlane(boxes_[indices_[i]], planes[p]) == PLANE_OUTSIDE;
+					}
+					if (!boxOutside)
+					{
+						indices.push_back(indices_[i]);
+					}
+				}
+			}
+			else
+			{
+				stack[stackSize++] = { node.offset, planeMask };
+				stack[stackSize++] = { entry.first + 1, planeMask };
+			}
+		}
+	}
+
+	int BoundingVolumeHierarchy::BuildRecursive(int begin, int end, int depth)
+	{
+		depth_ = std::max(depth_, depth);
+
+		const int nodeIndex = static_cast<int>(nodes_.size());
+		nodes_.push_back({});
+
+		AxisAlignedBoundingBox bounds = boxes_[indices_[begin]];
+		AxisAlignedBoundingBox centerBounds = { centers_[indices_[begin]], centers_[indices_[begin]] };
+		for (int i = begin + 1; i < end; ++i)
+		{
+			bounds = Union(bounds, boxes_[indices_[i]]);
+			centerBounds.min = glm::min(centerBounds.min, centers_[indices_[i]]);
+			centerBounds.max = glm::max(centerBounds.max, centers_[indices_[i]]);
+		}
+		nodes_[nodeIndex].bounds = bounds;
+
+		const int count = end - begin;
+		if (count <= maxLeafSize)
+		{
+			nodes_[nodeIndex].offset = begin;
+			nodes_[nodeIndex].count = count;
+			return nodeIndex;
+		}
+
+		const glm::vec3 centerExtent = centerBounds.max - centerBounds.min;
+		int axis = 0;
+		if (centerExtent.y > centerExtent[axis]) { axis = 1; }
+		if (centerExtent.z > centerExtent[axis]) { axis = 2; }
+
+		const int middle = begin + count / 2;
+		std::nth_element(indices_.begin() + begin, indices_.begin() + middle, indices_.begin() + end,
+			[this, axis](int a, int b) { return centers_[a][axis] < centers_[b][axis]; });
+
+		BuildRecursive(begin, middle, depth + 1);
+		const int secondChild = BuildRecursive(middle, end, depth + 1);
+		nodes_[nodeIndex].offset = secondChild;
+		nodes_[nodeIndex].count = 0;
+		return nodeIndex;
+	}
+
+	void BoundingVolumeHierarchy::AddSubtree(int nodeIndex, std::vector<int>& indices) const
+	{
+		const auto& node = nodes_[nodeIndex];
+		if (node.IsLeaf())
+		{
+			indices.insert(indices.end(), indices_.begin() + node.offset, indices_.begin() + node.offset + node.count);
+		}
+		else
+		{
+			AddSubtree(nodeIndex + 1, indices);
+			AddSubtree(node.offset, indices);
+		}
+	}
+
+	BoundingVolumeHierarchy::PlaneTest BoundingVolumeHierarchy::TestPlane(
+		const AxisAlignedBoundingBox& box, const glm::vec4& plane)
+	{
+		const glm::vec3 normal = glm::vec3(plane);
+		const glm::vec3 center = (box.max + box.min) * 0.5f;
+		const glm::vec3 extent = (box.max - box.min) * 0.5f;
+		const float distance = glm::dot(normal, center) + plane.w;
+		const float radius = glm::dot(glm::abs(normal), extent);
+		if (distance + radius < 0.0f)
+		{
+			return PLANE_OUTSIDE;
+		}
+		return distance - radius >= 0.0f ? PLANE_INSIDE : PLANE_INTERSECT;
+	}
+}
@@ -0,0 +1,79 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+
+#include "..\..\..\scene\components\AABoundingBox.h"
+
+namespace Renderer
+{
+	//Binary hierarchy over world space bounding boxes, leaves reference the box indices
+	//Nodes are stored depth first so children are always placed after their parent
+	class BoundingVolumeHierarchy
+	{
+	public:
+		static constexpr int maxLeafSize = 4;
+
+		//Builds the hierarchy with median splits along the largest axis of the box centers
+		void Build(const std::vector<AxisAlignedBoundingBox>& boxes);
+
+		//Appends the indices of all boxes overlapping the box
+		void Overlap(const AxisAlignedBoundingBox& box, std::vector<int>& indices) const;
+		//Appends the indices of all boxes which are not completely behind one of the normalized planes
+		void InsidePlanes(const glm::vec4* planes, int planeCount, std::vector<int>& indices) const;
+
+		int GetNodeCount() const { return static_cast<int>(nodes_.size()); }
+		int GetDepth() const { return depth_; }
+	private:
+		struct Node
+		{
+			AxisAlignedBoundingBox bounds;
+			//Leaves store the range in the index list, inner nodes the index of the second child
+			//The first child of an inner node directly follows it
+			int offset;
+			int count;
+			bool IsLeaf() const { return count > 0; }
+		};
+
+		enum PlaneTest
+		{
+			PLANE_OUTSIDE,
+			PLANE_INTERSECT,
+			PLANE_INSIDE
+		};
+
+		int BuildRecursive(int begin, int end, int depth);
+		void AddSubtree(int nodeIndex, std::vector<int>& indices) const;
+		static PlaneTest TestPlane(const AxisAlignedBoundingBox& box, const glm::vec4& plane);
+
+		std::vector<Node> nodes_;
+		std::vector<int> indices_;
+		std::vector<AxisAlignedBoundingBox> boxes_;
+		std::vector<glm::vec3> centers_;
+		int depth_ = 0;
+	};
+}
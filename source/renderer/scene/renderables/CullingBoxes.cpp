@@ -0,0 +1,165 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "CullingBoxes.h"
+
+#include <cmath>
+#include <emmintrin.h>
+
+namespace Renderer
+{
+	namespace
+	{
+		inline __m128 Abs(__m128 value)
+		{
+			return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+		}
+
+		//Sum of the components multiplied with the matrix column entries of one row
+		inline __m128 MultiplyRow(const glm::mat4& matrix, int row, __m128 x, __m128 y, __m128 z)
+		{
+			__m128 result = _mm_mul_ps(_mm_set1_ps(matrix[0][row]), x);
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(matrix[1][row]), y));
+			return _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(matrix[2][row]), z));
+		}
+	}
+
+	void CullingBoxes::SetBoxes(const std::vector<AxisAlignedBoundingBox>& boxes)
+	{
+		Resize(static_cast<int>(boxes.size()));
+		for (size_t i = 0; i < boxes.size(); ++i)
+		{
+			const glm::vec3 center = (boxes[i].max + boxes[i].min) * 0.5f;
+			const glm::vec3 extent = (boxes[i].max - boxes[i].min) * 0.5f;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				components_[CENTER_X + axis][i] = center[axis];
+				components_[EXTENT_X + axis][i] = extent[axis];
+			}
+		}
+	}
+
+	void CullingBoxes::Transform(const glm::mat4& matrix, CullingBoxes& result) const
+	{
+		result.Resize(count_);
+		//The extents are transformed with the absolute values of the matrix
+		const glm::mat4 absMatrix = glm::mat4(glm::abs(matrix[0]), glm::abs(matrix[1]), glm::abs(matrix[2]), matrix[3]);
+		for (size_t i = 0; i < components_[CENTER_X].size(); i += batchSize)
+		{
+			const __m128 centerX = _mm_loadu_ps(&components_[CENTER_X][i]);
+			const __m128 centerY = _mm_loadu_ps(&components_[CENTER_Y][i]);
+			const __m128 centerZ = _mm_loadu_ps(&components_[CENTER_Z][i]);
+			const __m128 extentX = _mm_loadu_ps(&components_[EXTENT_X][i]);
+			const __m128 extentY = _mm_loadu_ps(&components_[EXTENT_Y][i]);
+			const __m128 extentZ = _mm_loadu_ps(&components_[EXTENT_Z][i]);
+
+			for (int row = 0; row < 3; ++row)
+			{
+				const __m128 center = _mm_add_ps(MultiplyRow(matrix, row, centerX, centerY, centerZ),
+					_mm_set1_ps(matrix[3][row]));
+				_mm_storeu_ps(&result.components_[CENTER_X + row][i], center);
+				_mm_storeu_ps(&result.components_[EXTENT_X + row][i], 
+					MultiplyRow(absMatrix, row, extentX, extentY, extentZ));
+			}
+		}
+	}
+
+	void CullingBoxes::Overlap(const AxisAlignedBoundingBox& box, std::vector<int>& indices) const
+	{
+		std::array<__m128, 3> boxMin;
+		std::array<__m128, 3> boxMax;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			boxMin[axis] = _mm_set1_ps(box.min[axis]);
+			boxMax[axis] = _mm_set1_ps(box.max[axis]);
+		}
+
+		for (size_t i = 0; i < components_[CENTER_X].size(); i += batchSize)
+		{
+			__m128 overlap = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const __m128 center = _mm_loadu_ps(&components_[CENTER_X + axis][i]);
+				const __m128 extent = _mm_loadu_ps(&components_[EXTENT_X + axis][i]);
+				overlap = _mm_and_ps(overlap, _mm_cmple_ps(_mm_sub_ps(center, extent), boxMax[axis]));
+				overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_add_ps(center, extent), boxMin[axis]));
+			}
+			AddIndices(static_cast<int>(i), _mm_movemask_ps(overlap), indices);
+		}
+	}
+
+	void CullingBoxes::InsidePlanes(const glm::vec4* planes, int planeCount, std::vector<int>& indices) const
+	{
+		for (size_t i = 0; i < components_[CENTER_X].size(); i += batchSize)
+		{
+			const __m128 centerX = _mm_loadu_ps(&components_[CENTER_X][i]);
+			const __m128 centerY = _mm_loadu_ps(&components_[CENTER_Y][i]);
+			const __m128 centerZ = _mm_loadu_ps(&components_[CENTER_Z][i]);
+			const __m128 extentX = _mm_loadu_ps(&components_[EXTENT_X][i]);
+			const __m128 extentY = _mm_loadu_ps(&components_[EXTENT_Y][i]);
+			const __m128 extentZ = _mm_loadu_ps(&components_[EXTENT_Z][i]);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < planeCount; ++p)
+			{
+				const glm::vec4& plane = planes[p];
+				//Signed distance of the center and the projected radius of the extents onto the normal
+				__m128 distance = _mm_mul_ps(_mm_set1_ps(plane.x), centerX);
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.y), centerY));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), centerZ));
+				distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+
+				__m128 radius = _mm_mul_ps(_mm_set1_ps(std::abs(plane.x)), extentX);
+				radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(std::abs(plane.y)), extentY));
+				radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(std::abs(plane.z)), extentZ));
+
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+			AddIndices(static_cast<int>(i), _mm_movemask_ps(inside), indices);
+		}
+	}
+
+	void CullingBoxes::Resize(int count)
+	{
+		count_ = count;
+		const size_t paddedCount = (count + batchSize - 1) / batchSize * batchSize;
+		for (auto& component : components_)
+		{
+			//Padding boxes are empty and discarded by the index check
+			component.assign(paddedCount, 0.0f);
+		}
+	}
+
+	void CullingBoxes::AddIndices(int firstIndex, int laneMask, std::vector<int>& indices) const
+	{
+		for (int lane = 0; lane < batchSize; ++lane)
+		{
+			const int index = firstIndex + lane;
+			if ((laneMask & (1 << lane)) && index < count_)
+			{
+				indices.push_back(index);
+			}
+		}
+	}
+}
@@ -0,0 +1,71 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <glm\glm.hpp>
+
+#include "..\..\..\scene\components\AABoundingBox.h"
+
+namespace Renderer
+{
+	//Bounding boxes stored as centers and half extents in a structure of arrays layout
+	//All tests process batches of four boxes with SSE instructions
+	class CullingBoxes
+	{
+	public:
+		static constexpr int batchSize = 4;
+
+		void SetBoxes(const std::vector<AxisAlignedBoundingBox>& boxes);
+		//Stores the bounding boxes of all boxes transformed by the affine matrix in the result
+		void Transform(const glm::mat4& matrix, CullingBoxes& result) const;
+		//Appends the indices of all boxes overlapping the box
+		void Overlap(const AxisAlignedBoundingBox& box, std::vector<int>& indices) const;
+		//Appends the indices of all boxes which are not completely behind one of the normalized planes
+		void InsidePlanes(const glm::vec4* planes, int planeCount, std::vector<int>& indices) const;
+
+		int GetCount() const { return count_; }
+	private:
+		enum Component
+		{
+			CENTER_X,
+			CENTER_Y,
+			CENTER_Z,
+			EXTENT_X,
+			EXTENT_Y,
+			EXTENT_Z,
+			COMPONENT_MAX
+		};
+
+		//Resizes the components to a multiple of the batch size
+		void Resize(int count);
+		//Adds the indices of the set bits in the lane mask of the batch starting at the first index
+		void AddIndices(int firstIndex, int laneMask, std::vector<int>& indices) const;
+
+		std::array<std::vector<float>, COMPONENT_MAX> components_;
+		int count_ = 0;
+	};
+}
@@ -51,6 +51,18 @@ namespace Renderer
     }
   }
 
+  void Frustum::Cull(const CullingBoxes& boxes, std::vector<int>& visibleIndices) const
+  {
+    visibleIndices.clear();
+    boxes.InsidePlanes(planes_.data(), PLANE_MAX, visibleIndices);
+  }
+
+  void Frustum::Cull(const BoundingVolumeHierarchy& hierarchy, std::vector<int>& visibleIndices) const
+  {
+    visibleIndices.clear();
+    hierarchy.InsidePlanes(planes_.data(), PLANE_MAX, visibleIndices);
+  }
+
   inline void Frustum::Normalize(glm::vec4& input) const
   {
     float length = glm::length(glm::vec3(input));
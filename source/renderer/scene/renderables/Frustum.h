@@ -28,12 +28,18 @@ SOFTWARE.
 #include <vector>
 #include <glm\glm.hpp>
 
+#include "CullingBoxes.h"
+#include "BoundingVolumeHierarchy.h"
+
 namespace Renderer
 {
   class Frustum
   {
   public:
     void ExtractPlanes(const glm::mat4& matrix);
+    //Writes the indices of all boxes intersecting the frustum, planes and boxes have to be in the same space
+    void Cull(const CullingBoxes& boxes, std::vector<int>& visibleIndices) const;
+    void Cull(const BoundingVolumeHierarchy& hierarchy, std::vector<int>& visibleIndices) const;
 
   private:
     inline void Normalize(glm::vec4& input) const;
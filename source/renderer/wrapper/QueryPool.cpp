@@ -24,6 +24,7 @@ SOFTWARE.
 
 #include "QueryPool.h"
 #include "..\passes\GuiPass.h"
+#include "..\..\utility\Profiler.h"
 
 #include <assert.h>
 
@@ -35,10 +36,33 @@ SOFTWARE.
 #include <time.h>
 #include <stdio.h>
 #include <sstream>
+#include <algorithm>
 
 
 namespace Wrapper
 {
+	namespace
+	{
+		const char* timeStampNames[TIMESTAMP_MAX] =
+		{
+			"Shadow Map",
+			"Mesh",
+			"Grid Global",
+			"Grid GroundFog",
+			"Grid Smoke",
+			"Grid Particles",
+			"Grid Neighbors",
+			"Grid MipMapping 0",
+			"Grid MipMapping 1",
+			"Grid Light Transmittance",
+			"Grid Froxel",
+			"Grid Raymarching",
+			"Grid Temporal",
+			"Postprocess",
+			"Gui"
+		};
+	}
+
 	QueryPool& QueryPool::GetInstance()
 	{
 		static QueryPool queryPool;
@@ -64,6 +88,7 @@ namespace Wrapper
 		timestampPeriod_ = deviceProperties.limits.timestampPeriod;
 
 		cpuFrameStart_.resize(frameCount);
+		cpuRecordStart_.resize(frameCount, -1);
 
 		device_ = device;
 	}
@@ -80,7 +105,7 @@ namespace Wrapper
 	void QueryPool::Reset(VkCommandBuffer commandBuffer, int frameIndex)
 	{
 		const auto& menuState = Renderer::GuiPass::GetMenuState();
-		performTimeStamps_ = menuState.performTimeQueries;
+		performTimeStamps_ = menuState.performTimeQueries || Profiler::IsCapturing();
 
 		//save the start time of the rendering
 		cpuFrameStart_[frameIndex] = std::clock();
@@ -91,6 +116,8 @@ namespace Wrapper
 		}
 
 		SaveQueries(frameIndex);
+		AddProfilerEvents(frameIndex);
+		cpuRecordStart_[frameIndex] = Profiler::Now();
 
 		vkCmdResetQueryPool(commandBuffer, timeQueryPools_[frameIndex], 0, maxQueryCount_);
 	}
@@ -111,13 +138,15 @@ namespace Wrapper
 				break;
 			case TIMESTAMP_GRID_GLOBAL:
 			case TIMESTAMP_GRID_GROUND_FOG:
+			case TIMESTAMP_GRID_SMOKE:
 			case TIMESTAMP_GRID_PARTICLES:
 			case TIMESTAMP_GRID_NEIGHBOR_UPDATE:
 			case TIMESTAMP_GRID_MIPMAPPING_0:
 			case TIMESTAMP_GRID_MIPMAPPING_1:
-			case TIMESTAMP_GRID_MIPMAPPING_MERGIN_0:
-			case TIMESTAMP_GRID_MIPMAPPING_MERGIN_1:
+			case TIMESTAMP_GRID_LIGHT_TRANSMITTANCE:
+			case TIMESTAMP_GRID_FROXEL:
 			case TIMESTAMP_GRID_RAYMARCHING:
+			case TIMESTAMP_GRID_TEMPORAL:
 				flags = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 				break;
 			default:
@@ -144,13 +173,15 @@ namespace Wrapper
 				break;
 			case TIMESTAMP_GRID_GLOBAL:
 			case TIMESTAMP_GRID_GROUND_FOG:
+			case TIMESTAMP_GRID_SMOKE:
 			case TIMESTAMP_GRID_PARTICLES:
 			case TIMESTAMP_GRID_NEIGHBOR_UPDATE:
 			case TIMESTAMP_GRID_MIPMAPPING_0:
 			case TIMESTAMP_GRID_MIPMAPPING_1:
-			case TIMESTAMP_GRID_MIPMAPPING_MERGIN_0:
-			case TIMESTAMP_GRID_MIPMAPPING_MERGIN_1:
+			case TIMESTAMP_GRID_LIGHT_TRANSMITTANCE:
+			case TIMESTAMP_GRID_FROXEL:
 			case TIMESTAMP_GRID_RAYMARCHING:
+			case TIMESTAMP_GRID_TEMPORAL:
 				flags = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 				break;
 			default:
@@ -211,6 +242,45 @@ namespace Wrapper
 		}
 	}
 
+	void QueryPool::AddProfilerEvents(int frameIndex)
+	{
+		if (!Profiler::IsCapturing() || cpuRecordStart_[frameIndex] < 0)
+		{
+			return;
+		}
+
+		//Each query is followed by its availability, timestamps not written in the frame are skipped
+		std::array<uint64_t, TIMESTAMP_MAX * 2 * 2> results{};
+		vkGetQueryPoolResults(device_, timeQueryPools_[frameIndex], 0, maxQueryCount_, sizeof(results), results.data(),
+			sizeof(uint64_t) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		const auto Available = [&](int query) { return results[query * 2 + 1] != 0; };
+		const auto Value = [&](int query) { return results[query * 2]; };
+
+		uint64_t frameStart = UINT64_MAX;
+		for (int i = 0; i < TIMESTAMP_MAX * 2; ++i)
+		{
+			if (Available(i))
+			{
+				frameStart = std::min(frameStart, Value(i));
+			}
+		}
+		//The gpu clock is not calibrated against the cpu, the first timestamp is aligned with the recording start
+		for (int i = 0; i < TIMESTAMP_MAX; ++i)
+		{
+			const int startQuery = i * 2;
+			const int endQuery = startQuery + 1;
+			if (Available(startQuery) && Available(endQuery) && Value(endQuery) >= Value(startQuery))
+			{
+				const auto start = cpuRecordStart_[frameIndex] +
+					static_cast<int64_t>(static_cast<double>(Value(startQuery) - frameStart) * timestampPeriod_);
+				const auto end = cpuRecordStart_[frameIndex] +
+					static_cast<int64_t>(static_cast<double>(Value(endQuery) - frameStart) * timestampPeriod_);
+				Profiler::AddGpuEvent(timeStampNames[i], start, end);
+			}
+		}
+	}
+
 	void QueryPool::SaveFile()
 	{
 		auto t = std::time(nullptr);
@@ -224,8 +294,8 @@ namespace Wrapper
 		file.open(fileName.str());
 		if (file.good())
 		{
-			file << "Shadow Map,Mesh,Grid Global,Grid GroundFog,Grid Particles,Grid Neighbors,Grid MipMapping 0," <<
-				"Grid MipMapping 1,Grid MipMapping Merging 0,Grid MipMapping Merging 1,Grid Raymarching," <<
+			file << "Shadow Map,Mesh,Grid Global,Grid GroundFog,Grid Smoke,Grid Particles,Grid Neighbors,Grid MipMapping 0," <<
+				"Grid MipMapping 1,Grid Light Transmittance,Grid Froxel,Grid Raymarching,Grid Temporal," <<
 				"Grid Postprocess,Grid Gui,GPU total,CPU total,\n";
 			for (int i = 0; i < timeStampMax_; ++i)
 			{
@@ -53,6 +53,8 @@ namespace Wrapper
 		void StartSaving(const int count);
 		void SaveQueries(int frameIndex);
 		void SaveFile();
+		//Places the timestamps of the frame on the profiler timeline during a capture
+		void AddProfilerEvents(int frameIndex);
 
 		std::vector<VkQueryPool> timeQueryPools_;
 		uint32_t maxQueryCount_ = TIMESTAMP_MAX * 2;
@@ -67,6 +69,8 @@ namespace Wrapper
 		std::vector<float> gpuTotalTime_;
 		std::vector<clock_t> cpuFrameStart_;
 		std::vector<float> cpuTotalTime_;
+		//Profiler time at which the command buffer recording of the frame started
+		std::vector<int64_t> cpuRecordStart_;
 
 		//TODO should be removed
 		VkDevice device_ = VK_NULL_HANDLE;
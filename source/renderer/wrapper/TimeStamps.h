@@ -32,13 +32,15 @@ namespace Wrapper
 		TIMESTAMP_MESH,
 		TIMESTAMP_GRID_GLOBAL,
 		TIMESTAMP_GRID_GROUND_FOG,
+		TIMESTAMP_GRID_SMOKE,
 		TIMESTAMP_GRID_PARTICLES,
 		TIMESTAMP_GRID_NEIGHBOR_UPDATE,
 		TIMESTAMP_GRID_MIPMAPPING_0,
 		TIMESTAMP_GRID_MIPMAPPING_1,
-		TIMESTAMP_GRID_MIPMAPPING_MERGIN_0,
-		TIMESTAMP_GRID_MIPMAPPING_MERGIN_1,
+		TIMESTAMP_GRID_LIGHT_TRANSMITTANCE,
+		TIMESTAMP_GRID_FROXEL,
 		TIMESTAMP_GRID_RAYMARCHING,
+		TIMESTAMP_GRID_TEMPORAL,
 		TIMESTAMP_POSTPROCESS,
 		TIMESTAMP_PASS_GUI,
 		TIMESTAMP_MAX
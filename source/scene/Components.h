@@ -37,7 +37,8 @@ enum ComponentType
   COMP_PARTICLE     = 1 << 3,
   COMP_TEXTURE      = 1 << 4,
   COMP_SMOKE        = 1 << 5,
-  COMP_MATERIAL     = 1 << 6
+  COMP_MATERIAL     = 1 << 6,
+  COMP_DENSITY_GRID = 1 << 7
 };
 
 const static std::map<std::string, ComponentType> componentMapping =
@@ -48,7 +49,8 @@ const static std::map<std::string, ComponentType> componentMapping =
   {"particles", COMP_PARTICLE},
   {"texture", COMP_TEXTURE},
   {"smoke", COMP_SMOKE},
-  {"material", COMP_MATERIAL}
+  {"material", COMP_MATERIAL},
+  {"densityGrid", COMP_DENSITY_GRID}
 };
 
 struct ComponentInfo
@@ -64,7 +66,8 @@ const static std::map<ComponentType, ComponentInfo> componentInfo =
   {COMP_PARTICLE, {2}},
   {COMP_TEXTURE, {2}},
   {COMP_SMOKE, {1}},
-  {COMP_MATERIAL, {4}}
+  {COMP_MATERIAL, {4}},
+  {COMP_DENSITY_GRID, {3}}
 };
 
 struct Transform
@@ -112,6 +115,16 @@ struct Smoke
   float density;
 };
 
+//Dense float grid stretched over the bounding box of the object
+struct DensityGrid
+{
+  std::string path;
+  float threshold = 0.0f;		//bricks with a lower maximum density are skipped
+  float absorption = 0.0f;
+  float scattering = 0.0f;
+  float phaseG = 0.0f;
+};
+
 struct DirectionalLight
 {
   glm::vec4 lightVector;
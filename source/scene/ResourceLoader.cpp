@@ -328,6 +328,38 @@ namespace ResourceLoader
     return smoke;
   }
 
+  DensityGrid LoadDensityGrid(const std::string& dir, std::ifstream& file)
+  {
+    DensityGrid densityGrid;
+    int compCount = 0;
+    std::string line;
+    while (compCount < componentInfo.at(COMP_DENSITY_GRID).size && std::getline(file, line))
+    {
+      std::istringstream iss(line);
+      std::string value;
+      iss >> value;
+      if (strcmp(value.c_str(), "path") == 0)
+      {
+        iss >> densityGrid.path;
+        densityGrid.path = dir + densityGrid.path;
+      }
+      else if (strcmp(value.c_str(), "threshold") == 0)
+      {
+        iss >> densityGrid.threshold;
+      }
+      else if (strcmp(value.c_str(), "medium") == 0)
+      {
+        iss >> densityGrid.absorption >> densityGrid.scattering >> densityGrid.phaseG;
+      }
+      else
+      {
+        break;
+      }
+      ++compCount;
+    }
+    return densityGrid;
+  }
+
   MaterialInfo LoadMaterialInfo(const std::string& dir, std::ifstream& file)
   {
     MaterialInfo matInfo;
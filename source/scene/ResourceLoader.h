@@ -37,5 +37,6 @@ namespace ResourceLoader
   ParticleSystemData LoadParticleSystem(std::ifstream& file);
   Texture LoadTexture(const std::string& dir, std::ifstream& file);
   Smoke LoadSmoke(std::ifstream& file);
+  DensityGrid LoadDensityGrid(const std::string& dir, std::ifstream& file);
   MaterialInfo LoadMaterialInfo(const std::string& dir, std::ifstream& file);
 }
\ No newline at end of file
@@ -30,6 +30,7 @@ SOFTWARE.
 
 #include "ResourceLoader.h"
 #include "..\utility\Status.h"
+#include "..\utility\Profiler.h"
 
 using namespace std;
 
@@ -98,6 +99,9 @@ void Scene::Load(const std::string& fileName)
         case COMP_SMOKE:
           smokeVolumes_.push_back(ResourceLoader::LoadSmoke(sceneFile), guid);
           break;
+        case COMP_DENSITY_GRID:
+          densityGrids_.push_back(ResourceLoader::LoadDensityGrid(path, sceneFile), guid);
+          break;
         case COMP_MATERIAL:
         {
           MaterialInfo matInfo = ResourceLoader::LoadMaterialInfo(path, sceneFile);
@@ -139,7 +143,12 @@ void Scene::Load(const std::string& fileName)
 
 void Scene::Update(InputHandler* inputHandler, float deltaTime)
 {
-  camera_.UpdateView(inputHandler, deltaTime);
+  PROFILE_SCOPE("Scene::Update");
+  //Without input handler the camera is controlled externally, e.g. by an input replay
+  if (inputHandler != nullptr)
+  {
+    camera_.UpdateView(inputHandler, deltaTime);
+  }
   uniformGrid_.Update();
 
   const auto viewProj = camera_.GetProj() * camera_.GetView();
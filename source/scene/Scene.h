@@ -57,8 +57,10 @@ public:
   const auto& GetGeometry()const { return sceneGeometry_; }
   const auto& GetTextures() const { return textures_; }
   const auto& GetSmokeVolumes() const { return smokeVolumes_; }
+  const auto& GetDensityGrids() const { return densityGrids_; }
 
   const auto& GetCamera()const { return camera_; }
+  auto& GetCamera() { return camera_; }
 	
   const auto& GetTransforms() const { return transforms_; }
   const auto& GetMaterialInfos() const { return materialInfos_; }
@@ -77,6 +79,7 @@ private:
   std::vector<int> activeObjects_;
   ComponentVector<Mesh> meshes_;
   ComponentVector<Smoke> smokeVolumes_;
+  ComponentVector<DensityGrid> densityGrids_;
   std::map<std::string, Texture> textures_;
   Geometry sceneGeometry_;
 
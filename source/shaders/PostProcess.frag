@@ -24,21 +24,35 @@ SOFTWARE.
 
 #version 450
 
+#include "RaymarchingResolution.comp"
+
 const int DEBUG_SCREEN_DIVISION = 2;
 const bool DEBUG_RETURN_IMAGE_ATLAS = false;
 
 layout(location = 0) out vec4 outColor;
 
 layout(binding = 0, rgba16f) uniform image2D meshRenderingResults;
-layout(binding = 1, r16f) uniform image2D raymarchingResults_;
+layout(binding = 1, rgba16f) uniform image2D raymarchingResults_;
 layout(binding = 2) uniform sampler2DArray noiseTextureArray_;
 
 layout(binding = 3) uniform perFrameData
 {
 	vec4 randomness_;
 	vec2 screenSize_;
+	float nearPlane_;
+	float farPlane_;
+	int resolutionDivision_;
+	float exponentialScale_;
+	int froxelIntegration_;
 };
 
+layout(binding = 4) uniform sampler2D depthImage_;
+//Accumulated in scattering and transmittance of the froxel integration
+layout(binding = 5) uniform sampler3D froxels_;
+
+//Prevents infinite weights for samples with the same depth
+const float DEPTH_WEIGHT_EPSILON = 0.01;
+
 vec4 SampleNoise(ivec2 imageCoord)
 {
 	vec2 texCoord = (imageCoord / screenSize_) + randomness_.xy;
@@ -48,13 +62,63 @@ vec4 SampleNoise(ivec2 imageCoord)
 	return noise;
 }
 
+float LinearDepth(float depth)
+{
+	return nearPlane_ * farPlane_ / (farPlane_ - depth * (farPlane_ - nearPlane_));
+}
+
+//Joint bilateral upsampling of reduced resolution raymarching results
+//The bilinear weights of the 4 closest texels are scaled by their depth similarity to
+//the full resolution depth to avoid halos at geometry edges
+vec4 UpsampleRaymarching(ivec2 imageCoord)
+{
+	if(resolutionDivision_ == 1)
+	{
+		return imageLoad(raymarchingResults_, imageCoord);
+	}
+	
+	const ivec2 raymarchingSize = ivec2(screenSize_) / resolutionDivision_;
+	const vec2 raymarchingPos = (vec2(imageCoord) + 0.5) / float(resolutionDivision_) - 0.5;
+	const ivec2 basePos = ivec2(floor(raymarchingPos));
+	const vec2 bilinear = fract(raymarchingPos);
+	const float pixelDepth = LinearDepth(texelFetch(depthImage_, imageCoord, 0).r);
+	
+	vec4 result = vec4(0.0);
+	float totalWeight = 0.0;
+	for(int y = 0; y < 2; ++y)
+	{
+		for(int x = 0; x < 2; ++x)
+		{
+			const ivec2 texel = clamp(basePos + ivec2(x, y), ivec2(0), raymarchingSize - 1);
+			const vec2 bilinearWeight = mix(1.0 - bilinear, bilinear, vec2(x, y));
+			const ivec2 texelPixel = RaymarchingTexelToPixel(texel, resolutionDivision_, ivec2(screenSize_));
+			const float texelDepth = LinearDepth(texelFetch(depthImage_, texelPixel, 0).r);
+			const float depthWeight = 1.0 / (DEPTH_WEIGHT_EPSILON + abs(pixelDepth - texelDepth) / pixelDepth);
+			
+			const float weight = bilinearWeight.x * bilinearWeight.y * depthWeight;
+			result += imageLoad(raymarchingResults_, texel) * weight;
+			totalWeight += weight;
+		}
+	}
+	return result / max(totalWeight, 0.00001);
+}
+
+//Lookup of the froxel volume at the depth of the geometry, inverse of the exponential slice distribution
+vec4 SampleFroxels(ivec2 imageCoord)
+{
+	const vec2 texCoord = (vec2(imageCoord) + 0.5) / screenSize_;
+	const float linearDepth = LinearDepth(texelFetch(depthImage_, imageCoord, 0).r);
+	const float slice = log(max(linearDepth - nearPlane_, 0.0) + 1.0) / exponentialScale_;
+	return texture(froxels_, vec3(texCoord, clamp(slice, 0.0, 1.0)));
+}
+
 void main()
 {
 	ivec2 imageCoord = ivec2(gl_FragCoord.xy);
 
 	vec4 noise = SampleNoise(imageCoord);
 	vec4 opaqueColor = imageLoad(meshRenderingResults, imageCoord);
-	vec4 raymarchingResults = imageLoad(raymarchingResults_, imageCoord);
+	vec4 raymarchingResults = froxelIntegration_ != 0 ? SampleFroxels(imageCoord) : UpsampleRaymarching(imageCoord);
 	vec3 finalColor = opaqueColor.xyz * raymarchingResults.a + raymarchingResults.xyz;
 	finalColor = pow(finalColor, vec3(1.0 / 2.2));
 	finalColor += noise.rgb / 255.0;
@@ -0,0 +1,176 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//Converts binary volume exports (.vfog, .vpar) into pbrt text files
+//Usage: Export-Converter <input> [output.pbrt]
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+#include "..\fileIO\BinaryExport.h"
+
+namespace
+{
+	//Number of density values read and written at once
+	const size_t densityBatchSize = 1 << 16;
+
+	bool ConvertFogVolume(FileIO::BinaryReader& reader, std::ofstream& file)
+	{
+		FileIO::FogVolumeInfo info;
+		if (!reader.Read(info))
+		{
+			return false;
+		}
+		info.mediumName[sizeof(info.mediumName) - 1] = '\0';
+
+		const auto& s_a = info.absorption;
+		const auto& s_s = info.scattering;
+		file <<
+			"\nAttributeBegin" <<
+			"\nMakeNamedMedium \"" << info.mediumName << "\"" <<
+			"\n\t\"string type\" \"heterogeneous\"" <<
+			"\n\t\"rgb	sigma_a\" [" << s_a << " " << s_a << " " << s_a << "]" <<
+			"\n\t\"rgb sigma_s\" [" << s_s << " " << s_s << " " << s_s << "]" <<
+			"\n\t\"float g\" " << info.phaseG << "" <<
+			"\n\t\"point p0\" [" << info.p0[0] << " " << info.p0[1] << " " << info.p0[2] << "]" <<
+			"\n\t\"point p1\" [" << info.p1[0] << " " << info.p1[1] << " " << info.p1[2] << "]" <<
+			"\n\t\"integer nx\" " << info.nx << "" <<
+			"\n\t\"integer ny\" " << info.ny << "" <<
+			"\n\t\"integer nz\" " << info.nz << "" <<
+
+			"\n\t\"float density\" [\n";
+
+		const size_t elementCount = static_cast<size_t>(info.nx) * info.ny * info.nz;
+		std::vector<float> densities(densityBatchSize);
+		for (size_t start = 0; start < elementCount; start += densityBatchSize)
+		{
+			const size_t count = std::min(densityBatchSize, elementCount - start);
+			if (!reader.Read(densities.data(), count * sizeof(float)))
+			{
+				return false;
+			}
+			for (size_t i = 0; i < count; ++i)
+			{
+				file << densities[i] << " ";
+				if ((start + i) % info.nx == 0)
+				{
+					file << "\n";
+				}
+			}
+		}
+
+		file << "\n]" <<
+			"\nAttributeEnd\n";
+		return true;
+	}
+
+	bool ConvertParticles(FileIO::BinaryReader& reader, std::ofstream& file)
+	{
+		FileIO::ParticlesInfo info;
+		if (!reader.Read(info))
+		{
+			return false;
+		}
+		info.mediumName[sizeof(info.mediumName) - 1] = '\0';
+
+		for (uint32_t i = 0; i < info.count; ++i)
+		{
+			FileIO::ParticleSphere sphere;
+			if (!reader.Read(sphere))
+			{
+				return false;
+			}
+
+			file <<
+				"\nAttributeBegin\n" <<
+				"\n\tMediumInterface \"" << info.mediumName << "\" \"\"" <<
+				"\n\tMaterial \"\"" <<
+				"\n\tTranslate " << sphere.position[0] << " " << sphere.position[1] << " " << sphere.position[2] <<
+				"\n\tShape \"sphere\"" <<
+				"\n\t\t\"float radius\"[" << sphere.radius << "]" <<
+				"\nAttributeEnd";
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printf("Usage: Export-Converter <input> [output.pbrt]\n");
+		return 1;
+	}
+
+	const std::string inputPath = argv[1];
+	std::string outputPath;
+	if (argc > 2)
+	{
+		outputPath = argv[2];
+	}
+	else
+	{
+		const auto extensionStart = inputPath.find_last_of('.');
+		outputPath = inputPath.substr(0, extensionStart) + ".pbrt";
+	}
+
+	FileIO::BinaryReader reader;
+	if (!reader.Open(inputPath))
+	{
+		return 1;
+	}
+
+	std::ofstream file;
+	file.open(outputPath.c_str(), std::ios::out);
+	if (!file)
+	{
+		printf("Unable to open output file %s\n", outputPath.c_str());
+		return 1;
+	}
+
+	bool result = false;
+	switch (reader.GetType())
+	{
+	case FileIO::EXPORT_FOG_VOLUME:
+		result = ConvertFogVolume(reader, file);
+		break;
+	case FileIO::EXPORT_PARTICLES:
+		result = ConvertParticles(reader, file);
+		break;
+	default:
+		break;
+	}
+
+	if (!result)
+	{
+		printf("Export file %s is incomplete\n", inputPath.c_str());
+		return 1;
+	}
+	printf("Converted %s to %s\n", inputPath.c_str(), outputPath.c_str());
+	return 0;
+}
@@ -0,0 +1,165 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "InputRecording.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "..\fileIO\BinaryExport.h"
+#include "..\scene\Scene.h"
+
+InputRecording::Mode InputRecording::mode_ = InputRecording::MODE_NONE;
+InputRecording::FrameInputs InputRecording::frame_ = {};
+bool InputRecording::frameStarted_ = false;
+bool InputRecording::headless_ = false;
+int InputRecording::frameCount_ = 0;
+std::unique_ptr<FileIO::BinaryWriter> InputRecording::writer_;
+std::unique_ptr<FileIO::BinaryReader> InputRecording::reader_;
+std::chrono::high_resolution_clock::time_point InputRecording::replayStart_;
+
+namespace
+{
+	//Recordings of a different build can not be replayed
+	struct RecordingInfo
+	{
+		uint32_t frameSize;
+	};
+}
+
+void InputRecording::StartRecording(const std::string& path)
+{
+	Stop();
+
+	writer_ = std::make_unique<FileIO::BinaryWriter>();
+	if (!writer_->Open(path, FileIO::EXPORT_INPUT_RECORDING))
+	{
+		writer_.reset();
+		return;
+	}
+	writer_->Write(RecordingInfo{ sizeof(FrameInputs) });
+	mode_ = MODE_RECORD;
+	printf("Recording inputs into %s\n", path.c_str());
+}
+
+void InputRecording::StartReplay(const std::string& path, bool headless)
+{
+	Stop();
+
+	reader_ = std::make_unique<FileIO::BinaryReader>();
+	RecordingInfo info = {};
+	if (!reader_->Open(path) || reader_->GetType() != FileIO::EXPORT_INPUT_RECORDING || 
+		!reader_->Read(info) || info.frameSize != sizeof(FrameInputs))
+	{
+		printf("Unable to replay input recording %s\n", path.c_str());
+		reader_.reset();
+		return;
+	}
+	mode_ = MODE_REPLAY;
+	headless_ = headless;
+	replayStart_ = std::chrono::high_resolution_clock::now();
+	printf("Replaying inputs of %s%s\n", path.c_str(), headless ? " headless" : "");
+}
+
+void InputRecording::Stop()
+{
+	if (mode_ == MODE_RECORD)
+	{
+		if (frameStarted_)
+		{
+			writer_->Write(frame_);
+		}
+		writer_->Close();
+		printf("Recorded %d frames\n", frameCount_);
+	}
+	else if (mode_ == MODE_REPLAY)
+	{
+		const std::chrono::duration<double, std::milli> duration = 
+			std::chrono::high_resolution_clock::now() - replayStart_;
+		printf("Replayed %d frames in %.2f ms, %.3f ms per frame\n", frameCount_, duration.count(),
+			duration.count() / std::max(1, frameCount_));
+	}
+
+	writer_.reset();
+	reader_.reset();
+	mode_ = MODE_NONE;
+	frameStarted_ = false;
+	headless_ = false;
+	frameCount_ = 0;
+}
+
+void InputRecording::BeginFrame(Scene* scene, float& deltaTime)
+{
+	if (mode_ == MODE_RECORD)
+	{
+		//The previous frame is complete after its randomness was set
+		if (frameStarted_)
+		{
+			writer_->Write(frame_);
+		}
+		frame_.deltaTime = deltaTime;
+		frameStarted_ = true;
+		frameCount_++;
+	}
+	else if (mode_ == MODE_REPLAY)
+	{
+		if (!reader_->Read(frame_))
+		{
+			Stop();
+			return;
+		}
+		deltaTime = frame_.deltaTime;
+		frameCount_++;
+
+		//Applied before the grid update of this frame, the scene does not move the camera during replay
+		scene->GetCamera().SetView(frame_.cameraPosition, frame_.cameraForward, frame_.cameraRight);
+		Renderer::GuiPass::SetReplayedStates(frame_.volumeState, frame_.lightingState, frame_.particleState);
+	}
+}
+
+void InputRecording::UpdateInputs(Scene* scene)
+{
+	if (mode_ == MODE_RECORD)
+	{
+		const auto& camera = scene->GetCamera();
+		frame_.cameraPosition = camera.GetPosition();
+		frame_.cameraForward = camera.GetForward();
+		frame_.cameraRight = camera.GetRight();
+		frame_.volumeState = Renderer::GuiPass::GetVolumeState();
+		frame_.lightingState = Renderer::GuiPass::GetLightingState();
+		frame_.particleState = Renderer::GuiPass::GetParticleState();
+	}
+}
+
+void InputRecording::UpdateRandomness(glm::vec3& randomness)
+{
+	if (mode_ == MODE_RECORD)
+	{
+		frame_.randomness = randomness;
+	}
+	else if (mode_ == MODE_REPLAY)
+	{
+		randomness = frame_.randomness;
+	}
+}
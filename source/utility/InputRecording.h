@@ -0,0 +1,90 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <chrono>
+#include <glm\glm.hpp>
+
+#include "..\renderer\passes\GuiPass.h"
+
+class Scene;
+
+namespace FileIO
+{
+	class BinaryWriter;
+	class BinaryReader;
+}
+
+//Records the per frame inputs which change the content of the adaptive grid
+//Replaying them reproduces the same grid and raymarching work independent of the frame time
+class InputRecording
+{
+public:
+	static void StartRecording(const std::string& path);
+	//A headless replay skips the presentation to measure the frame times without vsync
+	static void StartReplay(const std::string& path, bool headless);
+	//Finishes the recording or replay, a replay prints its frame times
+	static void Stop();
+	static bool IsReplaying() { return mode_ == MODE_REPLAY; }
+	static bool IsHeadlessReplay() { return mode_ == MODE_REPLAY && headless_; }
+
+	//Called before the scene update, during replay the recorded frame time, camera and gui states are applied
+	static void BeginFrame(Scene* scene, float& deltaTime);
+	//Called after the scene update, stores the camera and the gui states used for the grid of this frame
+	static void UpdateInputs(Scene* scene);
+	//Random values of the frame, stored or overwritten
+	static void UpdateRandomness(glm::vec3& randomness);
+private:
+	enum Mode
+	{
+		MODE_NONE,
+		MODE_RECORD,
+		MODE_REPLAY
+	};
+
+	//Written as a whole for each frame, all members are trivially copyable
+	struct FrameInputs
+	{
+		float deltaTime;
+		glm::vec3 cameraPosition;
+		glm::vec3 cameraForward;
+		glm::vec3 cameraRight;
+		glm::vec3 randomness;
+		Renderer::GuiPass::VolumeState volumeState;
+		Renderer::GuiPass::LightingState lightingState;
+		Renderer::GuiPass::ParticleState particleState;
+	};
+
+	static Mode mode_;
+	static FrameInputs frame_;
+	static bool frameStarted_;
+	static bool headless_;
+	static int frameCount_;
+	static std::unique_ptr<FileIO::BinaryWriter> writer_;
+	static std::unique_ptr<FileIO::BinaryReader> reader_;
+	static std::chrono::high_resolution_clock::time_point replayStart_;
+};
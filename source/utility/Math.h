@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include <glm\glm.hpp>
 #include <array>
+#include <cstdint>
 
 namespace Math
 {
@@ -52,6 +53,19 @@ namespace Math
 		return (z * resolution + y) * resolution + x;
 	}
 
+	constexpr uint64_t hashSeed = 14695981039346656037ull;
+
+	//FNV-1a over the bytes of the value, start with the hash seed
+	template<typename T>
+	void HashCombine(uint64_t& hash, const T& value)
+	{
+		const auto bytes = reinterpret_cast<const uint8_t*>(&value);
+		for (size_t i = 0; i < sizeof(T); ++i)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+	}
+
 	inline glm::ivec3 Index1Dto3D(int index, int resolution)
 	{
 		glm::ivec3 pos;
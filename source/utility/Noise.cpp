@@ -0,0 +1,247 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Noise.h"
+
+#include <glm\gtc\packing.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+
+//The shader noise compiled with glm, compared against Simplex() when a volume is generated
+#define CPU_DEBUG
+namespace ShaderNoise
+{
+	using namespace glm;
+#include "..\shaders\include\SimplexNoise.comp"
+}
+
+namespace
+{
+	glm::vec3 Mod289(const glm::vec3& x)
+	{
+		return x - glm::floor(x * (1.0f / 289.0f)) * 289.0f;
+	}
+
+	glm::vec4 Mod289(const glm::vec4& x)
+	{
+		return x - glm::floor(x * (1.0f / 289.0f)) * 289.0f;
+	}
+
+	glm::vec4 Permute(const glm::vec4& x)
+	{
+		return Mod289(((x * 34.0f) + 1.0f) * x);
+	}
+
+	glm::vec4 TaylorInvSqrt(const glm::vec4& r)
+	{
+		return 1.79284291400159f - 0.85373472095314f * r;
+	}
+
+	int FloorDiv(int a, int b)
+	{
+		return a / b - (a % b < 0 ? 1 : 0);
+	}
+
+	//Maps a corner of the skewed simplex lattice to its representative inside the period
+	//The world space position of corner c is c - sum(c) / 6, it is wrapped by multiples of the period
+	//which are lattice translations of period * (k + sum(k) / 3) in skewed space
+	glm::vec3 WrapLattice(const glm::vec3& corner, int period)
+	{
+		const glm::ivec3 c = glm::ivec3(corner);
+		const int cornerSum = c.x + c.y + c.z;
+		const glm::ivec3 k = glm::ivec3(
+			FloorDiv(6 * c.x - cornerSum, 6 * period),
+			FloorDiv(6 * c.y - cornerSum, 6 * period),
+			FloorDiv(6 * c.z - cornerSum, 6 * period));
+		return glm::vec3(c - period * k - (period / 3) * (k.x + k.y + k.z));
+	}
+
+	//Simplex noise with the permutation of the four corners provided by hashCorners(i, i1, i2)
+	template<typename HashCorners>
+	float SimplexNoise(const glm::vec3& v, HashCorners hashCorners)
+	{
+		const glm::vec2 C = glm::vec2(1.0f / 6.0f, 1.0f / 3.0f);
+		const glm::vec4 D = glm::vec4(0.0f, 0.5f, 1.0f, 2.0f);
+
+		//First corner
+		glm::vec3 i = glm::floor(v + glm::dot(v, glm::vec3(C.y)));
+		const glm::vec3 x0 = v - i + glm::dot(i, glm::vec3(C.x));
+
+		//Other corners
+		const glm::vec3 g = glm::step(glm::vec3(x0.y, x0.z, x0.x), x0);
+		const glm::vec3 l = 1.0f - g;
+		const glm::vec3 lzxy = glm::vec3(l.z, l.x, l.y);
+		const glm::vec3 i1 = glm::min(g, lzxy);
+		const glm::vec3 i2 = glm::max(g, lzxy);
+
+		const glm::vec3 x1 = x0 - i1 + C.x;
+		const glm::vec3 x2 = x0 - i2 + C.y;
+		const glm::vec3 x3 = x0 - D.y;
+
+		const glm::vec4 p = hashCorners(i, i1, i2);
+
+		//Gradients: 7x7 points over a square, mapped onto an octahedron
+		const float n_ = 0.142857142857f;
+		const glm::vec3 ns = n_ * glm::vec3(D.w, D.y, D.z) - glm::vec3(D.x, D.z, D.x);
+
+		const glm::vec4 j = p - 49.0f * glm::floor(p * ns.z * ns.z);
+		const glm::vec4 x_ = glm::floor(j * ns.z);
+		const glm::vec4 y_ = glm::floor(j - 7.0f * x_);
+
+		const glm::vec4 x = x_ * ns.x + ns.y;
+		const glm::vec4 y = y_ * ns.x + ns.y;
+		const glm::vec4 h = 1.0f - glm::abs(x) - glm::abs(y);
+
+		const glm::vec4 b0 = glm::vec4(x.x, x.y, y.x, y.y);
+		const glm::vec4 b1 = glm::vec4(x.z, x.w, y.z, y.w);
+
+		const glm::vec4 s0 = glm::floor(b0) * 2.0f + 1.0f;
+		const glm::vec4 s1 = glm::floor(b1) * 2.0f + 1.0f;
+		const glm::vec4 sh = -glm::step(h, glm::vec4(0.0f));
+
+		const glm::vec4 a0 = glm::vec4(b0.x, b0.z, b0.y, b0.w) + 
+			glm::vec4(s0.x, s0.z, s0.y, s0.w) * glm::vec4(sh.x, sh.x, sh.y, sh.y);
+		const glm::vec4 a1 = glm::vec4(b1.x, b1.z, b1.y, b1.w) + 
+			glm::vec4(s1.x, s1.z, s1.y, s1.w) * glm::vec4(sh.z, sh.z, sh.w, sh.w);
+
+		glm::vec3 p0 = glm::vec3(a0.x, a0.y, h.x);
+		glm::vec3 p1 = glm::vec3(a0.z, a0.w, h.y);
+		glm::vec3 p2 = glm::vec3(a1.x, a1.y, h.z);
+		glm::vec3 p3 = glm::vec3(a1.z, a1.w, h.w);
+
+		//Normalise gradients
+		const glm::vec4 norm = TaylorInvSqrt(glm::vec4(
+			glm::dot(p0, p0), glm::dot(p1, p1), glm::dot(p2, p2), glm::dot(p3, p3)));
+		p0 *= norm.x;
+		p1 *= norm.y;
+		p2 *= norm.z;
+		p3 *= norm.w;
+
+		//Mix final noise value
+		glm::vec4 m = glm::max(0.6f - glm::vec4(
+			glm::dot(x0, x0), glm::dot(x1, x1), glm::dot(x2, x2), glm::dot(x3, x3)), 0.0f);
+		m = m * m;
+		return 42.0f * glm::dot(m * m, glm::vec4(
+			glm::dot(p0, x0), glm::dot(p1, x1), glm::dot(p2, x2), glm::dot(p3, x3)));
+	}
+
+	//Largest difference between Simplex() and the shader noise over a few periods
+	float ShaderDifference(int period)
+	{
+		float difference = 0.0f;
+		for (int z = 0; z < 16; ++z)
+		{
+			for (int y = 0; y < 16; ++y)
+			{
+				for (int x = 0; x < 16; ++x)
+				{
+					//Irregular spacing so that the samples do not fall onto the lattice
+					const glm::vec3 position = (glm::vec3(x, y, z) - 8.0f) * (0.37f * period / 3.0f);
+					difference = std::max(difference,
+						glm::abs(Noise::Simplex(position) - ShaderNoise::snoise(position)));
+				}
+			}
+		}
+		return difference;
+	}
+}
+
+namespace Noise
+{
+	float Simplex(const glm::vec3& v)
+	{
+		//Permutations, the four corners are processed together like in the shader
+		return SimplexNoise(v, [](glm::vec3 i, const glm::vec3& i1, const glm::vec3& i2)
+		{
+			i = Mod289(i);
+			return Permute(Permute(Permute(
+				i.z + glm::vec4(0.0f, i1.z, i2.z, 1.0f)) +
+				i.y + glm::vec4(0.0f, i1.y, i2.y, 1.0f)) +
+				i.x + glm::vec4(0.0f, i1.x, i2.x, 1.0f));
+		});
+	}
+
+	float TileableSimplex(const glm::vec3& v, int period)
+	{
+		assert(period > 0 && period % 3 == 0);
+		//Each corner is wrapped before the permutation, corners which differ by a period get the same gradient
+		return SimplexNoise(v, [period](const glm::vec3& i, const glm::vec3& i1, const glm::vec3& i2)
+		{
+			const glm::vec3 c0 = Mod289(WrapLattice(i, period));
+			const glm::vec3 c1 = Mod289(WrapLattice(i + i1, period));
+			const glm::vec3 c2 = Mod289(WrapLattice(i + i2, period));
+			const glm::vec3 c3 = Mod289(WrapLattice(i + 1.0f, period));
+			return Permute(Permute(Permute(
+				glm::vec4(c0.z, c1.z, c2.z, c3.z)) +
+				glm::vec4(c0.y, c1.y, c2.y, c3.y)) +
+				glm::vec4(c0.x, c1.x, c2.x, c3.x));
+		});
+	}
+
+	void GenerateVolume(std::vector<uint16_t>& data, int resolution, int period)
+	{
+		const float shaderDifference = ShaderDifference(period);
+		if (shaderDifference > 1e-4f)
+		{
+			printf("CPU simplex noise differs from the shader noise by %f\n", shaderDifference);
+		}
+
+		data.resize(static_cast<size_t>(resolution) * resolution * resolution);
+		const float texelSize = static_cast<float>(period) / static_cast<float>(resolution);
+
+		std::atomic<int> nextSlice{ 0 };
+		const auto FillSlices = [&]()
+		{
+			for (int z = nextSlice++; z < resolution; z = nextSlice++)
+			{
+				uint16_t* slice = data.data() + static_cast<size_t>(z) * resolution * resolution;
+				for (int y = 0; y < resolution; ++y)
+				{
+					for (int x = 0; x < resolution; ++x)
+					{
+						//Values are stored at the texel centers to match linear filtering with a repeating sampler
+						const glm::vec3 position = (glm::vec3(x, y, z) + 0.5f) * texelSize;
+						slice[y * resolution + x] = static_cast<uint16_t>(
+							glm::packHalf1x16(TileableSimplex(position, period)));
+					}
+				}
+			}
+		};
+
+		const int threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+		std::vector<std::thread> threads;
+		for (int i = 1; i < threadCount; ++i)
+		{
+			threads.push_back(std::thread(FillSlices));
+		}
+		FillSlices();
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
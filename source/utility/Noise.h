@@ -0,0 +1,43 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <glm\glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Noise
+{
+	//CPU version of snoise() in SimplexNoise.comp, returns values in the range [-1,1]
+	//The operations follow the shader so that both results only differ by float rounding
+	float Simplex(const glm::vec3& v);
+	//Simplex noise which repeats every period along each axis, the lattice corners are wrapped before the permutation
+	//The period has to be a multiple of 3 so that it is a translation of the skewed simplex lattice
+	float TileableSimplex(const glm::vec3& v, int period);
+
+	//Fills resolution^3 half float values with tileable noise over [0, period)^3, z slices are split between threads
+	//Prints a warning if Simplex() does not match the shader noise
+	void GenerateVolume(std::vector<uint16_t>& data, int resolution, int period);
+}
@@ -0,0 +1,157 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Profiler.h"
+
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+
+namespace
+{
+	const auto applicationStart = std::chrono::high_resolution_clock::now();
+	std::mutex threadBufferMutex;
+}
+
+std::atomic<bool> Profiler::capturing_{ false };
+int Profiler::framesLeft_ = 0;
+std::string Profiler::path_;
+std::vector<Profiler::Event> Profiler::gpuEvents_;
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::threadBuffers_;
+
+void Profiler::StartCapture(const std::string& path, int frameCount)
+{
+	if (IsCapturing())
+	{
+		printf("Profile capture already running\n");
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(threadBufferMutex);
+		for (auto& buffer : threadBuffers_)
+		{
+			buffer->count = 0;
+		}
+	}
+	gpuEvents_.clear();
+	path_ = path;
+	framesLeft_ = std::max(frameCount, 1);
+	capturing_.store(true, std::memory_order_relaxed);
+	printf("Started profile capture of %d frames\n", framesLeft_);
+}
+
+void Profiler::BeginFrame()
+{
+	if (IsCapturing())
+	{
+		if (framesLeft_ == 0)
+		{
+			capturing_.store(false, std::memory_order_relaxed);
+			Export();
+		}
+		else
+		{
+			framesLeft_--;
+		}
+	}
+}
+
+int64_t Profiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::high_resolution_clock::now() - applicationStart).count();
+}
+
+void Profiler::AddGpuEvent(const char* name, int64_t start, int64_t end)
+{
+	if (IsCapturing())
+	{
+		gpuEvents_.push_back({ name, start, end });
+	}
+}
+
+void Profiler::AddCpuEvent(const char* name, int64_t start, int64_t end)
+{
+	auto buffer = GetThreadBuffer();
+	buffer->events[buffer->count % ThreadBuffer::capacity] = { name, start, end };
+	buffer->count++;
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (buffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(threadBufferMutex);
+		threadBuffers_.push_back(std::make_unique<ThreadBuffer>());
+		buffer = threadBuffers_.back().get();
+		buffer->events.resize(ThreadBuffer::capacity);
+		buffer->threadIndex = static_cast<int>(threadBuffers_.size());
+	}
+	return buffer;
+}
+
+void Profiler::Export()
+{
+	std::ofstream file(path_, std::ios::out);
+	if (!file)
+	{
+		printf("Unable to write profile capture %s\n", path_.c_str());
+		return;
+	}
+
+	//Chrome trace timestamps are in microseconds, the gpu timeline is shown as its own process
+	const auto WriteEvent = [&](const Event& e, int pid, int tid)
+	{
+		file << ",\n{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": " << pid << ", \"tid\": " << tid <<
+			", \"ts\": " << e.start / 1000.0 << ", \"dur\": " << (e.end - e.start) / 1000.0 << "}";
+	};
+	file << "{\"traceEvents\": [\n";
+	file << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"CPU\"}}";
+	file << ",\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 2, \"args\": {\"name\": \"GPU\"}}";
+
+	int eventCount = 0;
+	{
+		std::lock_guard<std::mutex> lock(threadBufferMutex);
+		for (const auto& buffer : threadBuffers_)
+		{
+			const size_t count = buffer->count < ThreadBuffer::capacity ? buffer->count : ThreadBuffer::capacity;
+			for (size_t i = buffer->count - count; i < buffer->count; ++i)
+			{
+				WriteEvent(buffer->events[i % ThreadBuffer::capacity], 1, buffer->threadIndex);
+			}
+			eventCount += static_cast<int>(count);
+		}
+	}
+	for (const auto& e : gpuEvents_)
+	{
+		WriteEvent(e, 2, 0);
+	}
+	eventCount += static_cast<int>(gpuEvents_.size());
+	file << "\n]}\n";
+
+	printf("Saved profile capture with %d events to %s\n", eventCount, path_.c_str());
+}
@@ -0,0 +1,96 @@
+/*
+MIT License
+
+Copyright(c) 2017 Daniel Suttor
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+//Hierarchical CPU profiler, zones are only recorded during a capture
+//A capture covers a fixed number of frames and is exported as chrome trace json (chrome://tracing)
+class Profiler
+{
+public:
+	//Records the lifetime of the scope, the name has to be a string literal
+	class Scope
+	{
+	public:
+		explicit Scope(const char* name) : name_(name), start_(capturing_.load(std::memory_order_relaxed) ? Now() : -1) {}
+		~Scope()
+		{
+			if (start_ >= 0)
+			{
+				AddCpuEvent(name_, start_, Now());
+			}
+		}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	private:
+		const char* name_;
+		int64_t start_;
+	};
+
+	static void StartCapture(const std::string& path, int frameCount);
+	static bool IsCapturing() { return capturing_.load(std::memory_order_relaxed); }
+	//Called at the start of each frame, exports the capture after the last frame
+	static void BeginFrame();
+
+	//Nanoseconds since the start of the application
+	static int64_t Now();
+	//GPU intervals in nanoseconds on the profiler timeline
+	static void AddGpuEvent(const char* name, int64_t start, int64_t end);
+private:
+	struct Event
+	{
+		const char* name;
+		int64_t start;
+		int64_t end;
+	};
+	//Written only by its own thread, old events are overwritten
+	struct ThreadBuffer
+	{
+		static constexpr size_t capacity = 1 << 14;
+		std::vector<Event> events;
+		size_t count = 0;
+		int threadIndex = 0;
+	};
+
+	static void AddCpuEvent(const char* name, int64_t start, int64_t end);
+	static ThreadBuffer* GetThreadBuffer();
+	static void Export();
+
+	static std::atomic<bool> capturing_;
+	static int framesLeft_;
+	static std::string path_;
+	static std::vector<Event> gpuEvents_;
+	//Buffers stay alive after their thread finished so the events can still be exported
+	static std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers_;
+};
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILER_CONCAT(profileScope_, __LINE__)(name)
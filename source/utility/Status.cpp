@@ -25,6 +25,9 @@ SOFTWARE.
 #include "Status.h"
 
 #include "..\fileIO\FileDialog.h"
+#include "..\fileIO\BinaryExport.h"
+
+#include <cstring>
 
 #include "..\Camera.h"
 #include "..\renderer\scene\adaptiveGrid\subpasses\ParticleSystems.h"
@@ -72,18 +75,30 @@ AttributeEnd
 )";
 	}
 
-	void SaveParticleSphere(std::ofstream& file, const Renderer::Particle& particle, const glm::vec3& worldOffset, float radius, std::string mediumName)
+	//Writes the particle spheres into a binary file which is converted to pbrt text by the export converter
+	//Returns false if the file could not be opened
+	bool SaveParticles(const std::string& filePath, const std::vector<Renderer::Particle>& particles,
+		const std::vector<float>& radi, const glm::vec3& worldOffset, const std::string& mediumName)
 	{
-		const auto pos = particle.position + worldOffset;
+		FileIO::BinaryWriter writer;
+		if (!writer.Open(filePath, FileIO::EXPORT_PARTICLES))
+		{
+			return false;
+		}
 
-		file <<
-			"\nAttributeBegin\n" <<
-			"\n\tMediumInterface \"" << mediumName << "\" \"\"" <<
-			"\n\tMaterial \"\"" <<
-			"\n\tTranslate " << pos.x << " " << -pos.y << " " << pos.z <<
-			"\n\tShape \"sphere\"" <<
-			"\n\t\t\"float radius\"[" << radius << "]" <<
-			"\nAttributeEnd";
+		FileIO::ParticlesInfo info = {};
+		strncpy(info.mediumName, mediumName.c_str(), sizeof(info.mediumName) - 1);
+		info.count = static_cast<uint32_t>(particles.size());
+		writer.Write(info);
+
+		for (size_t i = 0; i < particles.size(); ++i)
+		{
+			const auto pos = particles[i].position + worldOffset;
+			const FileIO::ParticleSphere sphere = { { pos.x, -pos.y, pos.z }, radi[i] };
+			writer.Write(sphere);
+		}
+		writer.Close();
+		return true;
 	}
 
 	void SaveCube(std::ofstream& file, const glm::vec3& translation, const glm::vec3& scale)
@@ -249,9 +264,11 @@ void Status::Save()
 		const auto& radi = particleSystemsPtr_->GetRadi();
 
 		const auto& worldOffset = particleSystemsPtr_->GetWorldOffset();
-		for (size_t i = 0; i < particles.size(); ++i)
+		const auto particlesPath = FileIO::ReplaceExtension(filePath, "particles.vpar");
+		if (SaveParticles(particlesPath, particles, radi, worldOffset, mediumName))
 		{
-			SaveParticleSphere(file, particles[i], worldOffset, radi[i], mediumName);
+			file << "\nInclude \"" << FileIO::ReplaceExtension(fileName, "particles.pbrt") << "\"\n";
+			FileIO::BinaryWriter::PrintConverterCommand(particlesPath, FileIO::ReplaceExtension(filePath, "particles.pbrt"));
 		}
 
 		groundFogStatus_.SaveVolume(file);